@@ -0,0 +1,10 @@
+#!/usr/bin/sh
+
+set -e
+
+mkdir -p bin/bench
+
+srcNotMain=$(find src -name "*.c" ! -name "main.c")
+
+gcc -O2 tests/bench/*.c $srcNotMain -I src/ -pthread -o bin/bench/bench "$@"
+./bin/bench/bench
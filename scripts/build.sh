@@ -2,4 +2,4 @@
 
 mkdir -p bin/parens
 
-gcc src/*.c -I src/ -g -o bin/parens/parens
+gcc src/*.c -I src/ -g -pthread -o bin/parens/parens "$@"
@@ -26,8 +26,20 @@ Ast* CreateCons(Ast* head, Ast* tail, Allocator* allocator) {
     return ast;
 }
 
+Ast* CreateVector(Ast* elements, Token* token, Allocator* allocator) {
+    Ast* ast = AllocatorAlloc(sizeof(Ast), allocator);
+    *ast = (Ast) {
+        .type = AST_VECTOR,
+        .token = token,
+        .as.vector = (AstVector) {
+            .elements = elements,
+        },
+    };
+    return ast;
+}
+
 Ast* CreateSymbolAtom(String s, Token* token, Allocator* allocator) {
-    Object* obj = CreateSymbolObject(s, allocator);
+    Object* obj = InternSymbol(s);
     Value val = MAKE_VALUE_OBJECT(obj);
     Ast* ast = CreateAtom(val, token, allocator);
     return ast;
@@ -48,6 +60,9 @@ void VisitAst(Ast* ast, AstVisitor* visitor, void* ctx) {
         case AST_CONS:
             visitor->VisitCons(ast, ctx);
             break;
+        case AST_VECTOR:
+            visitor->VisitVector(ast, ctx);
+            break;
         default: break;
     }
 }
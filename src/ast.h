@@ -8,6 +8,7 @@
 typedef enum {
     AST_ATOM,
     AST_CONS,
+    AST_VECTOR,
 } AstType;
 
 typedef struct {
@@ -21,6 +22,11 @@ typedef struct {
     Ast* tail;
 } AstCons;
 
+// The elements of a vector literal as a proper list.
+typedef struct {
+    Ast* elements;
+} AstVector;
+
 struct Ast {
     AstType type;
     Token* token;
@@ -28,17 +34,20 @@ struct Ast {
     union {
         AstAtom atom;
         AstCons cons;
+        AstVector vector;
     } as;
 };
 
 Ast* CreateAtom(Value value, Token* token, Allocator* allocator);
 Ast* CreateCons(Ast* head, Ast* tail, Allocator* allocator);
+Ast* CreateVector(Ast* elements, Token* token, Allocator* allocator);
 Ast* CreateStringAtom(String s, Token* token, Allocator* allocator);
 Ast* CreateSymbolAtom(String s, Token* token, Allocator* allocator);
 
 typedef struct {
     void (*VisitAtom)(Ast* ast, void* ctx);
     void (*VisitCons)(Ast* ast, void* ctx);
+    void (*VisitVector)(Ast* ast, void* ctx);
 } AstVisitor;
 
 void VisitAst(Ast* ast, AstVisitor* visitor, void* ctx);
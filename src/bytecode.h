@@ -15,6 +15,7 @@ typedef enum {
     OP_TRUE,
     OP_FALSE,
     OP_F64, // read next 8 bytes
+    OP_I32, // read next 4 bytes
     OP_CONSTANT_16, // read next 2 bytes for the index
     OP_BUILTIN_FN, // read next 1 byte for the built in operator/function
     OP_FUN, // read next 4 bytes for the location
@@ -27,18 +28,62 @@ typedef enum {
     OP_NEGATE,
     OP_FUNCTION_CALL, // pop function definition and args from the stack
     OP_CONS_CELL,
+    OP_LIST, // read next 2 bytes for the number of elements, pop them and then the tail
     OP_JUMP_IF_TRUE, // pop one byte for the condition
     OP_JUMP_IF_FALSE,
     OP_JUMP,
     OP_POP,
     OP_PRINT,
+    OP_CONCAT,
+    OP_HASHMAP, // pop a list of alternating keys and values
+    OP_HASHSET, // pop a list of keys
+    OP_ASSOC,
+    OP_DISSOC,
+    OP_GET,
+    OP_CONTAINS,
+    OP_CONJ,
+    OP_HASHTABLE,
+    OP_PUT,
+    OP_REMOVE,
+    OP_COUNT,
+    OP_VECTOR, // read next 2 bytes for the number of items, pop them
+    OP_NTH,
+    OP_PUSH,
+    OP_SLICE,
+    OP_VEC,
+    OP_TOLIST,
+    OP_F64ARRAY,
+    OP_SUM,
+    OP_MIN,
+    OP_MAX,
+    OP_DOT,
+    OP_LENGTH,
+    OP_FIND,
+    OP_SPLIT,
+    OP_JOIN,
+    OP_OCCURRENCES,
+    OP_COMPARE,
+    OP_RANGE,
+    OP_ITERATE,
+    OP_LINES,
+    OP_TAKE,
+    OP_MAP,
+    OP_FILTER,
+    OP_REDUCE,
     OP_ENUM_COUNT,
 } OpCode;
 
+// The op code that executes a builtin operator, or OP_ENUM_COUNT if there is none.
+OpCode MapOperatorToOpCode(OperatorType operator);
+// The number of arguments that a builtin operator takes.
+size_t GetOperatorArity(OperatorType operator);
+
 // -- Bytecode generator --
 
 typedef struct {
     ByteDa byteCode;
+    // values loaded with OP_CONSTANT_16, allocated on the runtime heap
+    ValueDa constants;
 } ByteCodeGenerateSuccess;
 
 typedef struct {
@@ -54,10 +99,24 @@ typedef struct {
     } as;
 } ByteCodeResult;
 
+/*
+ * The allocator is the runtime heap. Constants that the bytecode refers to,
+ * such as quoted symbols and strings, are copied there, so the AST can be
+ * released as soon as the bytecode has been generated.
+ */
 ByteCodeResult GenerateByteCode(Ast* ast, Allocator* allocator);
 
+/*
+ * Hash-conses quoted data, which is off by default. Constant quoted lists and
+ * strings are then built once, as canonical objects on the constant heap, and
+ * identical ones in a program share an object instead of being built each run.
+ */
+void SetHashConsing(bool enabled);
+
 void PrintByteCodeResult(ByteCodeResult result);
 
 double ReadDoubleFromLittleEndian8(Byte* bytes);
+uint16_t ReadU16FromLittleEndian2(Byte* bytes);
+int32_t ReadI32FromLittleEndian4(Byte* bytes);
 
 #endif
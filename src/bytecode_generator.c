@@ -1,22 +1,32 @@
 #include <stdio.h>
+#include <string.h>
 #include "da.h"
 #include "bytecode.h"
 #include "asserts.h"
 
 // -- Bytecode generator --
 
-ByteDa byteCode = {0};
+_Thread_local ByteDa byteCode = {0};
+_Thread_local ValueDa constants = {0};
+_Thread_local Allocator* constantAllocator = NULL;
+
+// Quoted data is hash-consed per generated program, when enabled.
+_Thread_local bool isHashConsingEnabled = false;
+_Thread_local HashConsTable hashConsTable = {0};
 
 static double doubleDefault = 0;
 #define DOUBLE_SIZE 8
 #define INT_SIZE 4
+#define SHORT_SIZE 2
 
 static void EmitAtom(Ast* ast, void* ctx);
 static void EmitCons(Ast* ast, void* ctx);
+static void EmitVector(Ast* ast, void* ctx);
 
 static AstVisitor emitterVisitor = {
     .VisitAtom = &EmitAtom,
     .VisitCons = &EmitCons,
+    .VisitVector = &EmitVector,
 };
 
 static void EmitAstHelper(Ast* ast, void* ctx) {
@@ -77,50 +87,172 @@ static void EmitU32Bytes(uint32_t n) {
     EmitLittleEndian((Byte*)&n, INT_SIZE);
 }
 
-static void EmitOperator(OperatorType operator, Ast* ast, void* ctx) {
-    switch(operator) {
-        case OPERATOR_ADD:
-            EmitByte(OP_ADD);
-            break;
-        case OPERATOR_SUBTRACT:
-            EmitByte(OP_SUBTRACT);
-            break;
-        case OPERATOR_MULTIPLY:
-            EmitByte(OP_MULTIPLY);
-            break;
-        case OPERATOR_DIVIDE:
-            EmitByte(OP_DIVIDE);
-            break;
-        case OPERATOR_PRINT:
-            EmitByte(OP_PRINT);
-            break;
+static void EmitI32(int32_t n) {
+    EmitByte(OP_I32);
+    EmitU32Bytes((uint32_t)n);
+}
+
+static void EmitU16Bytes(uint16_t n) {
+    EmitLittleEndian((Byte*)&n, SHORT_SIZE);
+}
+
+// Copies the object to the constant heap, so that the constant does not point into the AST.
+static Object* CopyConstantObject(Object* obj, Ast* ast, void* ctx) {
+    switch (obj->type) {
+        case OBJECT_STRING:
+            if (isHashConsingEnabled) {
+                return HashConsString(GetStringChars(obj, NULL), &hashConsTable);
+            }
+            return CreateStringObject(GetStringChars(obj, constantAllocator), constantAllocator);
         default:
-            ReportError("Unsupported operator type", ast, ctx);
-            break;
+            ReportError("Unsupported constant object type", ast, ctx);
+            return NULL;
+    }
+}
+
+// The value must already be on the constant heap.
+static void EmitConstantValue(Value value, Ast* ast, void* ctx) {
+    if (constants.count > UINT16_MAX) {
+        ReportError("Too many constants", ast, ctx);
+        return;
     }
+
+    EmitByte(OP_CONSTANT_16);
+    EmitU16Bytes(constants.count);
+    DA_APPEND(&constants, value);
+}
+
+static void EmitConstant(Object* obj, Ast* ast, void* ctx) {
+    // symbols are interned and already outlive the bytecode
+    Object* constant = obj;
+    if (obj->type != OBJECT_SYMBOL) {
+        constant = CopyConstantObject(obj, ast, ctx);
+        if (constant == NULL) {
+            return;
+        }
+        // the constant table holds a reference for as long as the bytecode lives
+        constant->refCount = 1;
+    }
+
+    EmitConstantValue(MAKE_VALUE_OBJECT(constant), ast, ctx);
+}
+
+OpCode MapOperatorToOpCode(OperatorType operator) {
+    switch(operator) {
+        case OPERATOR_ADD: return OP_ADD;
+        case OPERATOR_SUBTRACT: return OP_SUBTRACT;
+        case OPERATOR_MULTIPLY: return OP_MULTIPLY;
+        case OPERATOR_DIVIDE: return OP_DIVIDE;
+        case OPERATOR_PRINT: return OP_PRINT;
+        case OPERATOR_CONCAT: return OP_CONCAT;
+        case OPERATOR_HASHMAP: return OP_HASHMAP;
+        case OPERATOR_HASHSET: return OP_HASHSET;
+        case OPERATOR_ASSOC: return OP_ASSOC;
+        case OPERATOR_DISSOC: return OP_DISSOC;
+        case OPERATOR_GET: return OP_GET;
+        case OPERATOR_CONTAINS: return OP_CONTAINS;
+        case OPERATOR_CONJ: return OP_CONJ;
+        case OPERATOR_HASHTABLE: return OP_HASHTABLE;
+        case OPERATOR_PUT: return OP_PUT;
+        case OPERATOR_REMOVE: return OP_REMOVE;
+        case OPERATOR_COUNT: return OP_COUNT;
+        case OPERATOR_NTH: return OP_NTH;
+        case OPERATOR_PUSH: return OP_PUSH;
+        case OPERATOR_SLICE: return OP_SLICE;
+        case OPERATOR_VEC: return OP_VEC;
+        case OPERATOR_TOLIST: return OP_TOLIST;
+        case OPERATOR_F64ARRAY: return OP_F64ARRAY;
+        case OPERATOR_SUM: return OP_SUM;
+        case OPERATOR_MIN: return OP_MIN;
+        case OPERATOR_MAX: return OP_MAX;
+        case OPERATOR_DOT: return OP_DOT;
+        case OPERATOR_LENGTH: return OP_LENGTH;
+        case OPERATOR_FIND: return OP_FIND;
+        case OPERATOR_SPLIT: return OP_SPLIT;
+        case OPERATOR_JOIN: return OP_JOIN;
+        case OPERATOR_OCCURRENCES: return OP_OCCURRENCES;
+        case OPERATOR_COMPARE: return OP_COMPARE;
+        case OPERATOR_RANGE: return OP_RANGE;
+        case OPERATOR_ITERATE: return OP_ITERATE;
+        case OPERATOR_LINES: return OP_LINES;
+        case OPERATOR_TAKE: return OP_TAKE;
+        case OPERATOR_MAP: return OP_MAP;
+        case OPERATOR_FILTER: return OP_FILTER;
+        case OPERATOR_REDUCE: return OP_REDUCE;
+        default: return OP_ENUM_COUNT;
+    }
+}
+
+// The number of values that each builtin pops.
+static const uint8_t operatorArities[OPERATOR_ENUM_COUNT] = {
+    [OPERATOR_ADD] = 2, [OPERATOR_SUBTRACT] = 2, [OPERATOR_MULTIPLY] = 2, [OPERATOR_DIVIDE] = 2,
+    [OPERATOR_PRINT] = 1, [OPERATOR_CONCAT] = 2,
+    [OPERATOR_HASHMAP] = 1, [OPERATOR_HASHSET] = 1, [OPERATOR_ASSOC] = 3, [OPERATOR_DISSOC] = 2,
+    [OPERATOR_GET] = 2, [OPERATOR_CONTAINS] = 2, [OPERATOR_CONJ] = 2,
+    [OPERATOR_HASHTABLE] = 0, [OPERATOR_PUT] = 3, [OPERATOR_REMOVE] = 2, [OPERATOR_COUNT] = 1,
+    [OPERATOR_NTH] = 2, [OPERATOR_PUSH] = 2, [OPERATOR_SLICE] = 3, [OPERATOR_VEC] = 1, [OPERATOR_TOLIST] = 1,
+    [OPERATOR_F64ARRAY] = 1, [OPERATOR_SUM] = 1, [OPERATOR_MIN] = 1, [OPERATOR_MAX] = 1, [OPERATOR_DOT] = 2,
+    [OPERATOR_LENGTH] = 1, [OPERATOR_FIND] = 2, [OPERATOR_SPLIT] = 2, [OPERATOR_JOIN] = 2,
+    [OPERATOR_OCCURRENCES] = 2, [OPERATOR_COMPARE] = 2,
+    [OPERATOR_RANGE] = 2, [OPERATOR_ITERATE] = 2, [OPERATOR_LINES] = 1, [OPERATOR_TAKE] = 2,
+    [OPERATOR_MAP] = 2, [OPERATOR_FILTER] = 2, [OPERATOR_REDUCE] = 3,
+};
+
+size_t GetOperatorArity(OperatorType operator) {
+    return operatorArities[operator];
+}
+
+static void EmitOperator(OperatorType operator, Ast* ast, void* ctx) {
+    OpCode op = MapOperatorToOpCode(operator);
+    if (op == OP_ENUM_COUNT) {
+        ReportError("Unsupported operator type", ast, ctx);
+        return;
+    }
+    EmitByte(op);
 }
 
 static void EmitAtom(Ast* ast, void* ctx) {
     Value val = ast->as.atom.value;
-    switch (val.type) {
+    switch (GetValueType(val)) {
         case VALUE_NIL:
             EmitByte(OP_NIL);
             break;
         case VALUE_F64:
-            EmitF64(val.as.f64);
+            EmitF64(ValueAsF64(val));
+            break;
+        case VALUE_I32:
+            EmitI32(ValueAsI32(val));
             break;
         case VALUE_OPERATOR:
             EmitByte(OP_BUILTIN_FN); // indicate that the operator is passed as a value
-            EmitOperator(val.as.operator, ast, ctx);
+            EmitOperator(ValueAsOperator(val), ast, ctx);
             return;
+        case VALUE_OBJECT:
+            // strings evaluate to themselves, but a symbol is only data when quoted
+            if (ValueAsObject(val)->type == OBJECT_SYMBOL && !ast->isQuoted) {
+                ReportError("Unsupported value type", ast, ctx);
+                break;
+            }
+            EmitConstant(ValueAsObject(val), ast, ctx);
+            break;
         default:
             ReportError("Unsupported value type", ast, ctx);
             break;
     }
 }
 
+// Atoms within a quoted list are data, like a quoted atom.
+static void EmitQuotedAtom(Ast* ast, void* ctx) {
+    Value val = ast->as.atom.value;
+    if (GetValueType(val) == VALUE_OBJECT) {
+        EmitConstant(ValueAsObject(val), ast, ctx);
+        return;
+    }
+    EmitAtom(ast, ctx);
+}
+
 static bool IsNilAtom(Ast* ast) {
-    return ast->type == AST_ATOM && ast->as.atom.value.type == VALUE_NIL;
+    return ast->type == AST_ATOM && GetValueType(ast->as.atom.value) == VALUE_NIL;
 }
 
 // Evaluate each list element individually, tail first. Skip the terminating nil.
@@ -148,8 +280,16 @@ static void EmitProperListElements(Ast* ast, void* ctx) {
     }
 }
 
+static size_t CountProperListElements(Ast* ast) {
+    size_t count = 0;
+    for (; ast->type == AST_CONS; ast = ast->as.cons.tail) {
+        count++;
+    }
+    return count;
+}
+
 static void EmitComptimeOperator(Ast* ast, void* ctx) {
-    ComptimeOperatorType op = ast->as.cons.head->as.atom.value.as.comptimeOperator;
+    ComptimeOperatorType op = ValueAsComptimeOperator(ast->as.cons.head->as.atom.value);
     if (op != COMPTIME_OPERATOR_FUN) {
         ReportError("Unsupported comptime operator. Only \"fun\" is supported.", ast, ctx);
         return;
@@ -184,12 +324,12 @@ static bool IsComptimeOperator(Ast* ast) {
         return false;
     }
     Value val = ast->as.atom.value;
-    if (val.type != VALUE_COMPTIME_OPERATOR) {
+    if (GetValueType(val) != VALUE_COMPTIME_OPERATOR) {
         return false;
     }
 
-    return val.as.comptimeOperator > COMPTIME_OPERATOR_NONE
-        && val.as.comptimeOperator < COMPTIME_OPERATOR_ENUM_COUNT;
+    return ValueAsComptimeOperator(val) > COMPTIME_OPERATOR_NONE
+        && ValueAsComptimeOperator(val) < COMPTIME_OPERATOR_ENUM_COUNT;
 }
 
 static void EmitFunctionCall(Ast* ast, void* ctx) {
@@ -207,6 +347,13 @@ static void EmitFunctionCall(Ast* ast, void* ctx) {
 
     bool isBuiltin = byteCode.count >= 2 && byteCode.items[byteCode.count - 2] == OP_BUILTIN_FN;
     if (isBuiltin) {
+        // builtins pop a fixed number of values, so other argument counts would leave the stack unbalanced
+        OperatorType operator = ValueAsOperator(head->as.atom.value);
+        if (CountProperListElements(ast->as.cons.tail) != GetOperatorArity(operator)) {
+            ReportError("Wrong number of arguments to a builtin", ast, ctx);
+            return;
+        }
+
         /*
          * Instead of pushing the operator/builtin to the stack, call it directly.
          * For example the atom + is emitted as OP_BUILTIN_FN OP_ADD
@@ -221,52 +368,178 @@ static void EmitFunctionCall(Ast* ast, void* ctx) {
     }
 }
 
+/*
+ * A quoted list is emitted as its tail followed by its elements in order, so that
+ * the VM can build the list as one block from the top of the stack. Lists with
+ * more than UINT16_MAX elements are built as several blocks.
+ */
 static void EmitConsCell(Ast* ast, void* ctx) {
     if (ast->type == AST_ATOM) {
-        EmitAstHelper(ast, ctx);
+        EmitQuotedAtom(ast, ctx);
+        return;
+    } else if (ast->type == AST_VECTOR) {
+        EmitVector(ast, ctx);
         return;
     }
 
     ByteCodeResult* result = (ByteCodeResult*)ctx;
-    AstCons cons = ast->as.cons;
-    Ast* tail = cons.tail;
-    Ast* head = cons.head;
 
-    EmitConsCell(tail, result);
-    if (result->type == RESULT_ERROR) {
-        return;
+    uint16_t count = 0;
+    Ast* rest = ast;
+    while (rest->type == AST_CONS && count < UINT16_MAX) {
+        rest = rest->as.cons.tail;
+        count++;
     }
 
-    EmitAstHelper(head, result);
+    EmitConsCell(rest, result);
     if (result->type == RESULT_ERROR) {
         return;
     }
 
-    EmitByte(OP_CONS_CELL);
+    for (Ast* current = ast; current != rest; current = current->as.cons.tail) {
+        Ast* head = current->as.cons.head;
+        if (head->type == AST_ATOM) {
+            EmitQuotedAtom(head, result);
+        } else {
+            EmitAstHelper(head, result);
+        }
+        if (result->type == RESULT_ERROR) {
+            return;
+        }
+    }
+
+    EmitByte(OP_LIST);
+    EmitU16Bytes(count);
+}
+
+/*
+ * Builds the canonical value of quoted data on the constant heap. Fails for data
+ * that is not built the same way as EmitConsCell would, so that hash-consing
+ * does not change what a program means.
+ */
+static bool TryHashConsQuoted(Ast* ast, Value* result) {
+    // vectors are mutable, so they are never shared
+    if (ast->type == AST_VECTOR) {
+        return false;
+    }
+
+    if (ast->type == AST_ATOM) {
+        Value value = ast->as.atom.value;
+        switch (GetValueType(value)) {
+            case VALUE_NIL:
+            case VALUE_F64:
+            case VALUE_I32:
+            case VALUE_BOOL:
+                *result = value;
+                return true;
+            case VALUE_OBJECT: {
+                Object* obj = ValueAsObject(value);
+                if (obj->type == OBJECT_STRING) {
+                    obj = HashConsString(GetStringChars(obj, NULL), &hashConsTable);
+                }
+                *result = MAKE_VALUE_OBJECT(obj);
+                return true;
+            }
+            // operators are emitted as instructions instead
+            default:
+                return false;
+        }
+    }
+
+    ValueDa items = DA_MAKE_DEFAULT(Value);
+    Ast* current = ast;
+    bool isConstant = true;
+    for (; current->type == AST_CONS && isConstant; current = current->as.cons.tail) {
+        Value item = {0};
+        // nested lists are evaluated
+        isConstant = current->as.cons.head->type == AST_ATOM && TryHashConsQuoted(current->as.cons.head, &item);
+        DA_APPEND(&items, item);
+    }
+
+    Value tail = {0};
+    isConstant = isConstant && TryHashConsQuoted(current, &tail);
+    if (isConstant) {
+        *result = MAKE_VALUE_OBJECT(HashConsList(items.items, items.count, tail, &hashConsTable));
+    }
+
+    DA_FREE(&items);
+    return isConstant;
 }
 
 static void EmitCons(Ast* ast, void* ctx) {
-    if (ast->isQuoted) {
+    Value canonical = {0};
+    if (ast->isQuoted && isHashConsingEnabled && TryHashConsQuoted(ast, &canonical)) {
+        EmitConstantValue(canonical, ast, ctx);
+    } else if (ast->isQuoted) {
         EmitConsCell(ast, ctx);
     } else {
         EmitFunctionCall(ast, ctx);
     }
 }
 
+/*
+ * A vector literal is emitted as its elements in order, followed by the number
+ * of elements, so that the VM can copy them from the top of the stack at once.
+ * The elements of a quoted vector are data, like the elements of a quoted list.
+ */
+static void EmitVector(Ast* ast, void* ctx) {
+    ByteCodeResult* result = (ByteCodeResult*)ctx;
+
+    size_t count = 0;
+    Ast* current = ast->as.vector.elements;
+    for (; current->type == AST_CONS; current = current->as.cons.tail) {
+        Ast* element = current->as.cons.head;
+        if (ast->isQuoted && element->type == AST_ATOM) {
+            EmitQuotedAtom(element, result);
+        } else if (ast->isQuoted && element->type == AST_CONS) {
+            EmitConsCell(element, result);
+        } else {
+            EmitAstHelper(element, result);
+        }
+        if (result->type == RESULT_ERROR) {
+            return;
+        }
+        count++;
+    }
+
+    if (count > UINT16_MAX) {
+        ReportError("Too many elements in the vector literal", ast, ctx);
+        return;
+    }
+
+    EmitByte(OP_VECTOR);
+    EmitU16Bytes(count);
+}
+
 static ByteCodeResult EmitAst(Ast* ast) {
     ByteCodeResult result = {0};
     EmitAstHelper(ast, &result);
 
     if (result.type == RESULT_SUCCESS) {
         result.as.success.byteCode = byteCode;
+        result.as.success.constants = constants;
     }
     return result;
 }
 
 ByteCodeResult GenerateByteCode(Ast* ast, Allocator* allocator) {
-    // TODO(memory): allocator is ignored for now
     byteCode = DA_MAKE_CAPACITY(Byte, 1337);
-    return EmitAst(ast);
+    constants = DA_MAKE_DEFAULT(Value);
+    constantAllocator = allocator;
+    if (isHashConsingEnabled) {
+        hashConsTable = CreateHashConsTable(allocator);
+    }
+
+    ByteCodeResult result = EmitAst(ast);
+
+    if (isHashConsingEnabled) {
+        FreeHashConsTable(&hashConsTable);
+    }
+    return result;
+}
+
+void SetHashConsing(bool enabled) {
+    isHashConsingEnabled = enabled;
 }
 
 
@@ -274,11 +547,25 @@ double ReadDoubleFromLittleEndian8(Byte* bytes) {
     // TODO(portability): add proper conversion
     Assert(DOUBLE_SIZE == sizeof(double) && IsLittleEndian(),
            "Unable to read double with evil pointer magic");
-    double d = *((double*)bytes);
+    // the operand is not aligned within the bytecode, so copy it out
+    double d = 0;
+    memcpy(&d, bytes, sizeof(double));
 
     return d;
 }
 
+uint16_t ReadU16FromLittleEndian2(Byte* bytes) {
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+int32_t ReadI32FromLittleEndian4(Byte* bytes) {
+    uint32_t n = (uint32_t)bytes[0]
+        | ((uint32_t)bytes[1] << 8)
+        | ((uint32_t)bytes[2] << 16)
+        | ((uint32_t)bytes[3] << 24);
+    return (int32_t)n;
+}
+
 // -- Printing --
 
 static bool IsOpCode(OpCode op) {
@@ -290,6 +577,7 @@ static const char* MapOpCodeToStr(OpCode op) {
         case OP_TRUE: return "OP_TRUE";
         case OP_FALSE: return "OP_FALSE";
         case OP_F64: return "OP_F64";
+        case OP_I32: return "OP_I32";
         case OP_CONSTANT_16: return "OP_CONSTANT_16";
         case OP_BUILTIN_FN: return "OP_BUILTIN_FN";
         case OP_ADD: return "OP_ADD";
@@ -299,11 +587,48 @@ static const char* MapOpCodeToStr(OpCode op) {
         case OP_NEGATE: return "OP_NEGATE";
         case OP_FUNCTION_CALL: return "OP_FUNCTION_CALL";
         case OP_CONS_CELL: return "OP_CONS_CELL";
+        case OP_LIST: return "OP_LIST";
         case OP_JUMP_IF_TRUE: return "OP_JUMP_IF_TRUE";
         case OP_JUMP_IF_FALSE: return "OP_JUMP_IF_FALSE";
         case OP_JUMP: return "OP_JUMP";
         case OP_POP: return "OP_POP";
         case OP_PRINT: return "OP_PRINT";
+        case OP_CONCAT: return "OP_CONCAT";
+        case OP_HASHMAP: return "OP_HASHMAP";
+        case OP_HASHSET: return "OP_HASHSET";
+        case OP_ASSOC: return "OP_ASSOC";
+        case OP_DISSOC: return "OP_DISSOC";
+        case OP_GET: return "OP_GET";
+        case OP_CONTAINS: return "OP_CONTAINS";
+        case OP_CONJ: return "OP_CONJ";
+        case OP_HASHTABLE: return "OP_HASHTABLE";
+        case OP_PUT: return "OP_PUT";
+        case OP_REMOVE: return "OP_REMOVE";
+        case OP_COUNT: return "OP_COUNT";
+        case OP_VECTOR: return "OP_VECTOR";
+        case OP_NTH: return "OP_NTH";
+        case OP_PUSH: return "OP_PUSH";
+        case OP_SLICE: return "OP_SLICE";
+        case OP_VEC: return "OP_VEC";
+        case OP_TOLIST: return "OP_TOLIST";
+        case OP_F64ARRAY: return "OP_F64ARRAY";
+        case OP_SUM: return "OP_SUM";
+        case OP_MIN: return "OP_MIN";
+        case OP_MAX: return "OP_MAX";
+        case OP_DOT: return "OP_DOT";
+        case OP_LENGTH: return "OP_LENGTH";
+        case OP_FIND: return "OP_FIND";
+        case OP_SPLIT: return "OP_SPLIT";
+        case OP_JOIN: return "OP_JOIN";
+        case OP_OCCURRENCES: return "OP_OCCURRENCES";
+        case OP_COMPARE: return "OP_COMPARE";
+        case OP_RANGE: return "OP_RANGE";
+        case OP_ITERATE: return "OP_ITERATE";
+        case OP_LINES: return "OP_LINES";
+        case OP_TAKE: return "OP_TAKE";
+        case OP_MAP: return "OP_MAP";
+        case OP_FILTER: return "OP_FILTER";
+        case OP_REDUCE: return "OP_REDUCE";
         case OP_FUN: return "OP_FUN";
         default: break;
     }
@@ -330,6 +655,34 @@ size_t DisasOp(Byte* bytes, size_t line) {
             offset += DOUBLE_SIZE;
             break;
         }
+        case OP_I32: {
+            int32_t n = ReadI32FromLittleEndian4(&bytes[offset + 1]);
+
+            printf("%s: %d\n", MapOpCodeToStr(op), n);
+            offset++;
+
+            for (int i = 0; i < INT_SIZE; i++) {
+                printf("%3ld: %d\n", line++, bytes[offset + i]);
+            }
+
+            offset += INT_SIZE;
+            break;
+        }
+        case OP_CONSTANT_16:
+        case OP_LIST:
+        case OP_VECTOR: {
+            uint16_t n = ReadU16FromLittleEndian2(&bytes[offset + 1]);
+
+            printf("%s: %d\n", MapOpCodeToStr(op), n);
+            offset++;
+
+            for (int i = 0; i < SHORT_SIZE; i++) {
+                printf("%3ld: %d\n", line++, bytes[offset + i]);
+            }
+
+            offset += SHORT_SIZE;
+            break;
+        }
         default: {
             if (IsOpCode(op)) {
                 printf("%s\n", MapOpCodeToStr(op));
@@ -8,6 +8,18 @@ bool StringEquals(String s1, String s2) {
         && (s1.start == s2.start || memcmp(s1.start, s2.start, s1.length) == 0);
 }
 
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+uint32_t HashString(String s) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < s.length; i++) {
+        hash ^= (uint8_t)s.start[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
 String MakeString(const char* str) {
     String s = {
         .start = str,
@@ -55,6 +67,22 @@ double ParseStringAsDouble(String str) {
     return num;
 }
 
+bool TryParseStringAsI32(String str, int32_t* result) {
+    int64_t num = 0;
+    for (size_t i = 0; i < str.length; i++) {
+        if (!IsDigit(str.start[i])) {
+            return false;
+        }
+        num = num * 10 + ToDigit(str.start[i]);
+        if (num > INT32_MAX) {
+            return false;
+        }
+    }
+
+    *result = (int32_t)num;
+    return str.length > 0;
+}
+
 void PrintString(String s) {
     fwrite(s.start, 1, s.length, stdout);
 }
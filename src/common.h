@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef struct {
     const char* start;
@@ -10,8 +11,12 @@ typedef struct {
 } String;
 
 bool StringEquals(String s1, String s2);
+// 32 bit FNV-1a hash of the string contents.
+uint32_t HashString(String s);
 String MakeString(const char* str);
 double ParseStringAsDouble(String str);
+// Parses a string of digits. Fails if the number does not fit in an int32_t.
+bool TryParseStringAsI32(String str, int32_t* result);
 
 void PrintString(String s);
 void PrintStringErr(String s);
@@ -0,0 +1,347 @@
+#include "f64array.h"
+#include "asserts.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define F64_ARRAY_HAS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+typedef void (*F64BinaryKernel)(const double* first, const double* second, double* result, size_t count);
+typedef void (*F64ArrayScalarKernel)(const double* first, double second, double* result, size_t count);
+typedef void (*F64ScalarArrayKernel)(double first, const double* second, double* result, size_t count);
+typedef double (*F64ReduceKernel)(const double* items, size_t count);
+typedef double (*F64DotKernel)(const double* first, const double* second, size_t count);
+
+typedef struct {
+    F64BinaryKernel binary[F64_OP_ENUM_COUNT];
+    F64ArrayScalarKernel arrayScalar[F64_OP_ENUM_COUNT];
+    F64ScalarArrayKernel scalarArray[F64_OP_ENUM_COUNT];
+    F64ReduceKernel sum;
+    F64ReduceKernel min;
+    F64ReduceKernel max;
+    F64DotKernel dot;
+} F64Kernels;
+
+// -- Scalar kernels --
+
+/*
+ * These also finish the elements that are left over
+ * when the length is not a multiple of the vector width.
+ */
+#define DEFINE_SCALAR_ARITHMETIC(name, o) \
+    static void Scalar##name(const double* first, const double* second, double* result, size_t count) { \
+        for (size_t i = 0; i < count; i++) { \
+            result[i] = first[i] o second[i]; \
+        } \
+    } \
+    static void Scalar##name##ArrayScalar(const double* first, double second, double* result, size_t count) { \
+        for (size_t i = 0; i < count; i++) { \
+            result[i] = first[i] o second; \
+        } \
+    } \
+    static void Scalar##name##ScalarArray(double first, const double* second, double* result, size_t count) { \
+        for (size_t i = 0; i < count; i++) { \
+            result[i] = first o second[i]; \
+        } \
+    }
+
+DEFINE_SCALAR_ARITHMETIC(Add, +)
+DEFINE_SCALAR_ARITHMETIC(Subtract, -)
+DEFINE_SCALAR_ARITHMETIC(Multiply, *)
+DEFINE_SCALAR_ARITHMETIC(Divide, /)
+
+static double ScalarSum(const double* items, size_t count) {
+    double sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += items[i];
+    }
+    return sum;
+}
+
+static double ScalarMin(const double* items, size_t count) {
+    double min = items[0];
+    for (size_t i = 1; i < count; i++) {
+        min = items[i] < min ? items[i] : min;
+    }
+    return min;
+}
+
+static double ScalarMax(const double* items, size_t count) {
+    double max = items[0];
+    for (size_t i = 1; i < count; i++) {
+        max = items[i] > max ? items[i] : max;
+    }
+    return max;
+}
+
+static double ScalarDot(const double* first, const double* second, size_t count) {
+    double sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += first[i] * second[i];
+    }
+    return sum;
+}
+
+static const F64Kernels scalarKernels = {
+    .binary = { ScalarAdd, ScalarSubtract, ScalarMultiply, ScalarDivide },
+    .arrayScalar = { ScalarAddArrayScalar, ScalarSubtractArrayScalar, ScalarMultiplyArrayScalar, ScalarDivideArrayScalar },
+    .scalarArray = { ScalarAddScalarArray, ScalarSubtractScalarArray, ScalarMultiplyScalarArray, ScalarDivideScalarArray },
+    .sum = ScalarSum,
+    .min = ScalarMin,
+    .max = ScalarMax,
+    .dot = ScalarDot,
+};
+
+#ifdef F64_ARRAY_HAS_X86_KERNELS
+
+// -- Vector kernels --
+
+/*
+ * The SSE2 and AVX2 kernels are the same loops over vectors of 2 and 4
+ * doubles. Each ISA defines its vector type, width and intrinsics, and the
+ * kernels are compiled for that ISA with a target attribute, so that AVX2
+ * does not have to be enabled for the whole build.
+ */
+#define SSE2_TARGET "sse2"
+#define SSE2_VECTOR __m128d
+#define SSE2_WIDTH 2
+#define SSE2_LOAD _mm_loadu_pd
+#define SSE2_STORE _mm_storeu_pd
+#define SSE2_SET1 _mm_set1_pd
+#define SSE2_SETZERO _mm_setzero_pd
+#define SSE2_ADD _mm_add_pd
+#define SSE2_SUBTRACT _mm_sub_pd
+#define SSE2_MULTIPLY _mm_mul_pd
+#define SSE2_DIVIDE _mm_div_pd
+#define SSE2_MIN _mm_min_pd
+#define SSE2_MAX _mm_max_pd
+
+#define AVX2_TARGET "avx2"
+#define AVX2_VECTOR __m256d
+#define AVX2_WIDTH 4
+#define AVX2_LOAD _mm256_loadu_pd
+#define AVX2_STORE _mm256_storeu_pd
+#define AVX2_SET1 _mm256_set1_pd
+#define AVX2_SETZERO _mm256_setzero_pd
+#define AVX2_ADD _mm256_add_pd
+#define AVX2_SUBTRACT _mm256_sub_pd
+#define AVX2_MULTIPLY _mm256_mul_pd
+#define AVX2_DIVIDE _mm256_div_pd
+#define AVX2_MIN _mm256_min_pd
+#define AVX2_MAX _mm256_max_pd
+
+#define DEFINE_VECTOR_ARITHMETIC(isa, name, op) \
+    __attribute__((target(isa##_TARGET))) \
+    static void isa##name(const double* first, const double* second, double* result, size_t count) { \
+        size_t i = 0; \
+        for (; i + isa##_WIDTH <= count; i += isa##_WIDTH) { \
+            isa##_STORE(result + i, isa##_##op(isa##_LOAD(first + i), isa##_LOAD(second + i))); \
+        } \
+        Scalar##name(first + i, second + i, result + i, count - i); \
+    } \
+    __attribute__((target(isa##_TARGET))) \
+    static void isa##name##ArrayScalar(const double* first, double second, double* result, size_t count) { \
+        isa##_VECTOR scalar = isa##_SET1(second); \
+        size_t i = 0; \
+        for (; i + isa##_WIDTH <= count; i += isa##_WIDTH) { \
+            isa##_STORE(result + i, isa##_##op(isa##_LOAD(first + i), scalar)); \
+        } \
+        Scalar##name##ArrayScalar(first + i, second, result + i, count - i); \
+    } \
+    __attribute__((target(isa##_TARGET))) \
+    static void isa##name##ScalarArray(double first, const double* second, double* result, size_t count) { \
+        isa##_VECTOR scalar = isa##_SET1(first); \
+        size_t i = 0; \
+        for (; i + isa##_WIDTH <= count; i += isa##_WIDTH) { \
+            isa##_STORE(result + i, isa##_##op(scalar, isa##_LOAD(second + i))); \
+        } \
+        Scalar##name##ScalarArray(first, second + i, result + i, count - i); \
+    }
+
+// Combines the lanes of a vector into a single double.
+#define REDUCE_LANES(isa, vector, combine, result) \
+    do { \
+        double lanes[isa##_WIDTH]; \
+        isa##_STORE(lanes, vector); \
+        result = lanes[0]; \
+        for (int lane = 1; lane < isa##_WIDTH; lane++) { \
+            result = combine(result, lanes[lane]); \
+        } \
+    } while(0)
+
+static inline double AddDoubles(double a, double b) {
+    return a + b;
+}
+
+static inline double MinDoubles(double a, double b) {
+    return b < a ? b : a;
+}
+
+static inline double MaxDoubles(double a, double b) {
+    return b > a ? b : a;
+}
+
+/*
+ * The sums use two accumulators, so that an addition does not have to
+ * wait for the one before it to finish.
+ */
+#define DEFINE_VECTOR_REDUCTIONS(isa) \
+    __attribute__((target(isa##_TARGET))) \
+    static double isa##Sum(const double* items, size_t count) { \
+        isa##_VECTOR sum1 = isa##_SETZERO(); \
+        isa##_VECTOR sum2 = isa##_SETZERO(); \
+        size_t i = 0; \
+        for (; i + 2 * isa##_WIDTH <= count; i += 2 * isa##_WIDTH) { \
+            sum1 = isa##_ADD(sum1, isa##_LOAD(items + i)); \
+            sum2 = isa##_ADD(sum2, isa##_LOAD(items + i + isa##_WIDTH)); \
+        } \
+        double sum = 0; \
+        REDUCE_LANES(isa, isa##_ADD(sum1, sum2), AddDoubles, sum); \
+        return sum + ScalarSum(items + i, count - i); \
+    } \
+    __attribute__((target(isa##_TARGET))) \
+    static double isa##Dot(const double* first, const double* second, size_t count) { \
+        isa##_VECTOR sum1 = isa##_SETZERO(); \
+        isa##_VECTOR sum2 = isa##_SETZERO(); \
+        size_t i = 0; \
+        for (; i + 2 * isa##_WIDTH <= count; i += 2 * isa##_WIDTH) { \
+            sum1 = isa##_ADD(sum1, isa##_MULTIPLY(isa##_LOAD(first + i), isa##_LOAD(second + i))); \
+            sum2 = isa##_ADD(sum2, isa##_MULTIPLY(isa##_LOAD(first + i + isa##_WIDTH), isa##_LOAD(second + i + isa##_WIDTH))); \
+        } \
+        double sum = 0; \
+        REDUCE_LANES(isa, isa##_ADD(sum1, sum2), AddDoubles, sum); \
+        return sum + ScalarDot(first + i, second + i, count - i); \
+    } \
+    __attribute__((target(isa##_TARGET))) \
+    static double isa##Min(const double* items, size_t count) { \
+        isa##_VECTOR min = isa##_SET1(items[0]); \
+        size_t i = 0; \
+        for (; i + isa##_WIDTH <= count; i += isa##_WIDTH) { \
+            min = isa##_MIN(isa##_LOAD(items + i), min); \
+        } \
+        double result = 0; \
+        REDUCE_LANES(isa, min, MinDoubles, result); \
+        return i < count ? MinDoubles(result, ScalarMin(items + i, count - i)) : result; \
+    } \
+    __attribute__((target(isa##_TARGET))) \
+    static double isa##Max(const double* items, size_t count) { \
+        isa##_VECTOR max = isa##_SET1(items[0]); \
+        size_t i = 0; \
+        for (; i + isa##_WIDTH <= count; i += isa##_WIDTH) { \
+            max = isa##_MAX(isa##_LOAD(items + i), max); \
+        } \
+        double result = 0; \
+        REDUCE_LANES(isa, max, MaxDoubles, result); \
+        return i < count ? MaxDoubles(result, ScalarMax(items + i, count - i)) : result; \
+    }
+
+#define DEFINE_VECTOR_KERNELS(isa) \
+    DEFINE_VECTOR_ARITHMETIC(isa, Add, ADD) \
+    DEFINE_VECTOR_ARITHMETIC(isa, Subtract, SUBTRACT) \
+    DEFINE_VECTOR_ARITHMETIC(isa, Multiply, MULTIPLY) \
+    DEFINE_VECTOR_ARITHMETIC(isa, Divide, DIVIDE) \
+    DEFINE_VECTOR_REDUCTIONS(isa) \
+    static const F64Kernels isa##Kernels = { \
+        .binary = { isa##Add, isa##Subtract, isa##Multiply, isa##Divide }, \
+        .arrayScalar = { isa##AddArrayScalar, isa##SubtractArrayScalar, isa##MultiplyArrayScalar, isa##DivideArrayScalar }, \
+        .scalarArray = { isa##AddScalarArray, isa##SubtractScalarArray, isa##MultiplyScalarArray, isa##DivideScalarArray }, \
+        .sum = isa##Sum, \
+        .min = isa##Min, \
+        .max = isa##Max, \
+        .dot = isa##Dot, \
+    };
+
+DEFINE_VECTOR_KERNELS(SSE2)
+DEFINE_VECTOR_KERNELS(AVX2)
+
+#endif
+
+// -- Dispatch --
+
+static _Thread_local const F64Kernels* kernels = NULL;
+
+F64KernelLevel GetSupportedF64KernelLevel() {
+#ifdef F64_ARRAY_HAS_X86_KERNELS
+    if (__builtin_cpu_supports("avx2")) {
+        return F64_KERNELS_AVX2;
+    }
+    return F64_KERNELS_SSE2;
+#else
+    return F64_KERNELS_SCALAR;
+#endif
+}
+
+void SetF64KernelLevel(F64KernelLevel level) {
+    Assertf(level <= GetSupportedF64KernelLevel(), "Unsupported kernel level %d", level);
+    switch (level) {
+#ifdef F64_ARRAY_HAS_X86_KERNELS
+        case F64_KERNELS_AVX2: kernels = &AVX2Kernels; break;
+        case F64_KERNELS_SSE2: kernels = &SSE2Kernels; break;
+#endif
+        default: kernels = &scalarKernels; break;
+    }
+}
+
+static const F64Kernels* GetKernels() {
+    if (kernels == NULL) {
+        SetF64KernelLevel(GetSupportedF64KernelLevel());
+    }
+    return kernels;
+}
+
+// -- Arrays --
+
+Object* CreateF64ArrayObject(size_t count, Allocator* allocator) {
+    Assert(count <= UINT32_MAX, "Too many array items");
+
+    // empty arrays get an item too, so that the kernels never see a NULL pointer
+    size_t bytes = (count == 0 ? 1 : count) * sizeof(double);
+    Object* array = AllocateObject(OBJECT_F64_ARRAY, OBJECT_SIZE(f64Array), allocator);
+    array->as.f64Array = (F64ArrayData) {
+        .count = count,
+        .items = AllocatorAllocAligned(bytes, F64_ARRAY_ALIGNMENT, allocator),
+    };
+    return array;
+}
+
+Object* F64ArrayArithmetic(F64Op op, Object* first, Object* second, Allocator* allocator) {
+    size_t count = first->as.f64Array.count;
+    Assert(count == second->as.f64Array.count, "Expected arrays of the same length");
+
+    Object* result = CreateF64ArrayObject(count, allocator);
+    GetKernels()->binary[op](first->as.f64Array.items, second->as.f64Array.items, result->as.f64Array.items, count);
+    return result;
+}
+
+Object* F64ArrayScalarArithmetic(F64Op op, Object* first, double second, Allocator* allocator) {
+    size_t count = first->as.f64Array.count;
+    Object* result = CreateF64ArrayObject(count, allocator);
+    GetKernels()->arrayScalar[op](first->as.f64Array.items, second, result->as.f64Array.items, count);
+    return result;
+}
+
+Object* F64ScalarArrayArithmetic(F64Op op, double first, Object* second, Allocator* allocator) {
+    size_t count = second->as.f64Array.count;
+    Object* result = CreateF64ArrayObject(count, allocator);
+    GetKernels()->scalarArray[op](first, second->as.f64Array.items, result->as.f64Array.items, count);
+    return result;
+}
+
+double F64ArraySum(Object* array) {
+    return GetKernels()->sum(array->as.f64Array.items, array->as.f64Array.count);
+}
+
+double F64ArrayMin(Object* array) {
+    Assert(array->as.f64Array.count > 0, "Expected a non-empty array");
+    return GetKernels()->min(array->as.f64Array.items, array->as.f64Array.count);
+}
+
+double F64ArrayMax(Object* array) {
+    Assert(array->as.f64Array.count > 0, "Expected a non-empty array");
+    return GetKernels()->max(array->as.f64Array.items, array->as.f64Array.count);
+}
+
+double F64ArrayDot(Object* first, Object* second) {
+    Assert(first->as.f64Array.count == second->as.f64Array.count, "Expected arrays of the same length");
+    return GetKernels()->dot(first->as.f64Array.items, second->as.f64Array.items, first->as.f64Array.count);
+}
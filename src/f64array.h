@@ -0,0 +1,55 @@
+/*
+ * Arrays of unboxed doubles for numeric work.
+ *
+ * Arithmetic and reductions run a kernel over the whole array instead of
+ * dispatching on every element. The kernels use SSE2 or AVX2 when the CPU
+ * supports it, which is detected at runtime, and plain loops otherwise.
+ *
+ * Vectorized reductions add the elements in a different order than a plain
+ * loop would, so sums may differ in the last bits between kernel levels.
+ */
+#ifndef f64array_h
+#define f64array_h
+
+#include "values.h"
+
+// Items are aligned for the widest vector loads.
+#define F64_ARRAY_ALIGNMENT 32
+
+typedef enum {
+    F64_KERNELS_SCALAR,
+    F64_KERNELS_SSE2,
+    F64_KERNELS_AVX2,
+} F64KernelLevel;
+
+// The best kernels that this CPU supports.
+F64KernelLevel GetSupportedF64KernelLevel();
+// Picks the kernels for this thread. The default is the supported level.
+void SetF64KernelLevel(F64KernelLevel level);
+
+typedef enum {
+    F64_OP_ADD,
+    F64_OP_SUBTRACT,
+    F64_OP_MULTIPLY,
+    F64_OP_DIVIDE,
+    F64_OP_ENUM_COUNT,
+} F64Op;
+
+// The items are not initialized.
+Object* CreateF64ArrayObject(size_t count, Allocator* allocator);
+
+// Element-wise arithmetic. The arrays must have the same length.
+Object* F64ArrayArithmetic(F64Op op, Object* first, Object* second, Allocator* allocator);
+// Applies the scalar to every element, as the second operand.
+Object* F64ArrayScalarArithmetic(F64Op op, Object* first, double second, Allocator* allocator);
+// Applies the scalar to every element, as the first operand.
+Object* F64ScalarArrayArithmetic(F64Op op, double first, Object* second, Allocator* allocator);
+
+double F64ArraySum(Object* array);
+// The array must not be empty.
+double F64ArrayMin(Object* array);
+double F64ArrayMax(Object* array);
+// The arrays must have the same length.
+double F64ArrayDot(Object* first, Object* second);
+
+#endif
@@ -0,0 +1,458 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "hamt.h"
+#include "asserts.h"
+
+// -- Hash array mapped trie --
+
+/*
+ * Each node has a bitmap of entries and a bitmap of child nodes. The values
+ * of a node are the entries, in bitmap order, followed by the child nodes.
+ * An entry is a key and a value for maps and only a key for sets.
+ *
+ * The trie is kept compact: a child always has more than one entry,
+ * otherwise the entry is moved up into the parent.
+ */
+#define HAMT_BITS 5
+#define HAMT_BRANCHES (1 << HAMT_BITS)
+#define HAMT_HASH_BITS 32
+// the greatest number of values in a node that is not a collision node
+#define HAMT_MAX_NODE_SIZE (2 * HAMT_BRANCHES)
+// transients allocate nodes with some room, so that inserts can be done in place
+#define HAMT_TRANSIENT_MIN_CAPACITY 8
+
+// 0 is for persistent nodes, so edit ids start at 1
+static atomic_uint nextEdit = 1;
+
+typedef struct {
+    // values per entry, 2 for maps and 1 for sets
+    size_t width;
+    uint32_t edit;
+    Allocator* allocator;
+    int countDelta;
+} HamtUpdate;
+
+static uint32_t GetFragment(uint32_t hash, uint32_t shift) {
+    return (hash >> shift) & (HAMT_BRANCHES - 1);
+}
+
+static size_t GetIndex(uint32_t bitmap, uint32_t bit) {
+    return __builtin_popcount(bitmap & (bit - 1));
+}
+
+static bool IsCollisionNode(uint32_t shift) {
+    return shift >= HAMT_HASH_BITS;
+}
+
+static Value* GetNodeItems(Object* node) {
+    return (Value*)((char*)node + OBJECT_SIZE(hamtNode));
+}
+
+static size_t GetNodeSize(Object* node, uint32_t shift, size_t width) {
+    HamtNodeData* data = &node->as.hamtNode;
+    if (IsCollisionNode(shift)) {
+        return data->dataMap * width;
+    }
+    return __builtin_popcount(data->dataMap) * width + __builtin_popcount(data->nodeMap);
+}
+
+static bool IsEditable(Object* node, HamtUpdate* update) {
+    return update->edit != 0 && node->as.hamtNode.edit == update->edit;
+}
+
+static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t result = 1;
+    while (result < n) {
+        result *= 2;
+    }
+    return result;
+}
+
+static Object* AllocateNode(uint32_t dataMap, uint32_t nodeMap, size_t size, HamtUpdate* update) {
+    size_t capacity = size;
+    if (update->edit != 0) {
+        capacity = RoundUpToPowerOfTwo(size < HAMT_TRANSIENT_MIN_CAPACITY ? HAMT_TRANSIENT_MIN_CAPACITY : size);
+    }
+
+    Object* node = AllocateObject(OBJECT_HAMT_NODE, OBJECT_SIZE(hamtNode) + capacity * sizeof(Value), update->allocator);
+    node->as.hamtNode = (HamtNodeData) {
+        .dataMap = dataMap,
+        .nodeMap = nodeMap,
+        .edit = update->edit,
+        .capacity = capacity,
+    };
+    return node;
+}
+
+// Sets the contents of a node, in place if the transient owns the node.
+static Object* RebuildNode(Object* node, uint32_t dataMap, uint32_t nodeMap, Value* items, size_t size, HamtUpdate* update) {
+    if (!IsEditable(node, update) || size > node->as.hamtNode.capacity) {
+        node = AllocateNode(dataMap, nodeMap, size, update);
+    }
+    memcpy(GetNodeItems(node), items, size * sizeof(Value));
+    node->as.hamtNode.dataMap = dataMap;
+    node->as.hamtNode.nodeMap = nodeMap;
+    return node;
+}
+
+static void PutEntry(Value* items, Value key, Value value, size_t width) {
+    items[0] = key;
+    if (width == 2) {
+        items[1] = value;
+    }
+}
+
+static Object* MergeEntries(Value key1, Value value1, uint32_t hash1,
+                            Value key2, Value value2, uint32_t hash2,
+                            uint32_t shift, HamtUpdate* update) {
+    size_t width = update->width;
+    if (IsCollisionNode(shift)) {
+        Object* node = AllocateNode(2, 0, 2 * width, update);
+        PutEntry(GetNodeItems(node), key1, value1, width);
+        PutEntry(GetNodeItems(node) + width, key2, value2, width);
+        return node;
+    }
+
+    uint32_t fragment1 = GetFragment(hash1, shift);
+    uint32_t fragment2 = GetFragment(hash2, shift);
+    if (fragment1 == fragment2) {
+        Object* child = MergeEntries(key1, value1, hash1, key2, value2, hash2, shift + HAMT_BITS, update);
+        Object* node = AllocateNode(0, 1u << fragment1, 1, update);
+        GetNodeItems(node)[0] = MAKE_VALUE_OBJECT(child);
+        return node;
+    }
+
+    Object* node = AllocateNode((1u << fragment1) | (1u << fragment2), 0, 2 * width, update);
+    Value* items = GetNodeItems(node);
+    size_t first = fragment1 < fragment2 ? 0 : width;
+    PutEntry(items + first, key1, value1, width);
+    PutEntry(items + width - first, key2, value2, width);
+    return node;
+}
+
+static Object* InsertCollision(Object* node, Value key, Value value, HamtUpdate* update) {
+    size_t width = update->width;
+    size_t count = node->as.hamtNode.dataMap;
+    Value* items = GetNodeItems(node);
+
+    for (size_t i = 0; i < count; i++) {
+        if (!KeysEqual(items[i * width], key)) {
+            continue;
+        }
+        if (width == 1 || ValuesIdentical(items[i * width + 1], value)) {
+            return node;
+        }
+        Object* result = node;
+        if (!IsEditable(node, update)) {
+            result = AllocateNode(count, 0, count * width, update);
+            memcpy(GetNodeItems(result), items, count * width * sizeof(Value));
+        }
+        GetNodeItems(result)[i * width + 1] = value;
+        return result;
+    }
+
+    Object* result = node;
+    if (!IsEditable(node, update) || (count + 1) * width > node->as.hamtNode.capacity) {
+        result = AllocateNode(count, 0, (count + 1) * width, update);
+        memcpy(GetNodeItems(result), items, count * width * sizeof(Value));
+    }
+    PutEntry(GetNodeItems(result) + count * width, key, value, width);
+    result->as.hamtNode.dataMap = count + 1;
+    update->countDelta = 1;
+    return result;
+}
+
+static Object* InsertNode(Object* node, Value key, Value value, uint32_t hash, uint32_t shift, HamtUpdate* update) {
+    if (IsCollisionNode(shift)) {
+        return InsertCollision(node, key, value, update);
+    }
+
+    size_t width = update->width;
+    uint32_t dataMap = node->as.hamtNode.dataMap;
+    uint32_t nodeMap = node->as.hamtNode.nodeMap;
+    uint32_t bit = 1u << GetFragment(hash, shift);
+    Value* items = GetNodeItems(node);
+    size_t size = GetNodeSize(node, shift, width);
+    size_t numDataValues = __builtin_popcount(dataMap) * width;
+    Value newItems[HAMT_MAX_NODE_SIZE];
+
+    if (dataMap & bit) {
+        size_t i = GetIndex(dataMap, bit) * width;
+        Value existingKey = items[i];
+        if (KeysEqual(existingKey, key)) {
+            if (width == 1 || ValuesIdentical(items[i + 1], value)) {
+                return node;
+            }
+            memcpy(newItems, items, size * sizeof(Value));
+            newItems[i + 1] = value;
+            return RebuildNode(node, dataMap, nodeMap, newItems, size, update);
+        }
+
+        // two different keys in the same branch, so the branch becomes a child node
+        Value existingValue = width == 2 ? items[i + 1] : MAKE_VALUE_NIL();
+        Object* child = MergeEntries(existingKey, existingValue, HashKey(existingKey),
+                                     key, value, hash, shift + HAMT_BITS, update);
+        update->countDelta = 1;
+
+        size_t childIndex = numDataValues - width + GetIndex(nodeMap, bit);
+        memcpy(newItems, items, i * sizeof(Value));
+        memcpy(newItems + i, items + i + width, (childIndex - i) * sizeof(Value));
+        newItems[childIndex] = MAKE_VALUE_OBJECT(child);
+        memcpy(newItems + childIndex + 1, items + childIndex + width, (size - childIndex - width) * sizeof(Value));
+        return RebuildNode(node, dataMap & ~bit, nodeMap | bit, newItems, size - width + 1, update);
+    }
+
+    if (nodeMap & bit) {
+        size_t childIndex = numDataValues + GetIndex(nodeMap, bit);
+        Object* child = ValueAsObject(items[childIndex]);
+        Object* newChild = InsertNode(child, key, value, hash, shift + HAMT_BITS, update);
+        if (newChild == child) {
+            return node;
+        }
+        memcpy(newItems, items, size * sizeof(Value));
+        newItems[childIndex] = MAKE_VALUE_OBJECT(newChild);
+        return RebuildNode(node, dataMap, nodeMap, newItems, size, update);
+    }
+
+    size_t i = GetIndex(dataMap, bit) * width;
+    memcpy(newItems, items, i * sizeof(Value));
+    PutEntry(newItems + i, key, value, width);
+    memcpy(newItems + i + width, items + i, (size - i) * sizeof(Value));
+    update->countDelta = 1;
+    return RebuildNode(node, dataMap | bit, nodeMap, newItems, size + width, update);
+}
+
+static Object* RemoveCollision(Object* node, Value key, HamtUpdate* update) {
+    size_t width = update->width;
+    size_t count = node->as.hamtNode.dataMap;
+    Value* items = GetNodeItems(node);
+
+    for (size_t i = 0; i < count; i++) {
+        if (!KeysEqual(items[i * width], key)) {
+            continue;
+        }
+        Object* result = node;
+        if (!IsEditable(node, update)) {
+            result = AllocateNode(count - 1, 0, (count - 1) * width, update);
+            memcpy(GetNodeItems(result), items, i * width * sizeof(Value));
+        }
+        memmove(GetNodeItems(result) + i * width, items + (i + 1) * width, (count - i - 1) * width * sizeof(Value));
+        result->as.hamtNode.dataMap = count - 1;
+        update->countDelta = -1;
+        return result;
+    }
+    return node;
+}
+
+static bool HasSingleEntry(Object* node, uint32_t shift) {
+    HamtNodeData* data = &node->as.hamtNode;
+    if (IsCollisionNode(shift)) {
+        return data->dataMap == 1;
+    }
+    return data->nodeMap == 0 && __builtin_popcount(data->dataMap) == 1;
+}
+
+static Object* RemoveNode(Object* node, Value key, uint32_t hash, uint32_t shift, HamtUpdate* update) {
+    if (IsCollisionNode(shift)) {
+        return RemoveCollision(node, key, update);
+    }
+
+    size_t width = update->width;
+    uint32_t dataMap = node->as.hamtNode.dataMap;
+    uint32_t nodeMap = node->as.hamtNode.nodeMap;
+    uint32_t bit = 1u << GetFragment(hash, shift);
+    Value* items = GetNodeItems(node);
+    size_t size = GetNodeSize(node, shift, width);
+    size_t numDataValues = __builtin_popcount(dataMap) * width;
+    Value newItems[HAMT_MAX_NODE_SIZE];
+
+    if (dataMap & bit) {
+        size_t i = GetIndex(dataMap, bit) * width;
+        if (!KeysEqual(items[i], key)) {
+            return node;
+        }
+        memcpy(newItems, items, i * sizeof(Value));
+        memcpy(newItems + i, items + i + width, (size - i - width) * sizeof(Value));
+        update->countDelta = -1;
+        return RebuildNode(node, dataMap & ~bit, nodeMap, newItems, size - width, update);
+    }
+
+    if (!(nodeMap & bit)) {
+        return node;
+    }
+
+    size_t childIndex = numDataValues + GetIndex(nodeMap, bit);
+    Object* child = ValueAsObject(items[childIndex]);
+    Object* newChild = RemoveNode(child, key, hash, shift + HAMT_BITS, update);
+    if (newChild == child && update->countDelta == 0) {
+        return node;
+    }
+
+    if (!HasSingleEntry(newChild, shift + HAMT_BITS)) {
+        memcpy(newItems, items, size * sizeof(Value));
+        newItems[childIndex] = MAKE_VALUE_OBJECT(newChild);
+        return RebuildNode(node, dataMap, nodeMap, newItems, size, update);
+    }
+
+    // move the last entry of the child up into this node
+    size_t i = GetIndex(dataMap, bit) * width;
+    memcpy(newItems, items, i * sizeof(Value));
+    memcpy(newItems + i, GetNodeItems(newChild), width * sizeof(Value));
+    memcpy(newItems + i + width, items + i, (childIndex - i) * sizeof(Value));
+    memcpy(newItems + childIndex + width, items + childIndex + 1, (size - childIndex - 1) * sizeof(Value));
+    return RebuildNode(node, dataMap | bit, nodeMap & ~bit, newItems, size + width - 1, update);
+}
+
+// -- Maps and sets --
+
+static size_t GetEntryWidth(Object* hamt) {
+    return hamt->type == OBJECT_MAP ? 2 : 1;
+}
+
+static Object* CreateHamtObject(ObjectType type, Object* root, uint32_t count, uint32_t edit, Allocator* allocator) {
+    Object* hamt = AllocateObject(type, OBJECT_SIZE(hamt), allocator);
+    hamt->as.hamt = (HamtData) {
+        .count = count,
+        .edit = edit,
+        .root = root,
+    };
+    return hamt;
+}
+
+static Object* CreateEmptyHamt(ObjectType type, Allocator* allocator) {
+    HamtUpdate update = { .allocator = allocator };
+    Object* root = AllocateNode(0, 0, 0, &update);
+    return CreateHamtObject(type, root, 0, 0, allocator);
+}
+
+Object* CreateMapObject(Allocator* allocator) {
+    return CreateEmptyHamt(OBJECT_MAP, allocator);
+}
+
+Object* CreateSetObject(Allocator* allocator) {
+    return CreateEmptyHamt(OBJECT_SET, allocator);
+}
+
+static HamtUpdate MakeUpdate(Object* hamt, Allocator* allocator) {
+    return (HamtUpdate) {
+        .width = GetEntryWidth(hamt),
+        .edit = hamt->as.hamt.edit,
+        .allocator = allocator,
+        .countDelta = 0,
+    };
+}
+
+Object* HamtAssoc(Object* hamt, Value key, Value value, Allocator* allocator) {
+    Assert(hamt->as.hamt.edit == 0, "Expected a persistent map or set");
+
+    key = PrepareKey(key, allocator);
+    HamtUpdate update = MakeUpdate(hamt, allocator);
+    Object* root = InsertNode(hamt->as.hamt.root, key, value, HashKey(key), 0, &update);
+    if (root == hamt->as.hamt.root) {
+        return hamt;
+    }
+    return CreateHamtObject(hamt->type, root, hamt->as.hamt.count + update.countDelta, 0, allocator);
+}
+
+Object* HamtDissoc(Object* hamt, Value key, Allocator* allocator) {
+    Assert(hamt->as.hamt.edit == 0, "Expected a persistent map or set");
+
+    key = PrepareKey(key, allocator);
+    HamtUpdate update = MakeUpdate(hamt, allocator);
+    Object* root = RemoveNode(hamt->as.hamt.root, key, HashKey(key), 0, &update);
+    if (update.countDelta == 0) {
+        return hamt;
+    }
+    return CreateHamtObject(hamt->type, root, hamt->as.hamt.count + update.countDelta, 0, allocator);
+}
+
+bool HamtGet(Object* hamt, Value key, Value* value, Allocator* allocator) {
+    key = PrepareKey(key, allocator);
+    uint32_t hash = HashKey(key);
+    size_t width = GetEntryWidth(hamt);
+    Object* node = hamt->as.hamt.root;
+
+    for (uint32_t shift = 0; !IsCollisionNode(shift); shift += HAMT_BITS) {
+        uint32_t dataMap = node->as.hamtNode.dataMap;
+        uint32_t nodeMap = node->as.hamtNode.nodeMap;
+        uint32_t bit = 1u << GetFragment(hash, shift);
+        Value* items = GetNodeItems(node);
+
+        if (dataMap & bit) {
+            Value* entry = items + GetIndex(dataMap, bit) * width;
+            if (!KeysEqual(entry[0], key)) {
+                return false;
+            }
+            *value = entry[width - 1];
+            return true;
+        } else if (nodeMap & bit) {
+            node = ValueAsObject(items[__builtin_popcount(dataMap) * width + GetIndex(nodeMap, bit)]);
+        } else {
+            return false;
+        }
+    }
+
+    Value* items = GetNodeItems(node);
+    for (size_t i = 0; i < node->as.hamtNode.dataMap; i++) {
+        if (KeysEqual(items[i * width], key)) {
+            *value = items[i * width + width - 1];
+            return true;
+        }
+    }
+    return false;
+}
+
+Object* HamtTransient(Object* hamt, Allocator* allocator) {
+    Assert(hamt->as.hamt.edit == 0, "Expected a persistent map or set");
+
+    uint32_t edit = atomic_fetch_add(&nextEdit, 1);
+    if (edit == 0) {
+        edit = atomic_fetch_add(&nextEdit, 1);
+    }
+    // the nodes are shared with the persistent version until they are first updated
+    return CreateHamtObject(hamt->type, hamt->as.hamt.root, hamt->as.hamt.count, edit, allocator);
+}
+
+void HamtTransientAssoc(Object* transient, Value key, Value value, Allocator* allocator) {
+    Assert(transient->as.hamt.edit != 0, "Expected a transient map or set");
+
+    key = PrepareKey(key, allocator);
+    HamtUpdate update = MakeUpdate(transient, allocator);
+    transient->as.hamt.root = InsertNode(transient->as.hamt.root, key, value, HashKey(key), 0, &update);
+    transient->as.hamt.count += update.countDelta;
+}
+
+void HamtTransientDissoc(Object* transient, Value key, Allocator* allocator) {
+    Assert(transient->as.hamt.edit != 0, "Expected a transient map or set");
+
+    key = PrepareKey(key, allocator);
+    HamtUpdate update = MakeUpdate(transient, allocator);
+    transient->as.hamt.root = RemoveNode(transient->as.hamt.root, key, HashKey(key), 0, &update);
+    transient->as.hamt.count += update.countDelta;
+}
+
+Object* HamtPersistent(Object* transient) {
+    // the edit id is never reused, so the nodes of the transient become read only
+    transient->as.hamt.edit = 0;
+    return transient;
+}
+
+static void ForEachInNode(Object* node, uint32_t shift, size_t width, HamtEntryFn fn, void* ctx) {
+    Value* items = GetNodeItems(node);
+    size_t numEntries = IsCollisionNode(shift) ? node->as.hamtNode.dataMap : __builtin_popcount(node->as.hamtNode.dataMap);
+    for (size_t i = 0; i < numEntries; i++) {
+        fn(items[i * width], items[i * width + width - 1], ctx);
+    }
+
+    if (IsCollisionNode(shift)) {
+        return;
+    }
+    size_t numNodes = __builtin_popcount(node->as.hamtNode.nodeMap);
+    for (size_t i = 0; i < numNodes; i++) {
+        ForEachInNode(ValueAsObject(items[numEntries * width + i]), shift + HAMT_BITS, width, fn, ctx);
+    }
+}
+
+void HamtForEach(Object* hamt, HamtEntryFn fn, void* ctx) {
+    ForEachInNode(hamt->as.hamt.root, 0, GetEntryWidth(hamt), fn, ctx);
+}
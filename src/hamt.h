@@ -0,0 +1,37 @@
+/*
+ * Persistent maps and sets, implemented as hash array mapped tries.
+ *
+ * An update returns a new map or set that shares every unchanged node with
+ * the old one, so old versions stay valid. A lookup visits at most one node
+ * per 5 bits of the key hash.
+ *
+ * Numbers and strings are compared by value, other objects by identity.
+ * Strings that are used as keys are flattened with the given allocator.
+ *
+ * A transient is a map or set for building in bulk. It is updated in place
+ * where it owns the nodes, until it is made persistent again.
+ */
+#ifndef hamt_h
+#define hamt_h
+
+#include "values.h"
+
+Object* CreateMapObject(Allocator* allocator);
+Object* CreateSetObject(Allocator* allocator);
+
+// The value is ignored for sets.
+Object* HamtAssoc(Object* hamt, Value key, Value value, Allocator* allocator);
+Object* HamtDissoc(Object* hamt, Value key, Allocator* allocator);
+// Finds the value of a key. For sets the value is the key.
+bool HamtGet(Object* hamt, Value key, Value* value, Allocator* allocator);
+
+Object* HamtTransient(Object* hamt, Allocator* allocator);
+void HamtTransientAssoc(Object* transient, Value key, Value value, Allocator* allocator);
+void HamtTransientDissoc(Object* transient, Value key, Allocator* allocator);
+// Ends the transient, which can then be used as an ordinary map or set.
+Object* HamtPersistent(Object* transient);
+
+typedef void (*HamtEntryFn)(Value key, Value value, void* ctx);
+void HamtForEach(Object* hamt, HamtEntryFn fn, void* ctx);
+
+#endif
@@ -0,0 +1,233 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <string.h>
+#include "hashtable.h"
+#include "asserts.h"
+
+#define HASHTABLE_GROUP_SIZE 16
+#define HASHTABLE_CONTROL_EMPTY ((uint8_t)0x80)
+#define HASHTABLE_CONTROL_DELETED ((uint8_t)0xfe)
+// the table is rehashed when it is 7/8 full, counting deleted slots
+#define HASHTABLE_MAX_LOAD(capacity) ((capacity) - (capacity) / 8)
+
+// -- Probe groups --
+
+/*
+ * The bits of a mask are the slots in a group, in order.
+ * Full slots have a control byte with the top bit clear.
+ */
+#ifdef __SSE2__
+static uint32_t MatchControl(uint8_t* group, uint8_t control) {
+    __m128i controls = _mm_load_si128((__m128i*)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8(control)));
+}
+
+static uint32_t MatchEmptyOrDeleted(uint8_t* group) {
+    // the top bit is only set for empty and deleted slots
+    return _mm_movemask_epi8(_mm_load_si128((__m128i*)group));
+}
+#else
+static uint32_t MatchControl(uint8_t* group, uint8_t control) {
+    uint32_t mask = 0;
+    for (int i = 0; i < HASHTABLE_GROUP_SIZE; i++) {
+        mask |= (uint32_t)(group[i] == control) << i;
+    }
+    return mask;
+}
+
+static uint32_t MatchEmptyOrDeleted(uint8_t* group) {
+    uint32_t mask = 0;
+    for (int i = 0; i < HASHTABLE_GROUP_SIZE; i++) {
+        mask |= (uint32_t)(group[i] >> 7) << i;
+    }
+    return mask;
+}
+#endif
+
+// -- Hash table --
+
+// Spreads the key hash over all bits, since the groups and the control bytes use different bits.
+static uint32_t MixHash(uint32_t hash) {
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static uint8_t GetControlHash(uint32_t hash) {
+    return hash >> 25;
+}
+
+static Value* GetSlots(HashTableData* data) {
+    return (Value*)(data->controls + data->capacity);
+}
+
+static size_t GetStorageSize(size_t capacity) {
+    return capacity + capacity * 2 * sizeof(Value);
+}
+
+static void AllocateStorage(HashTableData* data, size_t capacity, Allocator* allocator) {
+    Assert(capacity <= UINT32_MAX, "Too many hash table slots");
+    data->capacity = capacity;
+    data->count = 0;
+    data->growthLeft = HASHTABLE_MAX_LOAD(capacity);
+    data->controls = AllocatorAllocAligned(GetStorageSize(capacity), HASHTABLE_GROUP_SIZE, allocator);
+    memset(data->controls, HASHTABLE_CONTROL_EMPTY, capacity);
+}
+
+/*
+ * Visits the groups in triangular order, which covers every group
+ * when the number of groups is a power of two.
+ */
+typedef struct {
+    size_t group;
+    size_t step;
+    size_t mask;
+} ProbeSequence;
+
+static ProbeSequence StartProbe(HashTableData* data, uint32_t hash) {
+    size_t mask = data->capacity / HASHTABLE_GROUP_SIZE - 1;
+    return (ProbeSequence) {
+        .group = (hash & 0x1ffffff) & mask,
+        .step = 0,
+        .mask = mask,
+    };
+}
+
+static void NextProbe(ProbeSequence* probe) {
+    probe->step++;
+    probe->group = (probe->group + probe->step) & probe->mask;
+}
+
+// Returns the slot index of the key, or -1.
+static ptrdiff_t FindSlot(HashTableData* data, Value key, uint32_t hash) {
+    uint8_t control = GetControlHash(hash);
+    Value* slots = GetSlots(data);
+
+    for (ProbeSequence probe = StartProbe(data, hash); ; NextProbe(&probe)) {
+        uint8_t* group = data->controls + probe.group * HASHTABLE_GROUP_SIZE;
+        for (uint32_t matches = MatchControl(group, control); matches != 0; matches &= matches - 1) {
+            size_t i = probe.group * HASHTABLE_GROUP_SIZE + __builtin_ctz(matches);
+            if (KeysEqual(slots[i * 2], key)) {
+                return i;
+            }
+        }
+        // a probe only continues past groups that were full when the key was inserted
+        if (MatchControl(group, HASHTABLE_CONTROL_EMPTY) != 0 || probe.step == probe.mask) {
+            return -1;
+        }
+    }
+}
+
+static size_t FindFreeSlot(HashTableData* data, uint32_t hash) {
+    for (ProbeSequence probe = StartProbe(data, hash); ; NextProbe(&probe)) {
+        uint32_t available = MatchEmptyOrDeleted(data->controls + probe.group * HASHTABLE_GROUP_SIZE);
+        if (available != 0) {
+            return probe.group * HASHTABLE_GROUP_SIZE + __builtin_ctz(available);
+        }
+    }
+}
+
+static void InsertNew(HashTableData* data, Value key, Value value, uint32_t hash) {
+    size_t i = FindFreeSlot(data, hash);
+    if (data->controls[i] == HASHTABLE_CONTROL_EMPTY) {
+        data->growthLeft--;
+    }
+    data->controls[i] = GetControlHash(hash);
+    GetSlots(data)[i * 2] = key;
+    GetSlots(data)[i * 2 + 1] = value;
+    data->count++;
+}
+
+// Grows the table if it is mostly full, otherwise only the deleted slots are reclaimed.
+static void Rehash(HashTableData* data, Allocator* allocator) {
+    HashTableData old = *data;
+    size_t capacity = old.count >= old.capacity / 2 ? old.capacity * 2 : old.capacity;
+    AllocateStorage(data, capacity, allocator);
+
+    Value* slots = GetSlots(&old);
+    for (size_t i = 0; i < old.capacity; i++) {
+        if (!(old.controls[i] & HASHTABLE_CONTROL_EMPTY)) {
+            InsertNew(data, slots[i * 2], slots[i * 2 + 1], MixHash(HashKey(slots[i * 2])));
+        }
+    }
+    AllocatorFreeObject(old.controls, GetStorageSize(old.capacity), allocator);
+}
+
+Object* CreateHashTableObject(size_t capacity, Allocator* allocator) {
+    size_t slots = HASHTABLE_GROUP_SIZE;
+    while (HASHTABLE_MAX_LOAD(slots) < capacity) {
+        slots *= 2;
+    }
+
+    Object* table = AllocateObject(OBJECT_HASHTABLE, OBJECT_SIZE(hashTable), allocator);
+    AllocateStorage(&table->as.hashTable, slots, allocator);
+    return table;
+}
+
+bool IsHashTableKey(Value key) {
+    switch (GetValueType(key)) {
+        case VALUE_F64:
+        case VALUE_I32:
+            return true;
+        case VALUE_OBJECT: {
+            ObjectType type = ValueAsObject(key)->type;
+            return type == OBJECT_STRING || type == OBJECT_SYMBOL;
+        }
+        default:
+            return false;
+    }
+}
+
+void HashTablePut(Object* table, Value key, Value value, Allocator* allocator) {
+    HashTableData* data = &table->as.hashTable;
+    key = PrepareKey(key, allocator);
+    uint32_t hash = MixHash(HashKey(key));
+
+    ptrdiff_t i = FindSlot(data, key, hash);
+    if (i >= 0) {
+        GetSlots(data)[i * 2 + 1] = value;
+        return;
+    }
+
+    if (data->growthLeft == 0) {
+        Rehash(data, allocator);
+    }
+    InsertNew(data, key, value, hash);
+}
+
+bool HashTableGet(Object* table, Value key, Value* value, Allocator* allocator) {
+    HashTableData* data = &table->as.hashTable;
+    key = PrepareKey(key, allocator);
+
+    ptrdiff_t i = FindSlot(data, key, MixHash(HashKey(key)));
+    if (i < 0) {
+        return false;
+    }
+    *value = GetSlots(data)[i * 2 + 1];
+    return true;
+}
+
+bool HashTableRemove(Object* table, Value key, Allocator* allocator) {
+    HashTableData* data = &table->as.hashTable;
+    key = PrepareKey(key, allocator);
+
+    ptrdiff_t i = FindSlot(data, key, MixHash(HashKey(key)));
+    if (i < 0) {
+        return false;
+    }
+
+    // no probe has passed a group with an empty slot, so the slot can be empty again
+    uint8_t* group = data->controls + i / HASHTABLE_GROUP_SIZE * HASHTABLE_GROUP_SIZE;
+    if (MatchControl(group, HASHTABLE_CONTROL_EMPTY) != 0) {
+        data->controls[i] = HASHTABLE_CONTROL_EMPTY;
+        data->growthLeft++;
+    } else {
+        data->controls[i] = HASHTABLE_CONTROL_DELETED;
+    }
+    data->count--;
+    return true;
+}
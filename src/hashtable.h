@@ -0,0 +1,26 @@
+/*
+ * Mutable hash tables for hot loops, such as counting and grouping.
+ *
+ * Open addressing in the layout of a Swiss table. Every slot has a control
+ * byte that is either empty, deleted or 7 bits of the key hash. A probe
+ * compares the control bytes of a group of 16 slots at once, so the keys
+ * are only compared for slots where those 7 bits match.
+ *
+ * Keys are numbers, strings and symbols, see KeysEqual.
+ */
+#ifndef hashtable_h
+#define hashtable_h
+
+#include "values.h"
+
+// The capacity is a hint for the number of entries.
+Object* CreateHashTableObject(size_t capacity, Allocator* allocator);
+bool IsHashTableKey(Value key);
+
+// The allocator is used to grow the table and to flatten string keys.
+void HashTablePut(Object* table, Value key, Value value, Allocator* allocator);
+bool HashTableGet(Object* table, Value key, Value* value, Allocator* allocator);
+// Returns true if the key was in the table.
+bool HashTableRemove(Object* table, Value key, Allocator* allocator);
+
+#endif
@@ -0,0 +1,291 @@
+#include "lazyseq.h"
+#include "asserts.h"
+
+#define LINE_INITIAL_CAPACITY 128
+
+// -- Sequences --
+
+static Object* AllocateSeq(SeqKind kind, Allocator* allocator) {
+    Object* seq = AllocateObject(OBJECT_LAZY_SEQ, OBJECT_SIZE(lazySeq), allocator);
+    seq->as.lazySeq.kind = kind;
+    return seq;
+}
+
+Object* CreateRangeSeq(int32_t start, int32_t end, Allocator* allocator) {
+    Object* seq = AllocateSeq(SEQ_RANGE, allocator);
+    seq->as.lazySeq.as.range.start = start;
+    seq->as.lazySeq.as.range.end = end;
+    return seq;
+}
+
+Object* CreateIterateSeq(Value fn, Value seed, Allocator* allocator) {
+    Object* seq = AllocateSeq(SEQ_ITERATE, allocator);
+    seq->as.lazySeq.as.iterate.fn = fn;
+    seq->as.lazySeq.as.iterate.seed = seed;
+    return seq;
+}
+
+Object* CreateLinesSeq(Object* path, Allocator* allocator) {
+    Assert(path->type == OBJECT_STRING, "Expected the path to be a string");
+    Object* seq = AllocateSeq(SEQ_LINES, allocator);
+    seq->as.lazySeq.as.path = path;
+    return seq;
+}
+
+Object* CreateTransformSeq(SeqKind kind, Value fn, Value source, Allocator* allocator) {
+    Assert(kind == SEQ_MAP || kind == SEQ_FILTER, "Expected a map or a filter");
+    Assert(IsSeqSource(source), "Expected a sequence, list or vector");
+    Object* seq = AllocateSeq(kind, allocator);
+    seq->as.lazySeq.as.transform.fn = fn;
+    seq->as.lazySeq.as.transform.source = source;
+    return seq;
+}
+
+Object* CreateTakeSeq(uint32_t count, Value source, Allocator* allocator) {
+    Assert(IsSeqSource(source), "Expected a sequence, list or vector");
+    Object* seq = AllocateSeq(SEQ_TAKE, allocator);
+    seq->as.lazySeq.as.take.count = count;
+    seq->as.lazySeq.as.take.source = source;
+    return seq;
+}
+
+bool IsSeqSource(Value v) {
+    if (GetValueType(v) == VALUE_NIL) {
+        return true;
+    } else if (GetValueType(v) != VALUE_OBJECT) {
+        return false;
+    }
+    ObjectType type = ValueAsObject(v)->type;
+    return type == OBJECT_LAZY_SEQ || type == OBJECT_CONS || type == OBJECT_VECTOR;
+}
+
+bool IsTruthy(Value v) {
+    return !(GetValueType(v) == VALUE_NIL || (GetValueType(v) == VALUE_BOOL && !ValueAsBool(v)));
+}
+
+// -- Cursors --
+
+static bool IsLazySeq(Value v) {
+    return GetValueType(v) == VALUE_OBJECT && ValueAsObject(v)->type == OBJECT_LAZY_SEQ;
+}
+
+// The sequence that a map, filter or take pulls from, or nil at the end of the chain.
+static bool TryGetSource(Value seq, Value* source) {
+    if (!IsLazySeq(seq)) {
+        return false;
+    }
+    LazySeqData* data = &ValueAsObject(seq)->as.lazySeq;
+    switch (data->kind) {
+        case SEQ_MAP:
+        case SEQ_FILTER:
+            *source = data->as.transform.source;
+            return true;
+        case SEQ_TAKE:
+            *source = data->as.take.source;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void InitLevel(SeqCursorLevel* level, Value seq) {
+    *level = (SeqCursorLevel) { .seq = seq };
+    if (!IsLazySeq(seq)) {
+        if (GetValueType(seq) == VALUE_OBJECT && ValueAsObject(seq)->type == OBJECT_VECTOR) {
+            level->as.index = 0;
+        } else {
+            level->as.rest = seq;
+        }
+        return;
+    }
+
+    LazySeqData* data = &ValueAsObject(seq)->as.lazySeq;
+    switch (data->kind) {
+        case SEQ_RANGE:
+            level->as.next = data->as.range.start;
+            break;
+        case SEQ_ITERATE:
+            level->as.iterate.current = data->as.iterate.seed;
+            level->as.iterate.isStarted = false;
+            break;
+        case SEQ_TAKE:
+            level->as.remaining = data->as.take.count;
+            break;
+        default:
+            // files are opened on the first read, so that a sequence that is never read is never opened
+            break;
+    }
+}
+
+void OpenSeqCursor(SeqCursor* cursor, Value seq, SeqApplyFunc apply, void* ctx, Allocator* allocator) {
+    Assert(IsSeqSource(seq), "Expected a sequence, list or vector");
+
+    size_t numLevels = 1;
+    for (Value v = seq; TryGetSource(v, &v); ) {
+        numLevels++;
+    }
+
+    *cursor = (SeqCursor) {
+        .levels = AllocateArray(NULL, numLevels, sizeof(SeqCursorLevel)),
+        .numLevels = numLevels,
+        .apply = apply,
+        .ctx = ctx,
+        .allocator = allocator,
+    };
+
+    Value v = seq;
+    for (size_t i = 0; i < numLevels; i++) {
+        InitLevel(&cursor->levels[i], v);
+        TryGetSource(v, &v);
+    }
+}
+
+void CloseSeqCursor(SeqCursor* cursor) {
+    for (size_t i = 0; i < cursor->numLevels; i++) {
+        SeqCursorLevel* level = &cursor->levels[i];
+        if (IsLazySeq(level->seq) && ValueAsObject(level->seq)->as.lazySeq.kind == SEQ_LINES) {
+            if (level->as.lines.file != NULL) {
+                fclose(level->as.lines.file);
+            }
+            FreeMemory(level->as.lines.line);
+        }
+    }
+    FreeMemory(cursor->levels);
+    *cursor = (SeqCursor) {0};
+}
+
+// Reads up to the next line break into the buffer of the level, which is reused for every line.
+static SeqNextResult ReadLine(SeqCursor* cursor, SeqCursorLevel* level, Value* value) {
+    if (level->as.lines.file == NULL) {
+        Object* path = ValueAsObject(level->seq)->as.lazySeq.as.path;
+        level->as.lines.capacity = path->as.string.length + 1 > LINE_INITIAL_CAPACITY
+            ? path->as.string.length + 1
+            : LINE_INITIAL_CAPACITY;
+        level->as.lines.line = AllocateArray(NULL, level->as.lines.capacity, sizeof(char));
+
+        CopyStringChars(path, level->as.lines.line);
+        level->as.lines.line[path->as.string.length] = '\0';
+        level->as.lines.file = fopen(level->as.lines.line, "r");
+        if (level->as.lines.file == NULL) {
+            cursor->error = "Unable to open the file of a lazy sequence.";
+            return SEQ_NEXT_ERROR;
+        }
+    }
+
+    size_t length = 0;
+    int c = 0;
+    while ((c = fgetc(level->as.lines.file)) != EOF && c != '\n') {
+        if (length == level->as.lines.capacity) {
+            level->as.lines.capacity *= 2;
+            level->as.lines.line = AllocateArray(level->as.lines.line, level->as.lines.capacity, sizeof(char));
+        }
+        level->as.lines.line[length++] = c;
+    }
+    if (ferror(level->as.lines.file)) {
+        cursor->error = "Unable to read the file of a lazy sequence.";
+        return SEQ_NEXT_ERROR;
+    } else if (c == EOF && length == 0) {
+        return SEQ_NEXT_END;
+    } else if (length > UINT32_MAX) {
+        cursor->error = "Unable to read a line that is too long.";
+        return SEQ_NEXT_ERROR;
+    }
+
+    String line = { .start = level->as.lines.line, .length = length };
+    *value = MAKE_VALUE_OBJECT(CreateStringObject(line, cursor->allocator));
+    return SEQ_NEXT_VALUE;
+}
+
+static SeqNextResult NextAt(SeqCursor* cursor, size_t i, Value* value) {
+    SeqCursorLevel* level = &cursor->levels[i];
+    Value seq = level->seq;
+
+    if (!IsLazySeq(seq)) {
+        if (GetValueType(seq) == VALUE_OBJECT && ValueAsObject(seq)->type == OBJECT_VECTOR) {
+            VectorData* vector = &ValueAsObject(seq)->as.vector;
+            if (level->as.index >= vector->count) {
+                return SEQ_NEXT_END;
+            }
+            *value = vector->items[level->as.index++];
+            return SEQ_NEXT_VALUE;
+        }
+
+        Value rest = level->as.rest;
+        if (GetValueType(rest) != VALUE_OBJECT || ValueAsObject(rest)->type != OBJECT_CONS) {
+            return SEQ_NEXT_END;
+        }
+        *value = ConsHead(ValueAsObject(rest));
+        level->as.rest = ConsTail(ValueAsObject(rest));
+        return SEQ_NEXT_VALUE;
+    }
+
+    LazySeqData* data = &ValueAsObject(seq)->as.lazySeq;
+    switch (data->kind) {
+        case SEQ_RANGE:
+            if (level->as.next >= data->as.range.end) {
+                return SEQ_NEXT_END;
+            }
+            *value = MAKE_VALUE_I32(level->as.next++);
+            return SEQ_NEXT_VALUE;
+        case SEQ_ITERATE:
+            if (level->as.iterate.isStarted
+                    && !cursor->apply(data->as.iterate.fn, level->as.iterate.current, &level->as.iterate.current, cursor->ctx)) {
+                return SEQ_NEXT_ERROR;
+            }
+            level->as.iterate.isStarted = true;
+            *value = level->as.iterate.current;
+            return SEQ_NEXT_VALUE;
+        case SEQ_LINES:
+            return ReadLine(cursor, level, value);
+        case SEQ_MAP: {
+            Value element = MAKE_VALUE_NIL();
+            SeqNextResult next = NextAt(cursor, i + 1, &element);
+            if (next != SEQ_NEXT_VALUE) {
+                return next;
+            }
+            return cursor->apply(data->as.transform.fn, element, value, cursor->ctx) ? SEQ_NEXT_VALUE : SEQ_NEXT_ERROR;
+        }
+        case SEQ_FILTER:
+            for (;;) {
+                Value element = MAKE_VALUE_NIL();
+                SeqNextResult next = NextAt(cursor, i + 1, &element);
+                if (next != SEQ_NEXT_VALUE) {
+                    return next;
+                }
+                Value keep = MAKE_VALUE_NIL();
+                if (!cursor->apply(data->as.transform.fn, element, &keep, cursor->ctx)) {
+                    return SEQ_NEXT_ERROR;
+                } else if (IsTruthy(keep)) {
+                    *value = element;
+                    return SEQ_NEXT_VALUE;
+                }
+            }
+        case SEQ_TAKE:
+            // the source is not read past the last element that is taken
+            if (level->as.remaining == 0) {
+                return SEQ_NEXT_END;
+            }
+            level->as.remaining--;
+            return NextAt(cursor, i + 1, value);
+        default:
+            AssertFailf("Unexpected lazy sequence kind %d", data->kind);
+            return SEQ_NEXT_ERROR;
+    }
+}
+
+bool SeqCursorKeepsObjects(SeqCursor* cursor) {
+    // the other levels only keep positions in their sources, which are older than the cursor
+    for (size_t i = 0; i < cursor->numLevels; i++) {
+        SeqCursorLevel* level = &cursor->levels[i];
+        if (IsLazySeq(level->seq) && ValueAsObject(level->seq)->as.lazySeq.kind == SEQ_ITERATE
+                && GetValueType(level->as.iterate.current) == VALUE_OBJECT) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SeqNextResult NextSeqValue(SeqCursor* cursor, Value* value) {
+    cursor->error = NULL;
+    return NextAt(cursor, 0, value);
+}
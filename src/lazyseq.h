@@ -0,0 +1,82 @@
+/*
+ * Lazy sequences are suspended descriptions of their elements: a range, the
+ * repeated application of a function, the lines of a file, or a map, filter
+ * or take of another sequence. Nothing is produced when a sequence is built.
+ *
+ * A consumer opens a cursor, which pulls one element at a time through the
+ * whole chain. The cursor only keeps the state of each link in the chain, so
+ * consuming a sequence takes the same memory however long the sequence is.
+ * A sequence can be consumed any number of times, and a file is read again
+ * every time.
+ *
+ * Lists and vectors can be the source of a map, filter or take, and they
+ * are consumed the same way.
+ */
+#ifndef lazyseq_h
+#define lazyseq_h
+
+#include <stdio.h>
+#include "values.h"
+
+// The integers from start up to, but not including, end.
+Object* CreateRangeSeq(int32_t start, int32_t end, Allocator* allocator);
+// The seed, then the function applied to the previous element, without end.
+Object* CreateIterateSeq(Value fn, Value seed, Allocator* allocator);
+// The lines of a file as strings, without the line breaks.
+Object* CreateLinesSeq(Object* path, Allocator* allocator);
+// Either SEQ_MAP or SEQ_FILTER. The source is a lazy sequence, a list or a vector.
+Object* CreateTransformSeq(SeqKind kind, Value fn, Value source, Allocator* allocator);
+Object* CreateTakeSeq(uint32_t count, Value source, Allocator* allocator);
+
+// Lazy sequences, proper lists and vectors.
+bool IsSeqSource(Value v);
+// Everything but nil and false.
+bool IsTruthy(Value v);
+
+// Calls a function with one argument. Returns false if the call fails.
+typedef bool (*SeqApplyFunc)(Value fn, Value arg, Value* result, void* ctx);
+
+typedef enum {
+    SEQ_NEXT_VALUE,
+    SEQ_NEXT_END,
+    SEQ_NEXT_ERROR,
+} SeqNextResult;
+
+typedef struct {
+    Value seq;
+    union {
+        Value rest;
+        uint32_t index;
+        int64_t next;
+        struct {
+            Value current;
+            bool isStarted;
+        } iterate;
+        struct {
+            FILE* file;
+            char* line;
+            size_t capacity;
+        } lines;
+        uint32_t remaining;
+    } as;
+} SeqCursorLevel;
+
+typedef struct {
+    // from the sequence that is consumed down to its innermost source
+    SeqCursorLevel* levels;
+    size_t numLevels;
+    SeqApplyFunc apply;
+    void* ctx;
+    Allocator* allocator;
+    // why the last call to NextSeqValue failed, unless the function call failed
+    const char* error;
+} SeqCursor;
+
+void OpenSeqCursor(SeqCursor* cursor, Value seq, SeqApplyFunc apply, void* ctx, Allocator* allocator);
+SeqNextResult NextSeqValue(SeqCursor* cursor, Value* value);
+// True if the cursor keeps an object from the last element to compute the next one.
+bool SeqCursorKeepsObjects(SeqCursor* cursor);
+// Releases the cursor and closes the files that it reads.
+void CloseSeqCursor(SeqCursor* cursor);
+
+#endif
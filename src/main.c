@@ -9,6 +9,8 @@
 #define TOKENS_DEFAULT_CAPACITY 256
 #define AST_PAGE_SIZE 256
 #define AST_NUM_PAGES 1
+#define RUNTIME_PAGE_SIZE 4096
+#define RUNTIME_NUM_PAGES 1
 
 // TODO(incomplete): Consider repl vs not repl. Currently not repl.
 int main() {
@@ -27,22 +29,27 @@ int main() {
         return 1;
     }
 
-    Allocator* allocator = CreateBumpAllocator(AST_PAGE_SIZE, AST_NUM_PAGES);
-    ParseResult parseResult = ParseTokens(tokens, allocator);
+    // the AST only lives until the bytecode is generated, runtime objects live on
+    Allocator* compileAllocator = CreateBumpAllocator(AST_PAGE_SIZE, AST_NUM_PAGES);
+    Allocator* runtimeAllocator = CreateBumpAllocator(RUNTIME_PAGE_SIZE, RUNTIME_NUM_PAGES);
+
+    ParseResult parseResult = ParseTokens(tokens, compileAllocator);
     if (parseResult.type == RESULT_ERROR) {
         PrintParseResult(parseResult);
         return 1;
     }
 
     Ast* ast = parseResult.as.success.ast;
-    ByteCodeResult byteCodeResult = GenerateByteCode(ast, allocator);
+    ByteCodeResult byteCodeResult = GenerateByteCode(ast, runtimeAllocator);
     if (byteCodeResult.type == RESULT_ERROR) {
         PrintByteCodeResult(byteCodeResult);
         return 1;
     }
+    AllocatorReset(compileAllocator);
 
     ByteDa byteCode = byteCodeResult.as.success.byteCode;
-    VmResult vmResult = ExecuteByteCode(byteCode, allocator);
+    ValueDa constants = byteCodeResult.as.success.constants;
+    VmResult vmResult = ExecuteByteCode(byteCode, constants, runtimeAllocator);
     if (vmResult.type == RESULT_ERROR) {
         PrintVmResult(vmResult);
         return 1;
@@ -1,4 +1,12 @@
 #include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include "memory.h"
 #include "da.h"
 #include "asserts.h"
@@ -19,26 +27,130 @@ void* AllocateZeros(size_t bytes) {
     return result;
 }
 
+void* AllocateAligned(size_t bytes, size_t alignment) {
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+    // aligned_alloc requires the size to be a multiple of the alignment
+    void* result = aligned_alloc(alignment, RoundUp(bytes > 0 ? bytes : 1, alignment));
+    Assert(result != NULL, "Failed to allocate aligned memory.");
+
+    return result;
+}
+
 void FreeMemory(void* ptr) {
     free(ptr);
 }
 
+size_t RoundUp(size_t n, size_t multiple) {
+    return (n + multiple - 1) / multiple * multiple;
+}
+
 // -- Arena allocation --
 
 typedef struct Allocator {
-    void* (*Alloc)(size_t bytes, struct Allocator* self);
+    AllocatorFastPath fastPath;
+    void* (*Alloc)(size_t bytes, size_t alignment, struct Allocator* self);
     void (*Reset)(struct Allocator* self);
     void (*Free)(struct Allocator* self);
     void (*FreeObject)(void* ptr, size_t bytes, struct Allocator* self);
     void (*Debug)(struct Allocator* self);
+    // Optional. Creates and releases arena marks.
+    ArenaMark (*Mark)(struct Allocator* self);
+    void (*Release)(ArenaMark mark, struct Allocator* self);
+    /*
+     * Optional. Allocators with a fast path store its cursor before they are
+     * called, and expose their current block again afterwards.
+     */
+    void (*SaveFastPath)(struct Allocator* self);
+    void (*LoadFastPath)(struct Allocator* self);
+    // Optional. Updates the stats before they are read.
+    void (*CollectStats)(struct Allocator* self);
+    AllocatorStats stats;
+    // bytes to keep on reset, see AllocatorSetRetention
+    size_t retentionBytes;
+    /*
+     * Thread safe allocators can not have their stats updated here without
+     * synchronization, so they keep them on their own with CollectStats.
+     */
+    bool isThreadSafe;
 } Allocator;
 
-void* AllocatorAlloc(size_t bytes, Allocator* allocator) {
-    return allocator->Alloc(bytes, allocator);
+/*
+ * The allocator interface keeps the request counters. The implementations
+ * only keep the counters about the memory they hold, see the helpers below.
+ */
+static void AddReserved(Allocator* allocator, size_t bytes, size_t numPages) {
+    AllocatorStats* stats = &allocator->stats;
+    stats->bytesReserved += bytes;
+    stats->numPages += numPages;
+    if (stats->bytesReserved > stats->highWaterMark) {
+        stats->highWaterMark = stats->bytesReserved;
+    }
+}
+
+static void RemoveReserved(Allocator* allocator, size_t bytes, size_t numPages) {
+    allocator->stats.bytesReserved -= bytes;
+    allocator->stats.numPages -= numPages;
+}
+
+static void AddFastPathStats(AllocatorStats* stats, AllocatorFastPath* fastPath) {
+    stats->numAllocs += fastPath->numAllocs;
+    stats->bytesRequested += fastPath->bytesRequested;
+    stats->bytesInUse += fastPath->bytesRequested;
+    stats->wastedBytes += fastPath->wastedBytes;
+}
+
+// Brings the allocator up to date with the allocations made on the fast path.
+static void SaveFastPath(Allocator* allocator) {
+    // shared between threads, so there is no fast path
+    if (allocator->isThreadSafe) {
+        return;
+    }
+    AllocatorFastPath* fastPath = &allocator->fastPath;
+    AddFastPathStats(&allocator->stats, fastPath);
+    fastPath->numAllocs = 0;
+    fastPath->bytesRequested = 0;
+    fastPath->wastedBytes = 0;
+
+    if (allocator->SaveFastPath != NULL) {
+        allocator->SaveFastPath(allocator);
+    }
+}
+
+static void LoadFastPath(Allocator* allocator) {
+    if (allocator->LoadFastPath != NULL) {
+        allocator->LoadFastPath(allocator);
+    }
+}
+
+void* AllocatorAllocAligned(size_t bytes, size_t alignment, Allocator* allocator) {
+    Assertf(alignment > 0 && (alignment & (alignment - 1)) == 0,
+            "Alignment must be a power of two, but was %ld", alignment);
+
+    SaveFastPath(allocator);
+    void* result = allocator->Alloc(bytes, alignment, allocator);
+    if (result != NULL && !allocator->isThreadSafe) {
+        AllocatorStats* stats = &allocator->stats;
+        stats->numAllocs++;
+        stats->bytesRequested += bytes;
+        stats->bytesInUse += bytes;
+    }
+    LoadFastPath(allocator);
+    return result;
 }
 
 void AllocatorReset(Allocator* allocator) {
+    SaveFastPath(allocator);
     allocator->Reset(allocator);
+    if (!allocator->isThreadSafe) {
+        allocator->stats.bytesInUse = 0;
+    }
+    LoadFastPath(allocator);
+}
+
+void AllocatorSetRetention(size_t bytes, Allocator* allocator) {
+    allocator->retentionBytes = bytes;
 }
 
 void AllocatorFree(Allocator* allocator) {
@@ -46,11 +158,71 @@ void AllocatorFree(Allocator* allocator) {
 }
 
 void AllocatorFreeObject(void* ptr, size_t bytes, Allocator* allocator) {
+    if (ptr == NULL) {
+        return;
+    }
+    SaveFastPath(allocator);
     allocator->FreeObject(ptr, bytes, allocator);
+    if (!allocator->isThreadSafe) {
+        allocator->stats.numFrees++;
+        allocator->stats.bytesInUse -= bytes;
+    }
+    LoadFastPath(allocator);
+}
+
+ArenaMark AllocatorMark(Allocator* allocator) {
+    if (allocator->Mark == NULL) {
+        return (ArenaMark) {0};
+    }
+    SaveFastPath(allocator);
+    ArenaMark mark = allocator->Mark(allocator);
+    mark.bytesInUse = allocator->stats.bytesInUse;
+    mark.wastedBytes = allocator->stats.wastedBytes;
+    LoadFastPath(allocator);
+    return mark;
+}
+
+void AllocatorRelease(ArenaMark mark, Allocator* allocator) {
+    if (allocator->Release == NULL) {
+        return;
+    }
+    SaveFastPath(allocator);
+    allocator->Release(mark, allocator);
+    LoadFastPath(allocator);
+
+    // objects from before the mark may have been freed in the meantime
+    AllocatorStats* stats = &allocator->stats;
+    if (mark.bytesInUse < stats->bytesInUse) {
+        stats->bytesInUse = mark.bytesInUse;
+    }
+    stats->wastedBytes = mark.wastedBytes;
+}
+
+AllocatorStats AllocatorGetStats(Allocator* allocator) {
+    if (allocator->CollectStats != NULL) {
+        allocator->CollectStats(allocator);
+    }
+    // reading the stats leaves the fast path alone
+    AllocatorStats stats = allocator->stats;
+    AddFastPathStats(&stats, &allocator->fastPath);
+    return stats;
+}
+
+void PrintAllocatorStats(AllocatorStats stats) {
+    printf("Allocator stats\n");
+    printf("  requested: %ld bytes in %ld allocations\n", stats.bytesRequested, stats.numAllocs);
+    printf("  freed: %ld allocations\n", stats.numFrees);
+    printf("  in use: %ld bytes\n", stats.bytesInUse);
+    printf("  reserved: %ld bytes in %ld pages\n", stats.bytesReserved, stats.numPages);
+    printf("  high-water mark: %ld bytes\n", stats.highWaterMark);
+    printf("  wasted: %ld bytes\n", stats.wastedBytes);
 }
 
 void AllocatorDebug(Allocator* allocator) {
+    SaveFastPath(allocator);
+    PrintAllocatorStats(allocator->stats);
     allocator->Debug(allocator);
+    LoadFastPath(allocator);
 }
 
 static void AllocatorStub(Allocator* self) {
@@ -58,8 +230,15 @@ static void AllocatorStub(Allocator* self) {
 
 // -- Heap allocator --
 
-static void* AllocHeap(size_t bytes, Allocator* self) {
-    return AllocateZeros(bytes);
+static void* AllocHeap(size_t bytes, size_t alignment, Allocator* self) {
+    AddReserved(self, bytes, 0);
+    if (alignment <= alignof(max_align_t)) {
+        return AllocateZeros(bytes);
+    }
+
+    void* result = AllocateAligned(bytes, alignment);
+    memset(result, 0, bytes);
+    return result;
 }
 
 static void FreeHeap(Allocator* self) {
@@ -68,6 +247,7 @@ static void FreeHeap(Allocator* self) {
 }
 
 static void FreeObjectHeap(void* ptr, size_t bytes, Allocator* self) {
+    RemoveReserved(self, bytes, 0);
     FreeMemory(ptr);
 }
 
@@ -84,6 +264,83 @@ Allocator* CreateHeapAllocator() {
     return allocator;
 }
 
+// -- Free lists --
+/*
+ * Freed objects are recycled through intrusive free lists, one list per
+ * object size. The link to the next free block is stored inside the freed
+ * block itself, so there is no bookkeeping memory per block. Blocks that are
+ * too small to hold the link are not recycled.
+ *
+ * Most allocations come in a handful of sizes (AST nodes, objects), so the
+ * lists are kept in a small array that is searched linearly.
+ */
+typedef struct FreeBlock {
+    struct FreeBlock* next;
+} FreeBlock;
+
+typedef struct {
+    size_t bytes;
+    FreeBlock* head;
+} FreeList;
+
+DA_DECLARE(FreeList);
+
+static FreeList* FindFreeList(FreeListDa* lists, size_t bytes) {
+    for (size_t i = 0; i < lists->count; i++) {
+        if (lists->items[i].bytes == bytes) {
+            return &lists->items[i];
+        }
+    }
+    return NULL;
+}
+
+static void PushFreeBlock(FreeListDa* lists, void* ptr, size_t bytes) {
+    if (ptr == NULL || bytes < sizeof(FreeBlock)) {
+        return;
+    }
+
+    FreeList* list = FindFreeList(lists, bytes);
+    if (list == NULL) {
+        FreeList newList = { .bytes = bytes, .head = NULL };
+        DA_APPEND(lists, newList);
+        list = &lists->items[lists->count - 1];
+    }
+
+    FreeBlock* block = ptr;
+    block->next = list->head;
+    list->head = block;
+}
+
+// The sizes to keep off the fast path, see FastPathSizeClass.
+static uint64_t RecycledSizeClasses(FreeListDa* lists) {
+    uint64_t sizeClasses = 0;
+    for (size_t i = 0; i < lists->count; i++) {
+        if (lists->items[i].head != NULL) {
+            sizeClasses |= FastPathSizeClass(lists->items[i].bytes);
+        }
+    }
+    return sizeClasses;
+}
+
+/*
+ * Every block is aligned to at least the natural alignment of its size,
+ * so a block can only be re-used when no stricter alignment is requested.
+ */
+static void* PopFreeBlock(FreeListDa* lists, size_t bytes, size_t alignment) {
+    if (alignment > DefaultAlignment(bytes)) {
+        return NULL;
+    }
+
+    FreeList* list = FindFreeList(lists, bytes);
+    if (list == NULL || list->head == NULL) {
+        return NULL;
+    }
+
+    FreeBlock* block = list->head;
+    list->head = block->next;
+    return block;
+}
+
 // -- Bump allocator --
 /*
  * Page = sequence of bytes
@@ -95,76 +352,180 @@ Allocator* CreateHeapAllocator() {
  *
  * The arena is also represented as a dynamic array.
  * That one is dynamic, but grows by only one page at a time.
+ *
+ * Freed objects are kept in per-size free lists and handed out
+ * again before bumping.
+ *
+ * Pages are aligned to BUMP_PAGE_ALIGNMENT, so that objects with a stricter
+ * alignment than the default, like SIMD buffers, can be carved out of them.
+ * Aligning an object may leave some padding before it.
+ *
+ * Large objects = objects greater than the page size
+ *
+ * These get a dedicated block each, outside of the pages. The blocks
+ * are tracked in a separate list so that they can be released
+ * on reset. Freeing a large object releases its block right away.
+ * Objects aligned more strictly than the pages are handled the same way.
+ *
+ * Fast path = the rest of the current page
+ *
+ * While the fast path is in use, the cursor is ahead of the count of
+ * the current page. The count is caught up before every other operation.
+ * Freed objects are only recycled here, so the sizes that have any
+ * are kept off the fast path.
+ *
+ * Mark = page index + offset within the page
+ *
+ * Releasing a mark moves the current page and its count back. The pages
+ * after it are emptied but kept. Large objects are numbered in order of
+ * creation and kept in that order, so the ones created after the mark
+ * are found at the end of the list.
  */
 DA_DECLARE(ByteDa); // the legandary ByteDaDa
 
+typedef struct {
+    Byte* block;
+    size_t bytes;
+    size_t id;
+} LargeObject;
+
+DA_DECLARE(LargeObject);
+
+#define BUMP_PAGE_ALIGNMENT 64
+
 typedef struct {
     Allocator base;
     ByteDaDa arena;
     size_t pageSize;
     size_t initialNumPages;
     size_t currentPage;
+    FreeListDa freeLists;
+    LargeObjectDa largeObjects;
+    size_t nextLargeObjectId;
 } BumpAllocator;
 
-static void* AllocBump(size_t bytes, Allocator* self) {
+static ByteDa MakePageBump(BumpAllocator* allocator) {
+    ByteDa page = {
+        .items = AllocateAligned(allocator->pageSize, BUMP_PAGE_ALIGNMENT),
+        .count = 0,
+        .capacity = allocator->pageSize,
+    };
+    AddReserved(&allocator->base, allocator->pageSize, 1);
+    return page;
+}
+
+static void FreePageBump(ByteDa* page, BumpAllocator* allocator) {
+    if (page->items != NULL) {
+        RemoveReserved(&allocator->base, allocator->pageSize, 1);
+    }
+    DA_FREE(page);
+}
+
+static size_t PaddingBump(ByteDa* page, size_t alignment) {
+    uintptr_t address = (uintptr_t)&page->items[page->count];
+    return (alignment - (address & (alignment - 1))) & (alignment - 1);
+}
+
+static void* AllocLargeObjectBump(size_t bytes, size_t alignment, BumpAllocator* allocator) {
+    LargeObject largeObject = {
+        .block = AllocateAligned(bytes, alignment),
+        .bytes = bytes,
+        .id = allocator->nextLargeObjectId++,
+    };
+    DA_APPEND(&allocator->largeObjects, largeObject);
+    AddReserved(&allocator->base, bytes, 0);
+    return largeObject.block;
+}
+
+static void* AllocBump(size_t bytes, size_t alignment, Allocator* self) {
     BumpAllocator* allocator = (BumpAllocator*)self;
-    Assert(bytes <= allocator->pageSize, "Cannot allocate objects greater than the page size");
 
-    // this return is for when asserts are disabled from tests
-    if (bytes > allocator->pageSize) {
-        return NULL;
+    if (bytes > allocator->pageSize || alignment > BUMP_PAGE_ALIGNMENT) {
+        return AllocLargeObjectBump(bytes, alignment, allocator);
+    }
+
+    void* recycled = PopFreeBlock(&allocator->freeLists, bytes, alignment);
+    if (recycled != NULL) {
+        return recycled;
     }
 
     ByteDaDa* arena = &allocator->arena;
 
     ByteDa* lastPage = &allocator->arena.items[allocator->currentPage];
     size_t bytesAvailable = lastPage->capacity - lastPage->count;
+    size_t padding = PaddingBump(lastPage, alignment);
 
-    if (bytes > bytesAvailable) {
-        ByteDa newPage = DA_MAKE_CAPACITY(Byte, allocator->pageSize);
+    if (padding + bytes > bytesAvailable) {
+        self->stats.wastedBytes += bytesAvailable;
 
-        DA_APPEND_GROW_ONE(arena, newPage);
+        // move on to the next page, which may be left over from before a reset
         allocator->currentPage++;
+        if (allocator->currentPage == arena->count) {
+            DA_APPEND_GROW_ONE(arena, MakePageBump(allocator));
+        }
 
         lastPage = &arena->items[allocator->currentPage];
+        padding = 0; // pages are aligned
     }
 
-    void* bytesStart = &lastPage->items[lastPage->count];
-    lastPage->count += bytes;
+    void* bytesStart = &lastPage->items[lastPage->count + padding];
+    lastPage->count += padding + bytes;
+    self->stats.wastedBytes += padding;
     return bytesStart;
 }
 
+static void FreeLargeObjectsBump(BumpAllocator* allocator) {
+    LargeObjectDa* largeObjects = &allocator->largeObjects;
+    for (size_t i = 0; i < largeObjects->count; i++) {
+        RemoveReserved(&allocator->base, largeObjects->items[i].bytes, 0);
+        FreeMemory(largeObjects->items[i].block);
+    }
+    largeObjects->count = 0;
+}
+
 static void ResetBump(Allocator* self) {
     BumpAllocator* allocator = (BumpAllocator*)self;
     ByteDaDa* arena = &allocator->arena;
 
-    // free the extra pages
-    for (int i = allocator->initialNumPages; i < arena->count; i++) {
-        DA_FREE(&arena->items[i]);
+    FreeLargeObjectsBump(allocator);
+
+    size_t numKeep = self->retentionBytes / allocator->pageSize;
+    if (numKeep < allocator->initialNumPages) {
+        numKeep = allocator->initialNumPages;
     }
-    // shrink capacity
-    if (arena->count > allocator->initialNumPages) {
-        arena->items = AllocateArray(arena->items, allocator->initialNumPages, sizeof(ByteDa));
+
+    // free the extra pages and shrink capacity, warm arenas are left as they are
+    if (arena->count > numKeep) {
+        for (size_t i = numKeep; i < arena->count; i++) {
+            FreePageBump(&arena->items[i], allocator);
+        }
+        arena->items = AllocateArray(arena->items, numKeep, sizeof(ByteDa));
+        arena->count = numKeep;
+        arena->capacity = numKeep;
     }
 
     // reset counters
-    arena->count = allocator->initialNumPages;
-    arena->capacity = allocator->initialNumPages;
-    for (int i = 0; i < allocator->initialNumPages; i++) {
+    for (size_t i = 0; i < arena->count; i++) {
         arena->items[i].count = 0;
     }
     allocator->currentPage = 0;
+    self->stats.wastedBytes = 0;
+
+    // the recycled blocks point into the pages that were just reset
+    allocator->freeLists.count = 0;
 }
 
 static void InitArenaBump(BumpAllocator* allocator) {
     ByteDaDa arena = DA_MAKE_CAPACITY(ByteDa, allocator->initialNumPages);
     for (int i = 0; i < allocator->initialNumPages; i++) {
-        ByteDa page = DA_MAKE_CAPACITY(Byte, allocator->pageSize);
+        ByteDa page = MakePageBump(allocator);
         // avoid DA_APPEND utils to make sure there's no resizing
         arena.items[arena.count++] = page;
     }
 
     allocator->arena = arena;
+    allocator->freeLists = DA_MAKE_DEFAULT(FreeList);
+    allocator->largeObjects = DA_MAKE_DEFAULT(LargeObject);
 }
 
 static void FreeBump(Allocator* self) {
@@ -175,15 +536,99 @@ static void FreeBump(Allocator* self) {
         DA_FREE(&arena->items[i]);
     }
     DA_FREE(arena);
+    DA_FREE(&allocator->freeLists);
+    FreeLargeObjectsBump(allocator);
+    DA_FREE(&allocator->largeObjects);
 
     *allocator = (BumpAllocator) {0};
     FreeMemory(allocator);
 }
 
+// Returns false if the object does not have a dedicated block.
+static bool TryFreeLargeObjectBump(void* ptr, BumpAllocator* allocator) {
+    LargeObjectDa* largeObjects = &allocator->largeObjects;
+    for (size_t i = 0; i < largeObjects->count; i++) {
+        if (largeObjects->items[i].block == ptr) {
+            RemoveReserved(&allocator->base, largeObjects->items[i].bytes, 0);
+            FreeMemory(ptr);
+            // keep the creation order for releasing marks
+            memmove(&largeObjects->items[i], &largeObjects->items[i + 1],
+                    (largeObjects->count - i - 1) * sizeof(LargeObject));
+            largeObjects->count--;
+            return true;
+        }
+    }
+    return false;
+}
+
 static void FreeObjectBump(void* ptr, size_t bytes, Allocator* self) {
-    // TODO(incomplete): keep track of freed sections and recycle them later
+    BumpAllocator* allocator = (BumpAllocator*)self;
+
+    // over-aligned objects get a dedicated block too, whatever their size
+    if (TryFreeLargeObjectBump(ptr, allocator)) {
+        return;
+    }
+    Assert(bytes <= allocator->pageSize, "Freed a large object that is not owned by the allocator");
+    PushFreeBlock(&allocator->freeLists, ptr, bytes);
+}
+
+static void SaveFastPathBump(Allocator* self) {
+    BumpAllocator* allocator = (BumpAllocator*)self;
+    if (self->fastPath.cursor != NULL) {
+        ByteDa* page = &allocator->arena.items[allocator->currentPage];
+        page->count = self->fastPath.cursor - page->items;
+    }
+}
+
+static void LoadFastPathBump(Allocator* self) {
+    BumpAllocator* allocator = (BumpAllocator*)self;
+    self->fastPath.recycledSizeClasses = RecycledSizeClasses(&allocator->freeLists);
+    ByteDa* page = &allocator->arena.items[allocator->currentPage];
+    self->fastPath.cursor = &page->items[page->count];
+    self->fastPath.limit = &page->items[page->capacity];
+}
+
+static ArenaMark MarkBump(Allocator* self) {
+    BumpAllocator* allocator = (BumpAllocator*)self;
+    return (ArenaMark) {
+        .page = allocator->currentPage,
+        .offset = allocator->arena.items[allocator->currentPage].count,
+        .largeObjectId = allocator->nextLargeObjectId,
+    };
 }
 
+static void ReleaseBump(ArenaMark mark, Allocator* self) {
+    BumpAllocator* allocator = (BumpAllocator*)self;
+    ByteDaDa* arena = &allocator->arena;
+    Assert(mark.page <= allocator->currentPage, "Released a mark that is no longer valid");
+
+    for (size_t i = mark.page + 1; i <= allocator->currentPage; i++) {
+        arena->items[i].count = 0;
+    }
+    arena->items[mark.page].count = mark.offset;
+    allocator->currentPage = mark.page;
+
+    LargeObjectDa* largeObjects = &allocator->largeObjects;
+    while (largeObjects->count > 0 && largeObjects->items[largeObjects->count - 1].id >= mark.largeObjectId) {
+        LargeObject largeObject = DA_POP(largeObjects);
+        RemoveReserved(self, largeObject.bytes, 0);
+        FreeMemory(largeObject.block);
+    }
+
+    // the recycled blocks may point into the released part of the arena
+    allocator->freeLists.count = 0;
+}
+
+static void DebugBump(Allocator* self) {
+    BumpAllocator* allocator = (BumpAllocator*)self;
+    ByteDaDa* arena = &allocator->arena;
+
+    printf("Bump allocator pages (current = %ld)\n", allocator->currentPage);
+    for (size_t i = 0; i < arena->count; i++) {
+        printf("  page %ld: %ld / %ld bytes\n", i, arena->items[i].count, arena->items[i].capacity);
+    }
+    printf("  large objects: %ld\n", allocator->largeObjects.count);
+}
 
 Allocator* CreateBumpAllocator(size_t pageSize, size_t initialNumPages) {
     BumpAllocator* allocator = AllocateZeros(sizeof(BumpAllocator));
@@ -192,12 +637,654 @@ Allocator* CreateBumpAllocator(size_t pageSize, size_t initialNumPages) {
         .base.Reset = &ResetBump,
         .base.Free = &FreeBump,
         .base.FreeObject = &FreeObjectBump,
-        .base.Debug = &AllocatorStub,
+        .base.Debug = &DebugBump,
+        .base.Mark = &MarkBump,
+        .base.Release = &ReleaseBump,
+        .base.SaveFastPath = &SaveFastPathBump,
+        .base.LoadFastPath = &LoadFastPathBump,
         .pageSize = pageSize,
         .initialNumPages = initialNumPages,
         .currentPage = 0,
     };
     InitArenaBump(allocator);
+    LoadFastPathBump(&allocator->base);
+
+    return (Allocator*)allocator;
+}
+
+// -- Slab allocator --
+/*
+ * Slab = header followed by objectsPerSlab fixed size slots
+ *
+ * Slabs are allocated with an alignment equal to their (power of two) size.
+ * That way the slab of an object is found by masking the object address,
+ * which makes freeing O(1) without any per-object header.
+ *
+ * Slots are handed out in two ways. Slots that were freed are kept in an
+ * intrusive free list within the slab. Slots that were never used are
+ * bumped from the end of the slab, so a new slab does not need to
+ * initialize its free list up front.
+ *
+ * Slabs with at least one available slot are kept in a doubly linked list,
+ * and so are the full ones. Moving a slab between the lists is O(1).
+ */
+typedef struct Slab {
+    struct Slab* next;
+    struct Slab* prev;
+    FreeBlock* freeSlots;
+    size_t numUsed;
+    size_t numBumped;
+} Slab;
+
+typedef struct {
+    Allocator base;
+    size_t slotSize;
+    size_t slotAlignment;
+    size_t objectsPerSlab;
+    size_t slabBytes;
+    size_t headerBytes;
+    Slab* availableSlabs;
+    Slab* fullSlabs;
+    size_t numEmptySlabs;
+} SlabAllocator;
+
+static size_t RoundUpPowerOfTwo(size_t n) {
+    size_t result = 1;
+    while (result < n) {
+        result *= 2;
+    }
+    return result;
+}
+
+static void PushSlab(Slab** list, Slab* slab) {
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list != NULL) {
+        (*list)->prev = slab;
+    }
+    *list = slab;
+}
+
+static void RemoveSlab(Slab** list, Slab* slab) {
+    if (slab->prev != NULL) {
+        slab->prev->next = slab->next;
+    } else {
+        *list = slab->next;
+    }
+    if (slab->next != NULL) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = NULL;
+    slab->prev = NULL;
+}
+
+static Slab* CreateSlab(SlabAllocator* allocator) {
+    Slab* slab = AllocateAligned(allocator->slabBytes, allocator->slabBytes);
+    AddReserved(&allocator->base, allocator->slabBytes, 1);
+
+    *slab = (Slab) {0};
+    return slab;
+}
+
+static Slab* FindSlab(SlabAllocator* allocator, void* ptr) {
+    return (Slab*)((uintptr_t)ptr & ~(uintptr_t)(allocator->slabBytes - 1));
+}
+
+static void* AllocSlab(size_t bytes, size_t alignment, Allocator* self) {
+    SlabAllocator* allocator = (SlabAllocator*)self;
+    Assert(bytes <= allocator->slotSize, "Cannot allocate objects greater than the slot size");
+    Assertf(alignment <= allocator->slotAlignment,
+            "Cannot align objects to more than the slot alignment %ld", allocator->slotAlignment);
+
+    // this return is for when asserts are disabled from tests
+    if (bytes > allocator->slotSize || alignment > allocator->slotAlignment) {
+        return NULL;
+    }
+
+    if (allocator->availableSlabs == NULL) {
+        PushSlab(&allocator->availableSlabs, CreateSlab(allocator));
+        allocator->numEmptySlabs++;
+    }
+
+    Slab* slab = allocator->availableSlabs;
+    void* result = NULL;
+    if (slab->freeSlots != NULL) {
+        result = slab->freeSlots;
+        slab->freeSlots = slab->freeSlots->next;
+    } else {
+        Byte* slots = (Byte*)slab + allocator->headerBytes;
+        result = &slots[slab->numBumped * allocator->slotSize];
+        slab->numBumped++;
+    }
+
+    if (slab->numUsed == 0) {
+        allocator->numEmptySlabs--;
+    }
+    slab->numUsed++;
+    self->stats.wastedBytes += allocator->slotSize - bytes;
+
+    if (slab->numUsed == allocator->objectsPerSlab) {
+        RemoveSlab(&allocator->availableSlabs, slab);
+        PushSlab(&allocator->fullSlabs, slab);
+    }
+
+    return result;
+}
+
+static void FreeObjectSlab(void* ptr, size_t bytes, Allocator* self) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    SlabAllocator* allocator = (SlabAllocator*)self;
+    Slab* slab = FindSlab(allocator, ptr);
+    Assert(slab->numUsed > 0, "Freed an object from a slab without used slots");
+
+    if (slab->numUsed == allocator->objectsPerSlab) {
+        RemoveSlab(&allocator->fullSlabs, slab);
+        PushSlab(&allocator->availableSlabs, slab);
+    }
+
+    FreeBlock* block = ptr;
+    block->next = slab->freeSlots;
+    slab->freeSlots = block;
+    slab->numUsed--;
+    self->stats.wastedBytes -= allocator->slotSize - bytes;
+
+    if (slab->numUsed > 0) {
+        return;
+    }
+
+    // keep one empty slab around to avoid thrashing at slab boundaries
+    if (allocator->numEmptySlabs == 0) {
+        allocator->numEmptySlabs++;
+        return;
+    }
+    RemoveSlab(&allocator->availableSlabs, slab);
+    RemoveReserved(&allocator->base, allocator->slabBytes, 1);
+    FreeMemory(slab);
+}
+
+static void FreeSlabList(Slab* slab, SlabAllocator* allocator) {
+    while (slab != NULL) {
+        Slab* next = slab->next;
+        RemoveReserved(&allocator->base, allocator->slabBytes, 1);
+        FreeMemory(slab);
+        slab = next;
+    }
+}
+
+static void ResetSlab(Allocator* self) {
+    SlabAllocator* allocator = (SlabAllocator*)self;
+
+    // keep one slab to start over with
+    Slab* kept = allocator->availableSlabs != NULL ? allocator->availableSlabs : allocator->fullSlabs;
+    if (kept == NULL) {
+        return;
+    }
+    Slab** keptList = kept == allocator->availableSlabs ? &allocator->availableSlabs : &allocator->fullSlabs;
+    RemoveSlab(keptList, kept);
+
+    FreeSlabList(allocator->availableSlabs, allocator);
+    FreeSlabList(allocator->fullSlabs, allocator);
+
+    *kept = (Slab) {0};
+    allocator->availableSlabs = kept;
+    allocator->fullSlabs = NULL;
+    allocator->numEmptySlabs = 1;
+    self->stats.wastedBytes = 0;
+}
+
+static void FreeSlab(Allocator* self) {
+    SlabAllocator* allocator = (SlabAllocator*)self;
+    FreeSlabList(allocator->availableSlabs, allocator);
+    FreeSlabList(allocator->fullSlabs, allocator);
+
+    *allocator = (SlabAllocator) {0};
+    FreeMemory(allocator);
+}
+
+Allocator* CreateSlabAllocator(size_t objectSize, size_t objectsPerSlab) {
+    Assert(objectsPerSlab > 0, "A slab must fit at least one object");
+
+    // every slot must be able to hold a free list link
+    size_t slotSize = RoundUp(objectSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : objectSize, sizeof(void*));
+    size_t headerBytes = RoundUp(sizeof(Slab), alignof(max_align_t));
+    size_t slabBytes = RoundUpPowerOfTwo(headerBytes + slotSize * objectsPerSlab);
+
+    SlabAllocator* allocator = AllocateZeros(sizeof(SlabAllocator));
+    *allocator = (SlabAllocator) {
+        .base.Alloc = &AllocSlab,
+        .base.Reset = &ResetSlab,
+        .base.Free = &FreeSlab,
+        .base.FreeObject = &FreeObjectSlab,
+        .base.Debug = &AllocatorStub,
+        .slotSize = slotSize,
+        // the header is aligned to max_align_t, so the slots are naturally aligned
+        .slotAlignment = DefaultAlignment(slotSize),
+        .objectsPerSlab = objectsPerSlab,
+        .slabBytes = slabBytes,
+        .headerBytes = headerBytes,
+    };
+
+    return (Allocator*)allocator;
+}
+
+// -- Virtual arena allocator --
+/*
+ * Arena = one contiguous range of reserved virtual memory
+ *
+ * The range is split into three parts.
+ *
+ * | allocated | committed, not allocated | reserved only |
+ * ^ base      ^ cursor                   ^ committed     ^ reserved
+ *
+ * Reserved memory is mapped without access rights, so it does not
+ * use any physical memory. It is committed in steps of commitBytes
+ * as the cursor reaches the end of the committed part.
+ *
+ * The committed part after the cursor is the fast path.
+ *
+ * With huge pages, the base is aligned to the huge page size so that the
+ * kernel can back the range with transparent huge pages.
+ */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+typedef struct {
+    Allocator base;
+    Byte* mapping;
+    size_t mappingBytes;
+    Byte* start;
+    Byte* cursor;
+    Byte* committed;
+    Byte* reserved;
+    size_t commitBytes;
+    VirtualArenaFlags flags;
+    FreeListDa freeLists;
+} VirtualArenaAllocator;
+
+static bool CommitVirtual(VirtualArenaAllocator* allocator, Byte* end) {
+    if (end <= allocator->committed) {
+        return true;
+    }
+    if (end > allocator->reserved) {
+        return false;
+    }
+
+    size_t missing = end - allocator->committed;
+    size_t bytes = RoundUp(missing, allocator->commitBytes);
+    if (allocator->committed + bytes > allocator->reserved) {
+        bytes = allocator->reserved - allocator->committed;
+    }
+
+    int status = mprotect(allocator->committed, bytes, PROT_READ | PROT_WRITE);
+    Assert(status == 0, "Failed to commit virtual memory.");
+    if (status != 0) {
+        return false;
+    }
+
+    allocator->committed += bytes;
+    AddReserved(&allocator->base, bytes, RoundUp(bytes, allocator->commitBytes) / allocator->commitBytes);
+    return true;
+}
+
+static void* AllocVirtual(size_t bytes, size_t alignment, Allocator* self) {
+    VirtualArenaAllocator* allocator = (VirtualArenaAllocator*)self;
+
+    void* recycled = PopFreeBlock(&allocator->freeLists, bytes, alignment);
+    if (recycled != NULL) {
+        return recycled;
+    }
+
+    Byte* start = (Byte*)RoundUp((uintptr_t)allocator->cursor, alignment);
+    Byte* end = start + bytes;
+    if (end > allocator->committed && !CommitVirtual(allocator, end)) {
+        Assert(end <= allocator->reserved, "Cannot allocate beyond the reserved virtual memory");
+        return NULL;
+    }
+
+    self->stats.wastedBytes += start - allocator->cursor;
+    allocator->cursor = end;
+    return start;
+}
+
+static void ResetVirtual(Allocator* self) {
+    VirtualArenaAllocator* allocator = (VirtualArenaAllocator*)self;
+    allocator->cursor = allocator->start;
+    allocator->freeLists.count = 0;
+    self->stats.wastedBytes = 0;
+
+    if (!(allocator->flags & VIRTUAL_ARENA_DECOMMIT_ON_RESET)) {
+        return;
+    }
+
+    // keep the first commit step or the retention, give the tail back to the OS
+    size_t keepBytes = RoundUp(self->retentionBytes, allocator->commitBytes);
+    if (keepBytes < allocator->commitBytes) {
+        keepBytes = allocator->commitBytes;
+    }
+    Byte* keep = allocator->start + keepBytes;
+    if (keep >= allocator->committed) {
+        return;
+    }
+    size_t tailBytes = allocator->committed - keep;
+    madvise(keep, tailBytes, MADV_DONTNEED);
+    mprotect(keep, tailBytes, PROT_NONE);
+    allocator->committed = keep;
+    RemoveReserved(self, tailBytes, RoundUp(tailBytes, allocator->commitBytes) / allocator->commitBytes);
+}
+
+static void SaveFastPathVirtual(Allocator* self) {
+    VirtualArenaAllocator* allocator = (VirtualArenaAllocator*)self;
+    if (self->fastPath.cursor != NULL) {
+        allocator->cursor = self->fastPath.cursor;
+    }
+}
+
+static void LoadFastPathVirtual(Allocator* self) {
+    VirtualArenaAllocator* allocator = (VirtualArenaAllocator*)self;
+    self->fastPath.recycledSizeClasses = RecycledSizeClasses(&allocator->freeLists);
+    self->fastPath.cursor = allocator->cursor;
+    self->fastPath.limit = allocator->committed;
+}
+
+static ArenaMark MarkVirtual(Allocator* self) {
+    VirtualArenaAllocator* allocator = (VirtualArenaAllocator*)self;
+    return (ArenaMark) {
+        .offset = allocator->cursor - allocator->start,
+    };
+}
+
+static void ReleaseVirtual(ArenaMark mark, Allocator* self) {
+    VirtualArenaAllocator* allocator = (VirtualArenaAllocator*)self;
+    Byte* cursor = allocator->start + mark.offset;
+    Assert(cursor <= allocator->cursor, "Released a mark that is no longer valid");
+
+    allocator->cursor = cursor;
+    allocator->freeLists.count = 0;
+}
+
+static void FreeVirtual(Allocator* self) {
+    VirtualArenaAllocator* allocator = (VirtualArenaAllocator*)self;
+    munmap(allocator->mapping, allocator->mappingBytes);
+    DA_FREE(&allocator->freeLists);
+
+    *allocator = (VirtualArenaAllocator) {0};
+    FreeMemory(allocator);
+}
+
+static void FreeObjectVirtual(void* ptr, size_t bytes, Allocator* self) {
+    VirtualArenaAllocator* allocator = (VirtualArenaAllocator*)self;
+    PushFreeBlock(&allocator->freeLists, ptr, bytes);
+}
+
+Allocator* CreateVirtualArenaAllocator(size_t reserveBytes, size_t commitBytes, VirtualArenaFlags flags) {
+    bool useHugePages = flags & VIRTUAL_ARENA_HUGE_PAGES;
+    size_t granularity = useHugePages ? HUGE_PAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+
+    reserveBytes = RoundUp(reserveBytes, granularity);
+    commitBytes = RoundUp(commitBytes > 0 ? commitBytes : 1, granularity);
+
+    // over-reserve so that the start can be aligned to the huge page size
+    size_t mappingBytes = useHugePages ? reserveBytes + HUGE_PAGE_SIZE : reserveBytes;
+    Byte* mapping = mmap(NULL, mappingBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    Assert(mapping != MAP_FAILED, "Failed to reserve virtual memory.");
+
+    Byte* start = (Byte*)RoundUp((uintptr_t)mapping, granularity);
+    if (useHugePages) {
+        madvise(start, reserveBytes, MADV_HUGEPAGE);
+    }
+
+    VirtualArenaAllocator* allocator = AllocateZeros(sizeof(VirtualArenaAllocator));
+    *allocator = (VirtualArenaAllocator) {
+        .base.Alloc = &AllocVirtual,
+        .base.Reset = &ResetVirtual,
+        .base.Free = &FreeVirtual,
+        .base.FreeObject = &FreeObjectVirtual,
+        .base.Debug = &AllocatorStub,
+        .base.Mark = &MarkVirtual,
+        .base.Release = &ReleaseVirtual,
+        .base.SaveFastPath = &SaveFastPathVirtual,
+        .base.LoadFastPath = &LoadFastPathVirtual,
+        .mapping = mapping,
+        .mappingBytes = mappingBytes,
+        .start = start,
+        .cursor = start,
+        .committed = start,
+        .reserved = start + reserveBytes,
+        .commitBytes = commitBytes,
+        .flags = flags,
+        .freeLists = DA_MAKE_DEFAULT(FreeList),
+    };
+    CommitVirtual(allocator, start + commitBytes);
+    LoadFastPathVirtual(&allocator->base);
+
+    return (Allocator*)allocator;
+}
+
+// -- Thread safe allocator --
+/*
+ * Every thread gets its own arena, which is looked up through
+ * thread-specific data. The arenas themselves are not thread safe,
+ * but they are only ever used by their own thread.
+ *
+ * Every object is preceded by a header that points to its arena.
+ *
+ * | padding | header | object |
+ * ^ block            ^ returned pointer
+ *
+ * The header is as large as the alignment, or at least max_align_t, so
+ * that the object stays aligned. The header stores log2 of its offset
+ * from the block start, which is a power of two.
+ *
+ * Objects freed by other threads are pushed onto a lock-free stack in their
+ * arena, re-using the header as the stack node. Only the owning thread
+ * pops from the stack, and it takes the whole stack at once, so the
+ * stack is safe from the ABA problem. Remote frees are recycled by the
+ * owner the next time it allocates.
+ *
+ * The arenas are kept in a lock-free list, which is only pushed to.
+ */
+typedef struct ThreadArena ThreadArena;
+
+typedef struct ThreadObjectHeader {
+    union {
+        ThreadArena* owner;
+        struct ThreadObjectHeader* nextRemoteFree;
+    } as;
+    // log2 of the offset in the lowest byte, object size in the rest
+    size_t packedSize;
+} ThreadObjectHeader;
+
+struct ThreadArena {
+    Allocator* arena;
+    ThreadArena* next;
+    _Atomic(ThreadObjectHeader*) remoteFrees;
+};
+
+typedef struct {
+    Allocator base;
+    Allocator* (*CreateArena)(void* ctx);
+    void* ctx;
+    pthread_key_t threadKey;
+    _Atomic(ThreadArena*) arenas;
+} ThreadSafeAllocator;
+
+#define THREAD_OFFSET_BITS 8
+
+static size_t Log2(size_t powerOfTwo) {
+    size_t result = 0;
+    while (powerOfTwo > 1) {
+        powerOfTwo >>= 1;
+        result++;
+    }
+    return result;
+}
+
+static ThreadObjectHeader* GetThreadObjectHeader(void* ptr) {
+    return (ThreadObjectHeader*)ptr - 1;
+}
+
+static size_t GetThreadObjectOffset(ThreadObjectHeader* header) {
+    return (size_t)1 << (header->packedSize & ((1 << THREAD_OFFSET_BITS) - 1));
+}
+
+static ThreadArena* GetThreadArena(ThreadSafeAllocator* allocator) {
+    ThreadArena* threadArena = pthread_getspecific(allocator->threadKey);
+    if (threadArena != NULL) {
+        return threadArena;
+    }
+
+    threadArena = AllocateZeros(sizeof(ThreadArena));
+    threadArena->arena = allocator->CreateArena(allocator->ctx);
+    atomic_init(&threadArena->remoteFrees, NULL);
+
+    ThreadArena* head = atomic_load_explicit(&allocator->arenas, memory_order_relaxed);
+    do {
+        threadArena->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&allocator->arenas, &head, threadArena,
+                memory_order_release, memory_order_relaxed));
+
+    pthread_setspecific(allocator->threadKey, threadArena);
+    return threadArena;
+}
+
+/*
+ * The block size is rounded up to the offset, so that its natural
+ * alignment matches the requested one and freed blocks can be recycled.
+ */
+static size_t GetThreadBlockSize(size_t bytes, size_t offset) {
+    return RoundUp(offset + bytes, offset);
+}
+
+static void FreeLocalThreadObject(ThreadObjectHeader* header, size_t bytes, ThreadArena* threadArena) {
+    size_t offset = GetThreadObjectOffset(header);
+    Byte* block = (Byte*)(header + 1) - offset;
+    AllocatorFreeObject(block, GetThreadBlockSize(bytes, offset), threadArena->arena);
+}
+
+static void RecycleRemoteFrees(ThreadArena* threadArena) {
+    ThreadObjectHeader* header = atomic_exchange_explicit(&threadArena->remoteFrees, NULL, memory_order_acquire);
+    while (header != NULL) {
+        ThreadObjectHeader* next = header->as.nextRemoteFree;
+        size_t bytes = header->packedSize >> THREAD_OFFSET_BITS;
+        FreeLocalThreadObject(header, bytes, threadArena);
+        header = next;
+    }
+}
+
+static void* AllocThreadSafe(size_t bytes, size_t alignment, Allocator* self) {
+    ThreadSafeAllocator* allocator = (ThreadSafeAllocator*)self;
+    ThreadArena* threadArena = GetThreadArena(allocator);
+
+    if (atomic_load_explicit(&threadArena->remoteFrees, memory_order_relaxed) != NULL) {
+        RecycleRemoteFrees(threadArena);
+    }
+
+    size_t offset = alignment > sizeof(ThreadObjectHeader) ? alignment : sizeof(ThreadObjectHeader);
+    Byte* block = AllocatorAllocAligned(GetThreadBlockSize(bytes, offset), offset, threadArena->arena);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    ThreadObjectHeader* header = (ThreadObjectHeader*)(block + offset) - 1;
+    header->as.owner = threadArena;
+    header->packedSize = Log2(offset);
+    return block + offset;
+}
+
+static void FreeObjectThreadSafe(void* ptr, size_t bytes, Allocator* self) {
+    ThreadSafeAllocator* allocator = (ThreadSafeAllocator*)self;
+    ThreadObjectHeader* header = GetThreadObjectHeader(ptr);
+    ThreadArena* owner = header->as.owner;
+
+    if (owner == pthread_getspecific(allocator->threadKey)) {
+        FreeLocalThreadObject(header, bytes, owner);
+        return;
+    }
+
+    header->packedSize |= bytes << THREAD_OFFSET_BITS;
+    ThreadObjectHeader* head = atomic_load_explicit(&owner->remoteFrees, memory_order_relaxed);
+    do {
+        header->as.nextRemoteFree = head;
+    } while (!atomic_compare_exchange_weak_explicit(&owner->remoteFrees, &head, header,
+                memory_order_release, memory_order_relaxed));
+}
+
+static void ResetThreadSafe(Allocator* self) {
+    ThreadSafeAllocator* allocator = (ThreadSafeAllocator*)self;
+    ThreadArena* threadArena = atomic_load_explicit(&allocator->arenas, memory_order_acquire);
+    for (; threadArena != NULL; threadArena = threadArena->next) {
+        atomic_store_explicit(&threadArena->remoteFrees, NULL, memory_order_relaxed);
+        AllocatorReset(threadArena->arena);
+    }
+}
+
+static void FreeThreadSafe(Allocator* self) {
+    ThreadSafeAllocator* allocator = (ThreadSafeAllocator*)self;
+    ThreadArena* threadArena = atomic_load_explicit(&allocator->arenas, memory_order_acquire);
+    while (threadArena != NULL) {
+        ThreadArena* next = threadArena->next;
+        AllocatorFree(threadArena->arena);
+        FreeMemory(threadArena);
+        threadArena = next;
+    }
+    pthread_key_delete(allocator->threadKey);
+
+    *allocator = (ThreadSafeAllocator) {0};
+    FreeMemory(allocator);
+}
+
+/*
+ * The arena stats are read without synchronization, so they are only
+ * approximate while other threads are allocating.
+ */
+static void CollectStatsThreadSafe(Allocator* self) {
+    ThreadSafeAllocator* allocator = (ThreadSafeAllocator*)self;
+    AllocatorStats total = {0};
+
+    ThreadArena* threadArena = atomic_load_explicit(&allocator->arenas, memory_order_acquire);
+    for (; threadArena != NULL; threadArena = threadArena->next) {
+        AllocatorStats stats = AllocatorGetStats(threadArena->arena);
+        total.bytesRequested += stats.bytesRequested;
+        total.bytesInUse += stats.bytesInUse;
+        total.bytesReserved += stats.bytesReserved;
+        total.numPages += stats.numPages;
+        total.highWaterMark += stats.highWaterMark;
+        total.wastedBytes += stats.wastedBytes;
+        total.numAllocs += stats.numAllocs;
+        total.numFrees += stats.numFrees;
+    }
+
+    self->stats = total;
+}
+
+static void DebugThreadSafe(Allocator* self) {
+    ThreadSafeAllocator* allocator = (ThreadSafeAllocator*)self;
+    ThreadArena* threadArena = atomic_load_explicit(&allocator->arenas, memory_order_acquire);
+    for (size_t i = 0; threadArena != NULL; threadArena = threadArena->next, i++) {
+        printf("Thread arena %ld\n", i);
+        AllocatorDebug(threadArena->arena);
+    }
+}
+
+Allocator* CreateThreadSafeAllocator(Allocator* (*CreateArena)(void* ctx), void* ctx) {
+    ThreadSafeAllocator* allocator = AllocateZeros(sizeof(ThreadSafeAllocator));
+    *allocator = (ThreadSafeAllocator) {
+        .base.Alloc = &AllocThreadSafe,
+        .base.Reset = &ResetThreadSafe,
+        .base.Free = &FreeThreadSafe,
+        .base.FreeObject = &FreeObjectThreadSafe,
+        .base.Debug = &DebugThreadSafe,
+        .base.CollectStats = &CollectStatsThreadSafe,
+        .base.isThreadSafe = true,
+        .CreateArena = CreateArena,
+        .ctx = ctx,
+    };
+    atomic_init(&allocator->arenas, NULL);
+
+    int status = pthread_key_create(&allocator->threadKey, NULL);
+    Assert(status == 0, "Failed to create thread key.");
 
     return (Allocator*)allocator;
 }
@@ -2,6 +2,8 @@
 #define memory_h
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 // -- General purpose allocation --
 
@@ -11,21 +13,142 @@
  */
 void* AllocateArray(void* ptr, size_t count, size_t elementSize);
 void* AllocateZeros(size_t bytes);
+// Allocates memory aligned to a power of two. Does not zero memory.
+void* AllocateAligned(size_t bytes, size_t alignment);
 void FreeMemory(void* ptr);
 
+// Rounds up to the nearest multiple.
+size_t RoundUp(size_t n, size_t multiple);
+/*
+ * The alignment that AllocatorAlloc uses. This is the natural alignment
+ * of the size, capped at the alignment of max_align_t. That is enough
+ * for any type of the given size.
+ *
+ * The natural alignment of a size is the greatest power of two that divides it.
+ * The size of a type is always a multiple of its alignment, so any type
+ * of the given size is correctly aligned at its natural alignment.
+ */
+static inline size_t DefaultAlignment(size_t bytes) {
+    size_t alignment = bytes & -bytes;
+    if (alignment == 0 || alignment > _Alignof(max_align_t)) {
+        return _Alignof(max_align_t);
+    }
+    return alignment;
+}
+
 // -- Allocators --
 
 typedef struct Allocator Allocator;
 
-void* AllocatorAlloc(size_t bytes, Allocator* allocator);
+/*
+ * Inline allocation fast path. Allocators that bump a pointer expose
+ * the free part of their current block as a cursor and a limit, and
+ * AllocatorAlloc serves anything that fits there without calling into
+ * the allocator. Everything else goes through the allocator as usual.
+ *
+ * The fast path is empty for allocators that do not bump. Bump allocators
+ * recycle freed objects on the slow path, so sizes with freed objects
+ * are kept off the fast path, see FastPathSizeClass.
+ *
+ * This is the first member of every allocator. The counters are
+ * moved into the allocator stats the next time the allocator is called.
+ */
+typedef struct {
+    uint8_t* cursor;
+    uint8_t* limit;
+    // one bit per size class that has freed objects to recycle
+    uint64_t recycledSizeClasses;
+    size_t numAllocs;
+    size_t bytesRequested;
+    size_t wastedBytes;
+} AllocatorFastPath;
+
+/*
+ * The size classes of recycledSizeClasses are 8 bytes wide, and the last
+ * one holds all greater sizes. A class only says that some size within it
+ * may have freed objects, the allocator checks the exact size.
+ */
+static inline uint64_t FastPathSizeClass(size_t bytes) {
+    size_t index = (bytes - 1) / 8;
+    return (uint64_t)1 << (index < 63 ? index : 63);
+}
+
+// Allocates bytes at the given alignment, which must be a power of two.
+void* AllocatorAllocAligned(size_t bytes, size_t alignment, Allocator* allocator);
+
+// Allocates bytes at the default alignment, see DefaultAlignment.
+static inline void* AllocatorAlloc(size_t bytes, Allocator* allocator) {
+    AllocatorFastPath* fastPath = (AllocatorFastPath*)allocator;
+    size_t alignment = DefaultAlignment(bytes);
+
+    uintptr_t cursor = (uintptr_t)fastPath->cursor;
+    uintptr_t start = (cursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    // an empty fast path has a NULL limit, which nothing fits below
+    if (start + bytes < (uintptr_t)fastPath->limit && !(fastPath->recycledSizeClasses & FastPathSizeClass(bytes))) {
+        fastPath->cursor = (uint8_t*)(start + bytes);
+        fastPath->numAllocs++;
+        fastPath->bytesRequested += bytes;
+        fastPath->wastedBytes += start - cursor;
+        return (void*)start;
+    }
+    return AllocatorAllocAligned(bytes, alignment, allocator);
+}
 
 // Reset allocator state, for example memory arenas. The allocator can be re-used.
 void AllocatorReset(Allocator* allocator);
+/*
+ * Sets how many bytes of warmed up memory an arena may keep when it is reset,
+ * so that running many small programs does not allocate pages over and over.
+ * The default is to only keep the initial memory. Ignored by other allocators.
+ */
+void AllocatorSetRetention(size_t bytes, Allocator* allocator);
 // Free allocator state. The allocator can not be re-used.
 void AllocatorFree(Allocator* allocator);
 // Frees the given object
 void AllocatorFreeObject(void* ptr, size_t bytes, Allocator* allocator);
-// Helper to inspect internal state when debugging.
+
+/*
+ * A checkpoint in an arena. Releasing a mark frees everything that was
+ * allocated after it, while older allocations are left untouched.
+ * This is meant for temporary memory that dies at the end of a scope.
+ */
+typedef struct {
+    size_t page;
+    size_t offset;
+    size_t largeObjectId;
+    size_t bytesInUse;
+    size_t wastedBytes;
+} ArenaMark;
+
+/*
+ * Marks and releases are supported by the bump and virtual arena allocators.
+ * Other allocators ignore them. Marks must be released in reverse order and
+ * a mark is invalid after an earlier mark is released or the allocator is reset.
+ */
+ArenaMark AllocatorMark(Allocator* allocator);
+void AllocatorRelease(ArenaMark mark, Allocator* allocator);
+
+typedef struct {
+    // Bytes requested by allocation calls, in total and not yet freed.
+    size_t bytesRequested;
+    size_t bytesInUse;
+    // Bytes held by the allocator, such as pages, and how many pages that is.
+    size_t bytesReserved;
+    size_t numPages;
+    // The greatest number of bytes reserved at any point.
+    size_t highWaterMark;
+    /*
+     * Bytes reserved but not available for allocations, such as the
+     * unused end of a page or padding for alignment.
+     */
+    size_t wastedBytes;
+    size_t numAllocs;
+    size_t numFrees;
+} AllocatorStats;
+
+AllocatorStats AllocatorGetStats(Allocator* allocator);
+void PrintAllocatorStats(AllocatorStats stats);
+// Helper to inspect internal state when debugging. Prints the stats and allocator details.
 void AllocatorDebug(Allocator* allocator);
 
 /*
@@ -45,14 +168,104 @@ Allocator* CreateHeapAllocator();
  * pages. When a page is full, the next one is used. When all pages are full,
  * the arena grows by one page.
  *
+ * Pages are aligned to 64 bytes, so cache line and SIMD aligned buffers
+ * can be allocated within them.
+ *
  * There is some fragmentation, because all bytes of an object are always
  * allocated within the same page. If there is not enough room in
  * the current page to allocate N bytes, then all of those N bytes end up
  * in the next page, leaving the end of the previos page unused.
  *
+ * Objects greater than the page size are allocated in dedicated blocks
+ * outside of the pages, so the page size does not limit the object size
+ * and the pages stay densely packed with small objects.
+ *
+ * Freed objects are recycled. They are kept in per-size free lists
+ * and re-used by later allocations of the same size. Objects smaller than
+ * a pointer are not recycled until the allocator is reset.
+ *
  * When resetting the allocator, it returns to having the initial
- * number of pages and any extra pages that were created.
+ * number of pages and releases any extra pages and large objects
+ * that were created. With a retention set, the extra pages are kept
+ * up to the retention.
+ *
+ * The rest of the current page is the inline fast path of AllocatorAlloc,
+ * except while there are freed objects waiting to be recycled.
+ *
+ * Releasing a mark rolls the arena back to the page and offset of the mark
+ * and releases the large objects created after it. The pages are kept for
+ * upcoming allocations. Freed objects that are waiting to be recycled
+ * are forgotten.
  */
 Allocator* CreateBumpAllocator(size_t pageSize, size_t initialNumPages);
 
+/*
+ * SLAB ALLOCATOR
+ *
+ * Fixed size object allocator, intended for runtime objects that are
+ * all the same size. Objects are grouped into slabs of objectsPerSlab
+ * objects. Allocating and freeing an object are both O(1), and freed
+ * objects are re-used without any fragmentation.
+ *
+ * A slab is released as soon as all of its objects are freed, except
+ * for one empty slab that is kept around for upcoming allocations.
+ *
+ * Allocations must fit within objectSize bytes, and can not be aligned
+ * to more than the natural alignment of objectSize. When resetting the
+ * allocator, all slabs but one are released.
+ */
+Allocator* CreateSlabAllocator(size_t objectSize, size_t objectsPerSlab);
+
+/*
+ * VIRTUAL ARENA ALLOCATOR
+ *
+ * Bump allocator backed by a single contiguous range of virtual memory.
+ * The full range of reserveBytes is reserved up front, but physical memory
+ * is only committed on demand, commitBytes at a time. Allocating is a
+ * single pointer bump, and there are no pages to keep track of.
+ *
+ * There is no fragmentation between allocations, but the total size
+ * of the arena is limited by the reserved range.
+ *
+ * Freed objects are recycled in the same way as with the bump allocator,
+ * and the committed memory after the cursor is the inline fast path.
+ *
+ * When resetting the allocator, all memory can be re-used. With
+ * VIRTUAL_ARENA_DECOMMIT_ON_RESET, everything but the first commitBytes,
+ * or the retention if it is greater, is also given back to the OS.
+ *
+ * Releasing a mark moves the cursor back to the mark, in the same way as
+ * with the bump allocator. The committed memory is kept.
+ */
+typedef enum {
+    VIRTUAL_ARENA_DEFAULT = 0,
+    // Back the arena with transparent huge pages, using madvise(MADV_HUGEPAGE).
+    VIRTUAL_ARENA_HUGE_PAGES = 1 << 0,
+    // Release the tail of the arena with madvise(MADV_DONTNEED) on reset.
+    VIRTUAL_ARENA_DECOMMIT_ON_RESET = 1 << 1,
+} VirtualArenaFlags;
+
+Allocator* CreateVirtualArenaAllocator(size_t reserveBytes, size_t commitBytes, VirtualArenaFlags flags);
+
+/*
+ * THREAD SAFE ALLOCATOR
+ *
+ * Front end that gives every thread its own arena. The arena of a thread
+ * is created with CreateArena(ctx) the first time the thread allocates, for
+ * example a bump or slab allocator. There is no locking when allocating.
+ *
+ * Objects may be freed from any thread. An object that is freed by another
+ * thread than the one that allocated it is handed back to the owning arena
+ * through a lock-free queue, and is recycled the next time the owning
+ * thread allocates.
+ *
+ * Every object has a small header, at least the size of max_align_t,
+ * to keep track of its arena.
+ *
+ * Arenas live until the allocator is freed, even if their thread exits.
+ * Resetting or freeing the allocator must only be done when no other thread
+ * is using it. The stats are the sum of the arena stats.
+ */
+Allocator* CreateThreadSafeAllocator(Allocator* (*CreateArena)(void* ctx), void* ctx);
+
 #endif
@@ -5,9 +5,9 @@
 #include "parser.h"
 #include "memory.h"
 
-static TokenDa tokens = {0};
-static size_t currentIndex = 0;
-static Allocator* astAllocator = NULL;
+static _Thread_local TokenDa tokens = {0};
+static _Thread_local size_t currentIndex = 0;
+static _Thread_local Allocator* astAllocator = NULL;
 
 static Token* Peek() {
     return &tokens.items[currentIndex];
@@ -71,12 +71,19 @@ static ParseResult EmitParseSuccess(Ast* ast) {
 
 static ParseResult ParseExpr();
 
-static ParseResult ParseF64() {
+// Numbers without a decimal point are integers, unless they are too large.
+static ParseResult ParseNumber() {
     String str = Peek()->str;
-    double num = ParseStringAsDouble(str);
-    Value val = MAKE_VALUE_F64(num);
     Token* token = Peek();
 
+    int32_t i32 = 0;
+    Value val = {0};
+    if (TryParseStringAsI32(str, &i32)) {
+        val = MAKE_VALUE_I32(i32);
+    } else {
+        val = MAKE_VALUE_F64(ParseStringAsDouble(str));
+    }
+
     return EmitParseSuccess(CreateAtom(val, token, astAllocator));
 }
 
@@ -122,7 +129,7 @@ static ParseResult ParseAtom() {
             result = EmitParseSuccess(ast);
             break;
         case TOKEN_NUMBER:
-            result = ParseF64();
+            result = ParseNumber();
             break;
         case TOKEN_STRING:
             result = ParseString();
@@ -149,6 +156,111 @@ static ParseResult ParseAtom() {
         case TOKEN_SET:
             result = ParseOperator(OPERATOR_SET_GLOBAL);
             break;
+        case TOKEN_CONCAT:
+            result = ParseOperator(OPERATOR_CONCAT);
+            break;
+        case TOKEN_HASHMAP:
+            result = ParseOperator(OPERATOR_HASHMAP);
+            break;
+        case TOKEN_HASHSET:
+            result = ParseOperator(OPERATOR_HASHSET);
+            break;
+        case TOKEN_ASSOC:
+            result = ParseOperator(OPERATOR_ASSOC);
+            break;
+        case TOKEN_DISSOC:
+            result = ParseOperator(OPERATOR_DISSOC);
+            break;
+        case TOKEN_GET:
+            result = ParseOperator(OPERATOR_GET);
+            break;
+        case TOKEN_CONTAINS:
+            result = ParseOperator(OPERATOR_CONTAINS);
+            break;
+        case TOKEN_CONJ:
+            result = ParseOperator(OPERATOR_CONJ);
+            break;
+        case TOKEN_HASHTABLE:
+            result = ParseOperator(OPERATOR_HASHTABLE);
+            break;
+        case TOKEN_PUT:
+            result = ParseOperator(OPERATOR_PUT);
+            break;
+        case TOKEN_REMOVE:
+            result = ParseOperator(OPERATOR_REMOVE);
+            break;
+        case TOKEN_COUNT:
+            result = ParseOperator(OPERATOR_COUNT);
+            break;
+        case TOKEN_NTH:
+            result = ParseOperator(OPERATOR_NTH);
+            break;
+        case TOKEN_PUSH:
+            result = ParseOperator(OPERATOR_PUSH);
+            break;
+        case TOKEN_SLICE:
+            result = ParseOperator(OPERATOR_SLICE);
+            break;
+        case TOKEN_VEC:
+            result = ParseOperator(OPERATOR_VEC);
+            break;
+        case TOKEN_TOLIST:
+            result = ParseOperator(OPERATOR_TOLIST);
+            break;
+        case TOKEN_F64ARRAY:
+            result = ParseOperator(OPERATOR_F64ARRAY);
+            break;
+        case TOKEN_SUM:
+            result = ParseOperator(OPERATOR_SUM);
+            break;
+        case TOKEN_MIN:
+            result = ParseOperator(OPERATOR_MIN);
+            break;
+        case TOKEN_MAX:
+            result = ParseOperator(OPERATOR_MAX);
+            break;
+        case TOKEN_DOT:
+            result = ParseOperator(OPERATOR_DOT);
+            break;
+        case TOKEN_LENGTH:
+            result = ParseOperator(OPERATOR_LENGTH);
+            break;
+        case TOKEN_FIND:
+            result = ParseOperator(OPERATOR_FIND);
+            break;
+        case TOKEN_SPLIT:
+            result = ParseOperator(OPERATOR_SPLIT);
+            break;
+        case TOKEN_JOIN:
+            result = ParseOperator(OPERATOR_JOIN);
+            break;
+        case TOKEN_OCCURRENCES:
+            result = ParseOperator(OPERATOR_OCCURRENCES);
+            break;
+        case TOKEN_COMPARE:
+            result = ParseOperator(OPERATOR_COMPARE);
+            break;
+        case TOKEN_RANGE:
+            result = ParseOperator(OPERATOR_RANGE);
+            break;
+        case TOKEN_ITERATE:
+            result = ParseOperator(OPERATOR_ITERATE);
+            break;
+        case TOKEN_LINES:
+            result = ParseOperator(OPERATOR_LINES);
+            break;
+        case TOKEN_TAKE:
+            result = ParseOperator(OPERATOR_TAKE);
+            break;
+        case TOKEN_MAP:
+            result = ParseOperator(OPERATOR_MAP);
+            break;
+        case TOKEN_FILTER:
+            result = ParseOperator(OPERATOR_FILTER);
+            break;
+        case TOKEN_REDUCE:
+            result = ParseOperator(OPERATOR_REDUCE);
+            break;
         case TOKEN_FUN:
             result = ParseComptimeOperator(COMPTIME_OPERATOR_FUN);
             break;
@@ -196,10 +308,12 @@ static ParseResult ParseDefun() {
  * For example, given (1 2 3) this function
  * will be called for the 2 3 part and return
  * (2 . (3 . nil))
+ *
+ * The end is a closing parenthesis, or a closing bracket for vectors.
  */
-static ParseResult ParseListElements() {
+static ParseResult ParseListElements(TokenType end) {
     // add implicit nil if we reached the end
-    if (Check(TOKEN_PAREN_END)) {
+    if (Check(end)) {
         Token* token = Peek();
         return EmitParseSuccess(CreateAtom(MAKE_VALUE_NIL(), token, astAllocator));
     }
@@ -208,7 +322,7 @@ static ParseResult ParseListElements() {
     if (head.type == RESULT_ERROR) {
         return head;
     }
-    ParseResult tail = ParseListElements();
+    ParseResult tail = ParseListElements(end);
     if (tail.type == RESULT_ERROR) {
         return tail;
     }
@@ -238,7 +352,7 @@ static ParseResult ParseList() {
     if (Match(TOKEN_CONS)) {
         tail = ParseExpr();
     } else {
-        tail = ParseListElements();
+        tail = ParseListElements(TOKEN_PAREN_END);
     }
 
     if (tail.type == RESULT_ERROR) {
@@ -253,11 +367,29 @@ static ParseResult ParseList() {
     return EmitParseSuccess(cons);
 }
 
+// Parses a vector literal like [1 2 3]. The elements are kept as a proper list.
+static ParseResult ParseVector() {
+    Token* token = Previos();
+
+    ParseResult elements = ParseListElements(TOKEN_BRACKET_END);
+    if (elements.type == RESULT_ERROR) {
+        return elements;
+    }
+
+    if (!Match(TOKEN_BRACKET_END)) {
+        return EmitParseError("Unterminated vector brackets");
+    }
+
+    return EmitParseSuccess(CreateVector(elements.as.success.ast, token, astAllocator));
+}
+
 static ParseResult ParseExpr() {
     bool isQuoted = Match(TOKEN_QUOTE);
     ParseResult result = {0};
     if (Match(TOKEN_PAREN_START)) {
         result = ParseList();
+    } else if (Match(TOKEN_BRACKET_START)) {
+        result = ParseVector();
     } else {
         result = ParseAtom();
     }
@@ -278,7 +410,13 @@ ParseResult ParseTokens(TokenDa ts, Allocator* allocator) {
         return EmitParseError("Nothing to parse.");
     }
 
-    return ParseExpr();
+    // the partial tree of a failed parse is of no use to anyone
+    ArenaMark mark = AllocatorMark(allocator);
+    ParseResult result = ParseExpr();
+    if (result.type == RESULT_ERROR) {
+        AllocatorRelease(mark, allocator);
+    }
+    return result;
 }
 
 static void PrintAstHelper(Ast* ast, void* ctx);
@@ -300,9 +438,17 @@ static void PrintAstCons(Ast* ast, void* ctx) {
     printf("%*s)\n", indent, "");
 }
 
+static void PrintAstVector(Ast* ast, void* ctx) {
+    int indent = (int)(intptr_t)ctx;
+    printf("%*s[\n", indent, "");
+    PrintAstHelper(ast->as.vector.elements, (void*)(intptr_t)(indent+2));
+    printf("%*s]\n", indent, "");
+}
+
 static AstVisitor printVisitor = {
     .VisitAtom = &PrintAstAtom,
     .VisitCons = &PrintAstCons,
+    .VisitVector = &PrintAstVector,
 };
 
 static void PrintAstHelper(Ast* ast, void* ctx) {
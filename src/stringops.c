@@ -0,0 +1,290 @@
+#include "stringops.h"
+#include "asserts.h"
+#include "vector.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define STRING_OPS_HAS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/*
+ * The kernels return the length of the string when there is no match,
+ * so that they can be chained over the rest of a string.
+ */
+typedef size_t (*FindByteKernel)(const char* chars, size_t length, char c);
+typedef size_t (*CountByteKernel)(const char* chars, size_t length, char c);
+// The needle has at least two characters and is not longer than the haystack.
+typedef size_t (*FindSubstringKernel)(const char* haystack, size_t length, const char* needle, size_t needleLength);
+typedef size_t (*FirstMismatchKernel)(const char* first, const char* second, size_t length);
+
+typedef struct {
+    FindByteKernel findByte;
+    CountByteKernel countByte;
+    FindSubstringKernel findSubstring;
+    FirstMismatchKernel firstMismatch;
+} StringKernels;
+
+// -- Scalar kernels --
+
+static size_t ScalarFindByte(const char* chars, size_t length, char c) {
+    for (size_t i = 0; i < length; i++) {
+        if (chars[i] == c) {
+            return i;
+        }
+    }
+    return length;
+}
+
+static size_t ScalarCountByte(const char* chars, size_t length, char c) {
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        count += chars[i] == c;
+    }
+    return count;
+}
+
+static size_t ScalarFindSubstring(const char* haystack, size_t length, const char* needle, size_t needleLength) {
+    for (size_t i = 0; i + needleLength <= length; i++) {
+        if (haystack[i] == needle[0] && memcmp(haystack + i + 1, needle + 1, needleLength - 1) == 0) {
+            return i;
+        }
+    }
+    return length;
+}
+
+static size_t ScalarFirstMismatch(const char* first, const char* second, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (first[i] != second[i]) {
+            return i;
+        }
+    }
+    return length;
+}
+
+static const StringKernels scalarKernels = {
+    .findByte = ScalarFindByte,
+    .countByte = ScalarCountByte,
+    .findSubstring = ScalarFindSubstring,
+    .firstMismatch = ScalarFirstMismatch,
+};
+
+#ifdef STRING_OPS_HAS_X86_KERNELS
+
+// -- Vector kernels --
+
+/*
+ * Each ISA compares a vector of characters at once and turns the result
+ * into a bit mask with one bit per character, in order.
+ */
+#define SSE2_TARGET "sse2"
+#define SSE2_VECTOR __m128i
+#define SSE2_WIDTH 16
+#define SSE2_ALL_MATCH 0xffffu
+#define SSE2_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define SSE2_SET1 _mm_set1_epi8
+#define SSE2_CMPEQ _mm_cmpeq_epi8
+#define SSE2_AND _mm_and_si128
+#define SSE2_MOVEMASK(v) ((uint32_t)_mm_movemask_epi8(v))
+
+#define AVX2_TARGET "avx2"
+#define AVX2_VECTOR __m256i
+#define AVX2_WIDTH 32
+#define AVX2_ALL_MATCH 0xffffffffu
+#define AVX2_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define AVX2_SET1 _mm256_set1_epi8
+#define AVX2_CMPEQ _mm256_cmpeq_epi8
+#define AVX2_AND _mm256_and_si256
+#define AVX2_MOVEMASK(v) ((uint32_t)_mm256_movemask_epi8(v))
+
+/*
+ * Substrings are searched by comparing the first and the last character of
+ * the needle at every position of a vector at once. Only the positions where
+ * both match are compared in full, which is rare for most text.
+ */
+#define DEFINE_VECTOR_KERNELS(isa) \
+    __attribute__((target(isa##_TARGET))) \
+    static size_t isa##FindByte(const char* chars, size_t length, char c) { \
+        isa##_VECTOR target = isa##_SET1(c); \
+        size_t i = 0; \
+        for (; i + isa##_WIDTH <= length; i += isa##_WIDTH) { \
+            uint32_t matches = isa##_MOVEMASK(isa##_CMPEQ(isa##_LOAD(chars + i), target)); \
+            if (matches != 0) { \
+                return i + __builtin_ctz(matches); \
+            } \
+        } \
+        return i + ScalarFindByte(chars + i, length - i, c); \
+    } \
+    __attribute__((target(isa##_TARGET))) \
+    static size_t isa##CountByte(const char* chars, size_t length, char c) { \
+        isa##_VECTOR target = isa##_SET1(c); \
+        size_t count = 0; \
+        size_t i = 0; \
+        for (; i + isa##_WIDTH <= length; i += isa##_WIDTH) { \
+            count += __builtin_popcount(isa##_MOVEMASK(isa##_CMPEQ(isa##_LOAD(chars + i), target))); \
+        } \
+        return count + ScalarCountByte(chars + i, length - i, c); \
+    } \
+    __attribute__((target(isa##_TARGET))) \
+    static size_t isa##FindSubstring(const char* haystack, size_t length, const char* needle, size_t needleLength) { \
+        isa##_VECTOR first = isa##_SET1(needle[0]); \
+        isa##_VECTOR last = isa##_SET1(needle[needleLength - 1]); \
+        size_t positions = length - needleLength + 1; \
+        size_t i = 0; \
+        for (; i + isa##_WIDTH <= positions; i += isa##_WIDTH) { \
+            isa##_VECTOR firstMatches = isa##_CMPEQ(isa##_LOAD(haystack + i), first); \
+            isa##_VECTOR lastMatches = isa##_CMPEQ(isa##_LOAD(haystack + i + needleLength - 1), last); \
+            uint32_t candidates = isa##_MOVEMASK(isa##_AND(firstMatches, lastMatches)); \
+            for (; candidates != 0; candidates &= candidates - 1) { \
+                size_t k = i + __builtin_ctz(candidates); \
+                if (memcmp(haystack + k + 1, needle + 1, needleLength - 2) == 0) { \
+                    return k; \
+                } \
+            } \
+        } \
+        return i + ScalarFindSubstring(haystack + i, length - i, needle, needleLength); \
+    } \
+    __attribute__((target(isa##_TARGET))) \
+    static size_t isa##FirstMismatch(const char* first, const char* second, size_t length) { \
+        size_t i = 0; \
+        for (; i + isa##_WIDTH <= length; i += isa##_WIDTH) { \
+            uint32_t matches = isa##_MOVEMASK(isa##_CMPEQ(isa##_LOAD(first + i), isa##_LOAD(second + i))); \
+            if (matches != isa##_ALL_MATCH) { \
+                return i + __builtin_ctz(~matches); \
+            } \
+        } \
+        return i + ScalarFirstMismatch(first + i, second + i, length - i); \
+    } \
+    static const StringKernels isa##Kernels = { \
+        .findByte = isa##FindByte, \
+        .countByte = isa##CountByte, \
+        .findSubstring = isa##FindSubstring, \
+        .firstMismatch = isa##FirstMismatch, \
+    };
+
+DEFINE_VECTOR_KERNELS(SSE2)
+DEFINE_VECTOR_KERNELS(AVX2)
+
+#endif
+
+// -- Dispatch --
+
+static _Thread_local const StringKernels* kernels = NULL;
+
+StringKernelLevel GetSupportedStringKernelLevel() {
+#ifdef STRING_OPS_HAS_X86_KERNELS
+    if (__builtin_cpu_supports("avx2")) {
+        return STRING_KERNELS_AVX2;
+    }
+    return STRING_KERNELS_SSE2;
+#else
+    return STRING_KERNELS_SCALAR;
+#endif
+}
+
+void SetStringKernelLevel(StringKernelLevel level) {
+    Assertf(level <= GetSupportedStringKernelLevel(), "Unsupported kernel level %d", level);
+    switch (level) {
+#ifdef STRING_OPS_HAS_X86_KERNELS
+        case STRING_KERNELS_AVX2: kernels = &AVX2Kernels; break;
+        case STRING_KERNELS_SSE2: kernels = &SSE2Kernels; break;
+#endif
+        default: kernels = &scalarKernels; break;
+    }
+}
+
+static const StringKernels* GetKernels() {
+    if (kernels == NULL) {
+        SetStringKernelLevel(GetSupportedStringKernelLevel());
+    }
+    return kernels;
+}
+
+// -- Strings --
+
+// Like FindSubstring, but returns the length of the haystack when there is no match.
+static size_t FindNext(String haystack, String needle, size_t start) {
+    const StringKernels* k = GetKernels();
+    const char* chars = haystack.start + start;
+    size_t length = haystack.length - start;
+    if (needle.length > length) {
+        return haystack.length;
+    } else if (needle.length == 1) {
+        return start + k->findByte(chars, length, needle.start[0]);
+    }
+    return start + k->findSubstring(chars, length, needle.start, needle.length);
+}
+
+ptrdiff_t FindSubstring(String haystack, String needle, size_t start) {
+    if (start > haystack.length) {
+        return -1;
+    } else if (needle.length == 0) {
+        return start;
+    }
+
+    size_t i = FindNext(haystack, needle, start);
+    return i == haystack.length ? -1 : (ptrdiff_t)i;
+}
+
+size_t CountSubstring(String haystack, String needle) {
+    Assert(needle.length > 0, "Expected a non-empty needle");
+
+    if (needle.length == 1) {
+        return GetKernels()->countByte(haystack.start, haystack.length, needle.start[0]);
+    }
+
+    size_t count = 0;
+    for (size_t i = FindNext(haystack, needle, 0); i < haystack.length; i = FindNext(haystack, needle, i + needle.length)) {
+        count++;
+    }
+    return count;
+}
+
+int CompareStrings(String first, String second) {
+    size_t length = first.length < second.length ? first.length : second.length;
+    size_t i = GetKernels()->firstMismatch(first.start, second.start, length);
+    if (i < length) {
+        return (unsigned char)first.start[i] - (unsigned char)second.start[i];
+    }
+    return (first.length > second.length) - (first.length < second.length);
+}
+
+Object* SplitString(Object* str, String delimiter, Allocator* allocator) {
+    Assert(delimiter.length > 0, "Expected a non-empty delimiter");
+
+    String chars = GetStringChars(str, allocator);
+    Object* parts = CreateVectorObject(NULL, 0, allocator);
+    size_t start = 0;
+    for (;;) {
+        size_t end = FindNext(chars, delimiter, start);
+        VectorPush(parts, MAKE_VALUE_OBJECT(CreateStringSlice(str, start, end, allocator)), allocator);
+        if (end == chars.length) {
+            break;
+        }
+        start = end + delimiter.length;
+    }
+    return parts;
+}
+
+Object* JoinStrings(Object* separator, Value* items, size_t count, Allocator* allocator) {
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        length += ValueAsObject(items[i])->as.string.length;
+    }
+    if (count > 1) {
+        length += (count - 1) * separator->as.string.length;
+    }
+
+    // the parts are copied straight into the result, without building a rope first
+    char* chars = NULL;
+    Object* result = AllocateStringObject(length, &chars, allocator);
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) {
+            CopyStringChars(separator, chars);
+            chars += separator->as.string.length;
+        }
+        Object* item = ValueAsObject(items[i]);
+        CopyStringChars(item, chars);
+        chars += item->as.string.length;
+    }
+    return result;
+}
@@ -0,0 +1,36 @@
+/*
+ * Searching, splitting, joining and comparing strings.
+ *
+ * The kernels look at a whole vector of characters at a time, 16 with SSE2
+ * and 32 with AVX2, and only fall back to single characters at the end of
+ * a string. Like the f64 array kernels, the level is detected at runtime.
+ */
+#ifndef stringops_h
+#define stringops_h
+
+#include "values.h"
+
+typedef enum {
+    STRING_KERNELS_SCALAR,
+    STRING_KERNELS_SSE2,
+    STRING_KERNELS_AVX2,
+} StringKernelLevel;
+
+// The best kernels that this CPU supports.
+StringKernelLevel GetSupportedStringKernelLevel();
+// Picks the kernels for this thread. The default is the supported level.
+void SetStringKernelLevel(StringKernelLevel level);
+
+// The index of the first occurrence of needle at or after start, or -1.
+ptrdiff_t FindSubstring(String haystack, String needle, size_t start);
+// Occurrences that do not overlap. The needle must not be empty.
+size_t CountSubstring(String haystack, String needle);
+// Negative, zero or positive like memcmp. A prefix is ordered before the longer string.
+int CompareStrings(String first, String second);
+
+// A vector of the parts between the delimiters. The delimiter must not be empty.
+Object* SplitString(Object* str, String delimiter, Allocator* allocator);
+// Concatenates strings with a separator in between. The items must be strings.
+Object* JoinStrings(Object* separator, Value* items, size_t count, Allocator* allocator);
+
+#endif
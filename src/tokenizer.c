@@ -1,10 +1,10 @@
 #include <stdio.h>
 #include "tokens.h"
 
-static char* current = NULL;
-static char* tokenStart = NULL;
-static int line;
-static int col;
+static _Thread_local char* current = NULL;
+static _Thread_local char* tokenStart = NULL;
+static _Thread_local int line;
+static _Thread_local int col;
 
 static char Peek() {
     return *current;
@@ -109,12 +109,62 @@ static TokenType TryEmitKeyword(size_t startOffset, String keywordPart, TokenTyp
     return TOKEN_SYMBOL;
 }
 
+// Keywords that start with the same letter are tried in turn.
+static TokenType TryEmitKeywords(size_t startOffset, const String* keywordParts, const TokenType* keywordTypes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        TokenType type = TryEmitKeyword(startOffset, keywordParts[i], keywordTypes[i]);
+        if (type != TOKEN_SYMBOL) {
+            return type;
+        }
+    }
+
+    return TOKEN_SYMBOL;
+}
+
+static const String cKeywordParts[] = { { "oncat", 5 }, { "ontains", 7 }, { "onj", 3 }, { "ount", 4 }, { "ompare", 6 } };
+static const TokenType cKeywordTypes[] = { TOKEN_CONCAT, TOKEN_CONTAINS, TOKEN_CONJ, TOKEN_COUNT, TOKEN_COMPARE };
+static const String dKeywordParts[] = { { "efun", 4 }, { "issoc", 5 }, { "ot", 2 } };
+static const TokenType dKeywordTypes[] = { TOKEN_DEFUN, TOKEN_DISSOC, TOKEN_DOT };
+static const String fKeywordParts[] = { { "un", 2 }, { "64array", 7 }, { "ind", 3 }, { "ilter", 5 } };
+static const TokenType fKeywordTypes[] = { TOKEN_FUN, TOKEN_F64ARRAY, TOKEN_FIND, TOKEN_FILTER };
+static const String lKeywordParts[] = { { "ength", 5 }, { "ines", 4 } };
+static const TokenType lKeywordTypes[] = { TOKEN_LENGTH, TOKEN_LINES };
+static const String mKeywordParts[] = { { "in", 2 }, { "ax", 2 }, { "ap", 2 } };
+static const TokenType mKeywordTypes[] = { TOKEN_MIN, TOKEN_MAX, TOKEN_MAP };
+static const String hKeywordParts[] = { { "ashmap", 6 }, { "ashset", 6 }, { "ashtable", 8 } };
+static const TokenType hKeywordTypes[] = { TOKEN_HASHMAP, TOKEN_HASHSET, TOKEN_HASHTABLE };
+static const String pKeywordParts[] = { { "rint", 4 }, { "ut", 2 }, { "ush", 3 } };
+static const TokenType pKeywordTypes[] = { TOKEN_PRINT, TOKEN_PUT, TOKEN_PUSH };
+static const String rKeywordParts[] = { { "emove", 5 }, { "ange", 4 }, { "educe", 5 } };
+static const TokenType rKeywordTypes[] = { TOKEN_REMOVE, TOKEN_RANGE, TOKEN_REDUCE };
+static const String sKeywordParts[] = { { "et", 2 }, { "lice", 4 }, { "um", 2 }, { "plit", 4 } };
+static const TokenType sKeywordTypes[] = { TOKEN_SET, TOKEN_SLICE, TOKEN_SUM, TOKEN_SPLIT };
+static const String tKeywordParts[] = { { "olist", 5 }, { "ake", 3 } };
+static const TokenType tKeywordTypes[] = { TOKEN_TOLIST, TOKEN_TAKE };
+
+// The tables of a letter have one part per type, so the count comes from the types.
+#define TRY_EMIT_KEYWORDS(letter) \
+    TryEmitKeywords(1, letter##KeywordParts, letter##KeywordTypes, sizeof(letter##KeywordTypes) / sizeof(letter##KeywordTypes[0]))
+
 static TokenType EmitKeywordOrSymbolType() {
     switch(tokenStart[0]) {
-        case 'p': return TryEmitKeyword(1, (String){ "rint", 4 }, TOKEN_PRINT);
-        case 's': return TryEmitKeyword(1, (String){ "et", 2 }, TOKEN_SET);
-        case 'f': return TryEmitKeyword(1, (String){ "un", 2 }, TOKEN_FUN);
-        case 'd': return TryEmitKeyword(1, (String){ "efun", 4 }, TOKEN_DEFUN);
+        case 'p': return TRY_EMIT_KEYWORDS(p);
+        case 's': return TRY_EMIT_KEYWORDS(s);
+        case 'f': return TRY_EMIT_KEYWORDS(f);
+        case 'd': return TRY_EMIT_KEYWORDS(d);
+        case 'm': return TRY_EMIT_KEYWORDS(m);
+        case 'c': return TRY_EMIT_KEYWORDS(c);
+        case 'h': return TRY_EMIT_KEYWORDS(h);
+        case 'r': return TRY_EMIT_KEYWORDS(r);
+        case 'n': return TryEmitKeyword(1, (String){ "th", 2 }, TOKEN_NTH);
+        case 'v': return TryEmitKeyword(1, (String){ "ec", 2 }, TOKEN_VEC);
+        case 't': return TRY_EMIT_KEYWORDS(t);
+        case 'a': return TryEmitKeyword(1, (String){ "ssoc", 4 }, TOKEN_ASSOC);
+        case 'g': return TryEmitKeyword(1, (String){ "et", 2 }, TOKEN_GET);
+        case 'l': return TRY_EMIT_KEYWORDS(l);
+        case 'j': return TryEmitKeyword(1, (String){ "oin", 3 }, TOKEN_JOIN);
+        case 'i': return TryEmitKeyword(1, (String){ "terate", 6 }, TOKEN_ITERATE);
+        case 'o': return TryEmitKeyword(1, (String){ "ccurrences", 10 }, TOKEN_OCCURRENCES);
         default: return TOKEN_SYMBOL;
     }
 }
@@ -166,6 +216,10 @@ Token ConsumeToken() {
         }
         case ')':
             return EmitToken(TOKEN_PAREN_END);
+        case '[':
+            return EmitToken(TOKEN_BRACKET_START);
+        case ']':
+            return EmitToken(TOKEN_BRACKET_END);
         case '.':
             return EmitToken(TOKEN_CONS);
         case '"':
@@ -206,6 +260,43 @@ const char* MapTokenTypeToStr(TokenType type) {
         case TOKEN_SET: return "TOKEN_SET";
         case TOKEN_FUN: return "TOKEN_FUN";
         case TOKEN_DEFUN: return "TOKEN_DEFUN";
+        case TOKEN_CONCAT: return "TOKEN_CONCAT";
+        case TOKEN_HASHMAP: return "TOKEN_HASHMAP";
+        case TOKEN_HASHSET: return "TOKEN_HASHSET";
+        case TOKEN_ASSOC: return "TOKEN_ASSOC";
+        case TOKEN_DISSOC: return "TOKEN_DISSOC";
+        case TOKEN_GET: return "TOKEN_GET";
+        case TOKEN_CONTAINS: return "TOKEN_CONTAINS";
+        case TOKEN_CONJ: return "TOKEN_CONJ";
+        case TOKEN_HASHTABLE: return "TOKEN_HASHTABLE";
+        case TOKEN_PUT: return "TOKEN_PUT";
+        case TOKEN_REMOVE: return "TOKEN_REMOVE";
+        case TOKEN_COUNT: return "TOKEN_COUNT";
+        case TOKEN_BRACKET_START: return "TOKEN_BRACKET_START";
+        case TOKEN_BRACKET_END: return "TOKEN_BRACKET_END";
+        case TOKEN_NTH: return "TOKEN_NTH";
+        case TOKEN_PUSH: return "TOKEN_PUSH";
+        case TOKEN_SLICE: return "TOKEN_SLICE";
+        case TOKEN_VEC: return "TOKEN_VEC";
+        case TOKEN_TOLIST: return "TOKEN_TOLIST";
+        case TOKEN_F64ARRAY: return "TOKEN_F64ARRAY";
+        case TOKEN_SUM: return "TOKEN_SUM";
+        case TOKEN_MIN: return "TOKEN_MIN";
+        case TOKEN_MAX: return "TOKEN_MAX";
+        case TOKEN_DOT: return "TOKEN_DOT";
+        case TOKEN_LENGTH: return "TOKEN_LENGTH";
+        case TOKEN_FIND: return "TOKEN_FIND";
+        case TOKEN_SPLIT: return "TOKEN_SPLIT";
+        case TOKEN_JOIN: return "TOKEN_JOIN";
+        case TOKEN_OCCURRENCES: return "TOKEN_OCCURRENCES";
+        case TOKEN_COMPARE: return "TOKEN_COMPARE";
+        case TOKEN_RANGE: return "TOKEN_RANGE";
+        case TOKEN_ITERATE: return "TOKEN_ITERATE";
+        case TOKEN_LINES: return "TOKEN_LINES";
+        case TOKEN_TAKE: return "TOKEN_TAKE";
+        case TOKEN_MAP: return "TOKEN_MAP";
+        case TOKEN_FILTER: return "TOKEN_FILTER";
+        case TOKEN_REDUCE: return "TOKEN_REDUCE";
         default: return NULL;
     }
 }
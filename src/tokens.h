@@ -23,6 +23,43 @@ typedef enum {
     TOKEN_SET,
     TOKEN_FUN,
     TOKEN_DEFUN,
+    TOKEN_CONCAT,
+    TOKEN_HASHMAP,
+    TOKEN_HASHSET,
+    TOKEN_ASSOC,
+    TOKEN_DISSOC,
+    TOKEN_GET,
+    TOKEN_CONTAINS,
+    TOKEN_CONJ,
+    TOKEN_HASHTABLE,
+    TOKEN_PUT,
+    TOKEN_REMOVE,
+    TOKEN_COUNT,
+    TOKEN_BRACKET_START,
+    TOKEN_BRACKET_END,
+    TOKEN_NTH,
+    TOKEN_PUSH,
+    TOKEN_SLICE,
+    TOKEN_VEC,
+    TOKEN_TOLIST,
+    TOKEN_F64ARRAY,
+    TOKEN_SUM,
+    TOKEN_MIN,
+    TOKEN_MAX,
+    TOKEN_DOT,
+    TOKEN_LENGTH,
+    TOKEN_FIND,
+    TOKEN_SPLIT,
+    TOKEN_JOIN,
+    TOKEN_OCCURRENCES,
+    TOKEN_COMPARE,
+    TOKEN_RANGE,
+    TOKEN_ITERATE,
+    TOKEN_LINES,
+    TOKEN_TAKE,
+    TOKEN_MAP,
+    TOKEN_FILTER,
+    TOKEN_REDUCE,
     /*
      * This marker is added to signal the end of the
      * token stream.
@@ -1,40 +1,521 @@
 #include <stdio.h>
 #include "values.h"
+#include "hamt.h"
 #include "asserts.h"
 
+// Only the header is initialized, the payload may be smaller than the union.
+Object* AllocateObject(ObjectType type, size_t bytes, Allocator* allocator) {
+    Object* obj = AllocatorAlloc(bytes, allocator);
+    obj->type = type;
+    obj->cdrCode = CDR_NORMAL;
+    obj->refCount = 0;
+    obj->hash = 0;
+
+    return obj;
+}
+
+// -- Strings --
+
+// Small strings are rounded up to keep the next object aligned.
+static size_t GetSmallStringSize(size_t length) {
+    size_t bytes = offsetof(Object, as.string.as.small) + length;
+    size_t alignment = _Alignof(Object);
+    return (bytes + alignment - 1) & ~(alignment - 1);
+}
+
+static Object* CreateSmallString(size_t length, Allocator* allocator) {
+    Object* obj = AllocateObject(OBJECT_STRING, GetSmallStringSize(length), allocator);
+    obj->as.string.length = length;
+    obj->as.string.kind = STRING_SMALL;
+
+    return obj;
+}
+
+static Object* CreateHeapString(const char* chars, size_t length, Allocator* allocator) {
+    Object* obj = AllocateObject(OBJECT_STRING, OBJECT_SIZE(string), allocator);
+    obj->as.string.length = length;
+    obj->as.string.kind = STRING_HEAP;
+    obj->as.string.as.chars = chars;
+
+    return obj;
+}
+
+Object* AllocateStringObject(size_t length, char** chars, Allocator* allocator) {
+    Assert(length <= UINT32_MAX, "The string is too long");
+
+    if (length <= STRING_SMALL_CAPACITY) {
+        Object* obj = CreateSmallString(length, allocator);
+        *chars = obj->as.string.as.small;
+        return obj;
+    }
+
+    *chars = AllocatorAlloc(length, allocator);
+    return CreateHeapString(*chars, length, allocator);
+}
+
 Object* CreateStringObject(String s, Allocator* allocator) {
-    Object* obj = AllocatorAlloc(sizeof(Object), allocator);
-    *obj = (Object) {
-        .type = OBJECT_STRING,
-        .as.string = s,
-    };
+    char* chars = NULL;
+    Object* obj = AllocateStringObject(s.length, &chars, allocator);
+    memcpy(chars, s.start, s.length);
 
     return obj;
 }
 
+Object* CreateStringSlice(Object* str, size_t start, size_t end, Allocator* allocator) {
+    Assert(start <= end && end <= str->as.string.length, "Expected a slice within the string");
+
+    String chars = GetStringChars(str, allocator);
+    if (end - start <= STRING_SMALL_CAPACITY) {
+        return CreateStringObject((String) { .start = chars.start + start, .length = end - start }, allocator);
+    }
+    // strings are immutable, so the characters can be shared
+    return CreateHeapString(chars.start + start, end - start, allocator);
+}
+
+Object* CreateConcatObject(Object* left, Object* right, Allocator* allocator) {
+    size_t length = (size_t)left->as.string.length + right->as.string.length;
+    Assert(length <= UINT32_MAX, "The concatenated string is too long");
+
+    // strings are immutable, so an empty part can be skipped
+    if (left->as.string.length == 0) {
+        return right;
+    } else if (right->as.string.length == 0) {
+        return left;
+    }
+
+    if (length <= STRING_SMALL_CAPACITY) {
+        Object* obj = CreateSmallString(length, allocator);
+        CopyStringChars(left, obj->as.string.as.small);
+        CopyStringChars(right, obj->as.string.as.small + left->as.string.length);
+        return obj;
+    }
+
+    Object* obj = AllocateObject(OBJECT_STRING, OBJECT_SIZE(string), allocator);
+    obj->as.string.length = length;
+    obj->as.string.kind = STRING_ROPE;
+    obj->as.string.as.rope.left = left;
+    obj->as.string.as.rope.right = right;
+
+    return obj;
+}
+
+void CopyStringChars(Object* str, char* dest) {
+    while (str->as.string.kind == STRING_ROPE) {
+        Object* left = str->as.string.as.rope.left;
+        Object* right = str->as.string.as.rope.right;
+        // recurse on the shorter part, so that the depth is logarithmic in the length
+        if (left->as.string.length <= right->as.string.length) {
+            CopyStringChars(left, dest);
+            dest += left->as.string.length;
+            str = right;
+        } else {
+            CopyStringChars(right, dest + left->as.string.length);
+            str = left;
+        }
+    }
+
+    const char* chars = str->as.string.kind == STRING_SMALL ? str->as.string.as.small : str->as.string.as.chars;
+    memcpy(dest, chars, str->as.string.length);
+}
+
+_Thread_local size_t numFlattenedRopes = 0;
+
+size_t GetNumFlattenedRopes() {
+    return numFlattenedRopes;
+}
+
+String GetStringChars(Object* str, Allocator* allocator) {
+    StringData* data = &str->as.string;
+    if (data->kind == STRING_ROPE) {
+        Assert(allocator != NULL, "Flattening a rope requires an allocator");
+        numFlattenedRopes++;
+        char* chars = AllocatorAlloc(data->length, allocator);
+        CopyStringChars(str, chars);
+        // ropes and heap strings have the same size, so the object can be reused
+        data->kind = STRING_HEAP;
+        data->as.chars = chars;
+    }
+
+    const char* chars = data->kind == STRING_SMALL ? data->as.small : data->as.chars;
+    return (String) { .start = chars, .length = data->length };
+}
+
 Object* CreateSymbolObject(String s, Allocator* allocator) {
-    Object* obj = AllocatorAlloc(sizeof(Object), allocator);
-    *obj = (Object) {
-        .type = OBJECT_SYMBOL,
-        .as.symbol = s,
-    };
+    Object* obj = AllocateObject(OBJECT_SYMBOL, OBJECT_SIZE(symbol), allocator);
+    obj->as.symbol = s;
 
     return obj;
 }
 
 Object* CreateConsCellObject(Value head, Value tail, Allocator* allocator) {
-    Object* obj = AllocatorAlloc(sizeof(Object), allocator);
-    ConsCell cell = {
+    Object* obj = AllocateObject(OBJECT_CONS, OBJECT_SIZE(cons), allocator);
+    obj->as.cons = (ConsCell) {
         .head = head,
         .tail = tail,
     };
 
-    *obj = (Object) {
-        .type = OBJECT_CONS,
-        .as.cons = cell,
+    return obj;
+}
+
+Object* CreateListObject(Value* items, size_t count, Value tail, Allocator* allocator) {
+    Assert(count > 0, "A list block needs at least one cell");
+
+    bool isNilTerminated = GetValueType(tail) == VALUE_NIL;
+    size_t lastSize = isNilTerminated ? CONS_COMPACT_SIZE : OBJECT_SIZE(cons);
+    char* block = AllocatorAlloc((count - 1) * CONS_COMPACT_SIZE + lastSize, allocator);
+
+    /*
+     * The block is a single allocation, so freeing a cell on its own would free
+     * the wrong number of bytes from the middle of it. The cells are pinned with
+     * a reference, like interned objects, and only go away with the arena.
+     * A block of one cell is an ordinary object.
+     */
+    uint32_t refCount = count > 1 ? 1 : 0;
+    for (size_t i = 0; i < count; i++) {
+        Object* cell = (Object*)(block + i * CONS_COMPACT_SIZE);
+        cell->type = OBJECT_CONS;
+        cell->cdrCode = CDR_NEXT;
+        cell->refCount = refCount;
+        cell->hash = 0;
+        cell->as.cons.head = items[i];
+    }
+
+    Object* last = (Object*)(block + (count - 1) * CONS_COMPACT_SIZE);
+    if (isNilTerminated) {
+        last->cdrCode = CDR_NIL;
+    } else {
+        last->cdrCode = CDR_NORMAL;
+        last->as.cons.tail = tail;
+    }
+
+    return (Object*)block;
+}
+
+size_t GetListLength(Value list) {
+    size_t length = 0;
+    while (GetValueType(list) == VALUE_OBJECT && ValueAsObject(list)->type == OBJECT_CONS) {
+        list = ConsTail(ValueAsObject(list));
+        length++;
+    }
+    return length;
+}
+
+// -- Keys --
+
+static uint32_t HashPointer(void* ptr) {
+    return (uint32_t)((uintptr_t)ptr >> 3) * 2654435761u;
+}
+
+static bool IsStringKey(Value key) {
+    return GetValueType(key) == VALUE_OBJECT && ValueAsObject(key)->type == OBJECT_STRING;
+}
+
+Value PrepareKey(Value key, Allocator* allocator) {
+    if (IsStringKey(key)) {
+        GetStringChars(ValueAsObject(key), allocator);
+    }
+    return key;
+}
+
+uint32_t HashKey(Value key) {
+    if (IsStringKey(key)) {
+        return HashString(GetStringChars(ValueAsObject(key), NULL));
+    } else if (GetValueType(key) == VALUE_OBJECT && ValueAsObject(key)->hash == 0) {
+        return HashPointer(ValueAsObject(key));
+    }
+    return HashValue(key);
+}
+
+bool KeysEqual(Value first, Value second) {
+    if (IsStringKey(first) && IsStringKey(second)) {
+        return StringEquals(GetStringChars(ValueAsObject(first), NULL), GetStringChars(ValueAsObject(second), NULL));
+    }
+    return ValuesIdentical(first, second);
+}
+
+// -- Symbol table --
+
+/*
+ * Open addressing with linear probing. The capacity is a power of two
+ * and the table grows when it is three quarters full.
+ */
+typedef struct {
+    Object** entries;
+    size_t capacity;
+    size_t count;
+    Allocator* allocator;
+} SymbolTable;
+
+_Thread_local SymbolTable symbolTable = {0};
+
+#define SYMBOL_TABLE_INITIAL_CAPACITY 64
+#define SYMBOL_TABLE_PAGE_SIZE 4096
+
+static size_t FindSymbolSlot(Object** entries, size_t capacity, String name, uint32_t hash) {
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+    while (entries[i] != NULL) {
+        Object* entry = entries[i];
+        if (entry->hash == hash && StringEquals(entry->as.symbol, name)) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static void GrowSymbolTable() {
+    size_t capacity = symbolTable.capacity == 0 ? SYMBOL_TABLE_INITIAL_CAPACITY : symbolTable.capacity * 2;
+    Object** entries = AllocateZeros(capacity * sizeof(Object*));
+
+    for (size_t i = 0; i < symbolTable.capacity; i++) {
+        Object* entry = symbolTable.entries[i];
+        if (entry != NULL) {
+            entries[FindSymbolSlot(entries, capacity, entry->as.symbol, entry->hash)] = entry;
+        }
+    }
+
+    FreeMemory(symbolTable.entries);
+    symbolTable.entries = entries;
+    symbolTable.capacity = capacity;
+}
+
+Object* InternSymbol(String name) {
+    if (symbolTable.allocator == NULL) {
+        symbolTable.allocator = CreateBumpAllocator(SYMBOL_TABLE_PAGE_SIZE, 1);
+        GrowSymbolTable();
+    }
+
+    uint32_t hash = HashString(name);
+    size_t slot = FindSymbolSlot(symbolTable.entries, symbolTable.capacity, name, hash);
+    if (symbolTable.entries[slot] != NULL) {
+        return symbolTable.entries[slot];
+    }
+
+    if ((symbolTable.count + 1) * 4 > symbolTable.capacity * 3) {
+        GrowSymbolTable();
+        slot = FindSymbolSlot(symbolTable.entries, symbolTable.capacity, name, hash);
+    }
+
+    // the name usually points into the source code, which may not outlive the symbol
+    char* chars = AllocatorAlloc(name.length, symbolTable.allocator);
+    memcpy(chars, name.start, name.length);
+    Object* symbol = CreateSymbolObject((String) { .start = chars, .length = name.length }, symbolTable.allocator);
+    symbol->hash = hash;
+    // the table holds a reference, so the VM never collects a symbol
+    symbol->refCount = 1;
+
+    symbolTable.entries[slot] = symbol;
+    symbolTable.count++;
+
+    return symbol;
+}
+
+void FreeSymbolTable() {
+    if (symbolTable.allocator != NULL) {
+        AllocatorFree(symbolTable.allocator);
+    }
+    FreeMemory(symbolTable.entries);
+    symbolTable = (SymbolTable) {0};
+}
+
+// -- Hash-consing --
+
+#define HASH_CONS_INITIAL_CAPACITY 64
+
+static uint32_t CombineHashes(uint32_t h1, uint32_t h2) {
+    return h1 ^ (h2 + 0x9e3779b9u + (h1 << 6) + (h1 >> 2));
+}
+
+static uint64_t GetF64Bits(double d) {
+    uint64_t bits = 0;
+    memcpy(&bits, &d, sizeof(d));
+    return bits;
+}
+
+// Objects use their cached hash, which is only set for canonical objects and symbols.
+uint32_t HashValue(Value v) {
+    uint64_t bits = 0;
+    switch (GetValueType(v)) {
+        case VALUE_NIL: break;
+        case VALUE_F64: bits = GetF64Bits(ValueAsF64(v)); break;
+        case VALUE_I32: bits = (uint32_t)ValueAsI32(v); break;
+        case VALUE_BOOL: bits = ValueAsBool(v); break;
+        case VALUE_OBJECT: return ValueAsObject(v)->hash;
+        case VALUE_OPERATOR: bits = ValueAsOperator(v); break;
+        case VALUE_COMPTIME_OPERATOR: bits = ValueAsComptimeOperator(v); break;
+        case VALUE_FUNCTION: bits = ValueAsFunction(v).location; break;
+        default: break;
+    }
+    return CombineHashes(GetValueType(v), (uint32_t)(bits ^ (bits >> 32)));
+}
+
+bool ValuesIdentical(Value first, Value second) {
+    if (GetValueType(first) != GetValueType(second)) {
+        return false;
+    }
+
+    switch (GetValueType(first)) {
+        case VALUE_NIL: return true;
+        case VALUE_F64: return GetF64Bits(ValueAsF64(first)) == GetF64Bits(ValueAsF64(second));
+        case VALUE_I32: return ValueAsI32(first) == ValueAsI32(second);
+        case VALUE_BOOL: return ValueAsBool(first) == ValueAsBool(second);
+        case VALUE_OBJECT: return ValueAsObject(first) == ValueAsObject(second);
+        case VALUE_OPERATOR: return ValueAsOperator(first) == ValueAsOperator(second);
+        case VALUE_COMPTIME_OPERATOR: return ValueAsComptimeOperator(first) == ValueAsComptimeOperator(second);
+        case VALUE_FUNCTION: return ValueAsFunction(first).location == ValueAsFunction(second).location;
+        default: return false;
+    }
+}
+
+// A string, or a cons cell with the given head and tail.
+typedef struct {
+    ObjectType type;
+    uint32_t hash;
+    String chars;
+    Value head;
+    Value tail;
+} HashConsKey;
+
+static bool HashConsKeyMatches(Object* entry, HashConsKey* key) {
+    if (entry->hash != key->hash || entry->type != key->type) {
+        return false;
+    }
+    if (key->type == OBJECT_STRING) {
+        return StringEquals(GetStringChars(entry, NULL), key->chars);
+    }
+    return ValuesIdentical(ConsHead(entry), key->head) && ValuesIdentical(ConsTail(entry), key->tail);
+}
+
+static Object* FindHashConsEntry(HashConsTable* table, HashConsKey* key) {
+    size_t mask = table->capacity - 1;
+    for (size_t i = key->hash & mask; table->entries[i] != NULL; i = (i + 1) & mask) {
+        if (HashConsKeyMatches(table->entries[i], key)) {
+            return table->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void PutHashConsEntry(Object** entries, size_t capacity, Object* obj) {
+    size_t mask = capacity - 1;
+    size_t i = obj->hash & mask;
+    while (entries[i] != NULL) {
+        i = (i + 1) & mask;
+    }
+    entries[i] = obj;
+}
+
+static void AddHashConsEntry(HashConsTable* table, Object* obj) {
+    if ((table->count + 1) * 4 > table->capacity * 3) {
+        size_t capacity = table->capacity * 2;
+        Object** entries = AllocateZeros(capacity * sizeof(Object*));
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (table->entries[i] != NULL) {
+                PutHashConsEntry(entries, capacity, table->entries[i]);
+            }
+        }
+        FreeMemory(table->entries);
+        table->entries = entries;
+        table->capacity = capacity;
+    }
+
+    // the table allocator holds a reference, so the VM never collects a canonical object
+    obj->refCount = 1;
+    PutHashConsEntry(table->entries, table->capacity, obj);
+    table->count++;
+}
+
+HashConsTable CreateHashConsTable(Allocator* allocator) {
+    Object** entries = AllocateZeros(HASH_CONS_INITIAL_CAPACITY * sizeof(Object*));
+
+    return (HashConsTable) {
+        .entries = entries,
+        .capacity = HASH_CONS_INITIAL_CAPACITY,
+        .count = 0,
+        .allocator = allocator,
+    };
+}
+
+Object* HashConsString(String s, HashConsTable* table) {
+    HashConsKey key = {
+        .type = OBJECT_STRING,
+        .hash = HashString(s),
+        .chars = s,
     };
+    Object* found = FindHashConsEntry(table, &key);
+    if (found != NULL) {
+        return found;
+    }
 
-    return obj;
+    Object* str = CreateStringObject(s, table->allocator);
+    str->hash = key.hash;
+    AddHashConsEntry(table, str);
+
+    return str;
+}
+
+Object* HashConsList(Value* items, size_t count, Value tail, HashConsTable* table) {
+    Assert(count > 0, "A list needs at least one element");
+
+    // look for the longest suffix that is already canonical
+    Value list = tail;
+    size_t numShared = 0;
+    while (numShared < count) {
+        Value head = items[count - numShared - 1];
+        HashConsKey key = {
+            .type = OBJECT_CONS,
+            .hash = CombineHashes(HashValue(head), HashValue(list)),
+            .head = head,
+            .tail = list,
+        };
+        Object* found = FindHashConsEntry(table, &key);
+        if (found == NULL) {
+            break;
+        }
+        list = MAKE_VALUE_OBJECT(found);
+        numShared++;
+    }
+
+    if (numShared == count) {
+        return ValueAsObject(list);
+    }
+
+    // the rest is one new block, the hash of each cell depends on the cell after it
+    size_t numNew = count - numShared;
+    Object* block = CreateListObject(items, numNew, list, table->allocator);
+    for (size_t i = numNew; i > 0; i--) {
+        Object* cell = (Object*)((char*)block + (i - 1) * CONS_COMPACT_SIZE);
+        cell->hash = CombineHashes(HashValue(ConsHead(cell)), HashValue(ConsTail(cell)));
+        AddHashConsEntry(table, cell);
+    }
+
+    return block;
+}
+
+void FreeHashConsTable(HashConsTable* table) {
+    FreeMemory(table->entries);
+    *table = (HashConsTable) {0};
+}
+
+size_t GetObjectSize(Object* obj) {
+    switch (obj->type) {
+        case OBJECT_STRING:
+            return obj->as.string.kind == STRING_SMALL ? GetSmallStringSize(obj->as.string.length) : OBJECT_SIZE(string);
+        case OBJECT_SYMBOL: return OBJECT_SIZE(symbol);
+        case OBJECT_CONS: return obj->cdrCode == CDR_NORMAL ? OBJECT_SIZE(cons) : CONS_COMPACT_SIZE;
+        case OBJECT_MAP:
+        case OBJECT_SET:
+            return OBJECT_SIZE(hamt);
+        case OBJECT_HAMT_NODE: return OBJECT_SIZE(hamtNode) + obj->as.hamtNode.capacity * sizeof(Value);
+        case OBJECT_HASHTABLE: return OBJECT_SIZE(hashTable);
+        case OBJECT_VECTOR: return OBJECT_SIZE(vector);
+        case OBJECT_F64_ARRAY: return OBJECT_SIZE(f64Array);
+        case OBJECT_LAZY_SEQ: return OBJECT_SIZE(lazySeq);
+        default: break;
+    }
+    AssertFailf("Unknown object type %d", obj->type);
+    return 0;
 }
 
 static const char* MapOperatorTypeToStr(OperatorType operator) {
@@ -45,6 +526,41 @@ static const char* MapOperatorTypeToStr(OperatorType operator) {
         case OPERATOR_DIVIDE: return "/";
         case OPERATOR_PRINT: return "print";
         case OPERATOR_SET_GLOBAL: return "set";
+        case OPERATOR_CONCAT: return "concat";
+        case OPERATOR_HASHMAP: return "hashmap";
+        case OPERATOR_HASHSET: return "hashset";
+        case OPERATOR_ASSOC: return "assoc";
+        case OPERATOR_DISSOC: return "dissoc";
+        case OPERATOR_GET: return "get";
+        case OPERATOR_CONTAINS: return "contains";
+        case OPERATOR_CONJ: return "conj";
+        case OPERATOR_HASHTABLE: return "hashtable";
+        case OPERATOR_PUT: return "put";
+        case OPERATOR_REMOVE: return "remove";
+        case OPERATOR_COUNT: return "count";
+        case OPERATOR_NTH: return "nth";
+        case OPERATOR_PUSH: return "push";
+        case OPERATOR_SLICE: return "slice";
+        case OPERATOR_VEC: return "vec";
+        case OPERATOR_TOLIST: return "tolist";
+        case OPERATOR_F64ARRAY: return "f64array";
+        case OPERATOR_SUM: return "sum";
+        case OPERATOR_MIN: return "min";
+        case OPERATOR_MAX: return "max";
+        case OPERATOR_DOT: return "dot";
+        case OPERATOR_LENGTH: return "length";
+        case OPERATOR_FIND: return "find";
+        case OPERATOR_SPLIT: return "split";
+        case OPERATOR_JOIN: return "join";
+        case OPERATOR_OCCURRENCES: return "occurrences";
+        case OPERATOR_COMPARE: return "compare";
+        case OPERATOR_RANGE: return "range";
+        case OPERATOR_ITERATE: return "iterate";
+        case OPERATOR_LINES: return "lines";
+        case OPERATOR_TAKE: return "take";
+        case OPERATOR_MAP: return "map";
+        case OPERATOR_FILTER: return "filter";
+        case OPERATOR_REDUCE: return "reduce";
         default: return NULL;
     }
 }
@@ -61,15 +577,41 @@ static const char* MapObjectTypeToStr(ObjectType object) {
         case OBJECT_STRING: return "OBJECT_STRING";
         case OBJECT_SYMBOL: return "OBJECT_SYMBOL";
         case OBJECT_CONS: return "OBJECT_CONS";
+        case OBJECT_MAP: return "OBJECT_MAP";
+        case OBJECT_SET: return "OBJECT_SET";
+        case OBJECT_HAMT_NODE: return "OBJECT_HAMT_NODE";
+        case OBJECT_HASHTABLE: return "OBJECT_HASHTABLE";
+        case OBJECT_VECTOR: return "OBJECT_VECTOR";
+        case OBJECT_F64_ARRAY: return "OBJECT_F64_ARRAY";
+        case OBJECT_LAZY_SEQ: return "OBJECT_LAZY_SEQ";
         default: return NULL;
     }
 }
 
+static void PrintHamtEntry(Value key, Value value, void* ctx) {
+    Object* hamt = ctx;
+    PrintValue(key);
+    printf(" ");
+    if (hamt->type == OBJECT_MAP) {
+        PrintValue(value);
+        printf(" ");
+    }
+}
+
 static void PrintObject(Object* obj) {
     switch (obj->type) {
         case OBJECT_STRING: {
             printf("\"");
-            PrintString(obj->as.string);
+            if (obj->as.string.kind == STRING_ROPE) {
+                // print ropes without flattening them
+                size_t length = obj->as.string.length;
+                char* chars = AllocateArray(NULL, length, sizeof(char));
+                CopyStringChars(obj, chars);
+                PrintString((String) { .start = chars, .length = length });
+                FreeMemory(chars);
+            } else {
+                PrintString(GetStringChars(obj, NULL));
+            }
             printf("\"");
             break;
         }
@@ -79,16 +621,55 @@ static void PrintObject(Object* obj) {
             printf(">");
             break;
         case OBJECT_CONS: {
-            ConsCell cons = obj->as.cons;
-            Value head = cons.head;
-            Value tail = cons.tail;
-            printf("(");
-            PrintValue(head);
-            printf(" . ");
-            PrintValue(tail);
-            printf(")");
+            // walk the list instead of recursing on the tail
+            size_t depth = 0;
+            Value list = MAKE_VALUE_OBJECT(obj);
+            while (GetValueType(list) == VALUE_OBJECT && ValueAsObject(list)->type == OBJECT_CONS) {
+                Object* cons = ValueAsObject(list);
+                printf("(");
+                PrintValue(ConsHead(cons));
+                printf(" . ");
+                list = ConsTail(cons);
+                depth++;
+            }
+            PrintValue(list);
+            for (size_t i = 0; i < depth; i++) {
+                printf(")");
+            }
             break;
         }
+        case OBJECT_MAP:
+            printf("{ ");
+            HamtForEach(obj, PrintHamtEntry, obj);
+            printf("}");
+            break;
+        case OBJECT_SET:
+            printf("#{ ");
+            HamtForEach(obj, PrintHamtEntry, obj);
+            printf("}");
+            break;
+        case OBJECT_HASHTABLE:
+            printf("<hashtable %d>", obj->as.hashTable.count);
+            break;
+        case OBJECT_VECTOR:
+            printf("[");
+            for (uint32_t i = 0; i < obj->as.vector.count; i++) {
+                printf(i == 0 ? "" : " ");
+                PrintValue(obj->as.vector.items[i]);
+            }
+            printf("]");
+            break;
+        case OBJECT_F64_ARRAY:
+            printf("#f64[");
+            for (uint32_t i = 0; i < obj->as.f64Array.count; i++) {
+                printf(i == 0 ? "%g" : " %g", obj->as.f64Array.items[i]);
+            }
+            printf("]");
+            break;
+        case OBJECT_LAZY_SEQ:
+            // printing does not consume the sequence
+            printf("<lazyseq>");
+            break;
         default:
             AssertFailf("Not implemented for object type %s", MapObjectTypeToStr(obj->type));
             break;
@@ -113,6 +694,7 @@ static const char* MapValueTypeToStr(ValueType valueType) {
     switch(valueType) {
         case VALUE_NIL: return "VALUE_NIL";
         case VALUE_F64: return "VALUE_F64";
+        case VALUE_I32: return "VALUE_I32";
         case VALUE_BOOL: return "VALUE_BOOL";
         case VALUE_OBJECT: return "VALUE_OBJECT";
         case VALUE_OPERATOR: return "VALUE_OPERATOR";
@@ -122,26 +704,32 @@ static const char* MapValueTypeToStr(ValueType valueType) {
 }
 
 void PrintValue(Value value) {
-    switch(value.type) {
+    switch(GetValueType(value)) {
         case VALUE_NIL:
             printf("()");
             break;
         case VALUE_F64:
-            printf("%g", value.as.f64);
+            printf("%g", ValueAsF64(value));
+            break;
+        case VALUE_I32:
+            printf("%d", ValueAsI32(value));
+            break;
+        case VALUE_BOOL:
+            printf("%s", ValueAsBool(value) ? "true" : "false");
             break;
         case VALUE_OBJECT:
-            PrintObject(value.as.object);
+            PrintObject(ValueAsObject(value));
             break;
         case VALUE_OPERATOR:
-            PrintOperator(value.as.operator);
+            PrintOperator(ValueAsOperator(value));
             break;
         case VALUE_COMPTIME_OPERATOR:
-            PrintComptimeOperator(value.as.comptimeOperator);
+            PrintComptimeOperator(ValueAsComptimeOperator(value));
             break;
         default: {
-            const char* str = MapValueTypeToStr(value.type);
+            const char* str = MapValueTypeToStr(GetValueType(value));
             if (str == NULL) {
-                AssertFailf("Not implemented for value type enum %d (no string mapping found)", value.type);
+                AssertFailf("Not implemented for value type enum %d (no string mapping found)", GetValueType(value));
             } else {
                 AssertFailf("Not implemented for value type %s", str);
             }
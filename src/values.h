@@ -2,11 +2,15 @@
  * These value types represent two things:
  * 1. compile time values attached to AST atoms
  * 2. runtime values
+ *
+ * Values are either tagged unions or NaN-boxed, depending on if
+ * VALUE_NAN_BOXING is defined. Always go through the accessors below.
  */
 #ifndef values_h
 #define values_h
 
 #include <stdint.h>
+#include <string.h>
 
 #include "memory.h"
 #include "common.h"
@@ -19,6 +23,42 @@ typedef enum {
     OPERATOR_DIVIDE,
     OPERATOR_PRINT,
     OPERATOR_SET_GLOBAL,
+    OPERATOR_CONCAT,
+    OPERATOR_HASHMAP,
+    OPERATOR_HASHSET,
+    OPERATOR_ASSOC,
+    OPERATOR_DISSOC,
+    OPERATOR_GET,
+    OPERATOR_CONTAINS,
+    OPERATOR_CONJ,
+    OPERATOR_HASHTABLE,
+    OPERATOR_PUT,
+    OPERATOR_REMOVE,
+    OPERATOR_COUNT,
+    OPERATOR_NTH,
+    OPERATOR_PUSH,
+    OPERATOR_SLICE,
+    OPERATOR_VEC,
+    OPERATOR_TOLIST,
+    OPERATOR_F64ARRAY,
+    OPERATOR_SUM,
+    OPERATOR_MIN,
+    OPERATOR_MAX,
+    OPERATOR_DOT,
+    OPERATOR_LENGTH,
+    OPERATOR_FIND,
+    OPERATOR_SPLIT,
+    OPERATOR_JOIN,
+    OPERATOR_OCCURRENCES,
+    OPERATOR_COMPARE,
+    OPERATOR_RANGE,
+    OPERATOR_ITERATE,
+    OPERATOR_LINES,
+    OPERATOR_TAKE,
+    OPERATOR_MAP,
+    OPERATOR_FILTER,
+    OPERATOR_REDUCE,
+    OPERATOR_ENUM_COUNT,
 } OperatorType;
 
 typedef enum {
@@ -35,6 +75,7 @@ typedef enum {
     VALUE_OPERATOR,
     VALUE_COMPTIME_OPERATOR,
     VALUE_FUNCTION,
+    VALUE_I32,
 } ValueType;
 
 typedef struct Object Object;
@@ -43,6 +84,113 @@ typedef struct {
     uint32_t location;
 } Function;
 
+#ifdef VALUE_NAN_BOXING
+/*
+ * NaN-boxed values fit in 64 bits.
+ *
+ * Any double that is not a quiet NaN with the bits of QNAN set is stored
+ * as is. Arithmetic only ever produces the canonical NaN, so the remaining
+ * NaN space is free to use for the other types.
+ *
+ * Object    = sign bit + QNAN + 48 bit pointer
+ * Others    = QNAN + type in bits 32-47 + 32 bit payload
+ */
+typedef struct {
+    uint64_t bits;
+} Value;
+
+#define VALUE_SIGN_BIT ((uint64_t)0x8000000000000000)
+#define VALUE_QNAN ((uint64_t)0x7ffc000000000000)
+#define VALUE_TYPE_SHIFT 32
+#define VALUE_PAYLOAD_MASK ((uint64_t)0xffffffff)
+
+static inline Value MakeBoxedValue(ValueType type, uint32_t payload) {
+    return (Value) { .bits = VALUE_QNAN | ((uint64_t)type << VALUE_TYPE_SHIFT) | payload };
+}
+
+static inline uint32_t GetValuePayload(Value v) {
+    return (uint32_t)(v.bits & VALUE_PAYLOAD_MASK);
+}
+
+static inline ValueType GetValueType(Value v) {
+    if ((v.bits & VALUE_QNAN) != VALUE_QNAN) {
+        return VALUE_F64;
+    }
+    if (v.bits & VALUE_SIGN_BIT) {
+        return VALUE_OBJECT;
+    }
+    return (ValueType)((v.bits >> VALUE_TYPE_SHIFT) & 0xffff);
+}
+
+static inline Value MakeValueNil() {
+    return MakeBoxedValue(VALUE_NIL, 0);
+}
+
+static inline Value MakeValueF64(double d) {
+    Value v;
+    memcpy(&v.bits, &d, sizeof(double));
+    return v;
+}
+
+static inline Value MakeValueBool(bool b) {
+    return MakeBoxedValue(VALUE_BOOL, b);
+}
+
+static inline Value MakeValueObject(Object* obj) {
+    return (Value) { .bits = VALUE_SIGN_BIT | VALUE_QNAN | (uint64_t)(uintptr_t)obj };
+}
+
+static inline Value MakeValueOperator(OperatorType op) {
+    return MakeBoxedValue(VALUE_OPERATOR, op);
+}
+
+static inline Value MakeValueComptimeOperator(ComptimeOperatorType op) {
+    return MakeBoxedValue(VALUE_COMPTIME_OPERATOR, op);
+}
+
+static inline Value MakeValueFunction(Function function) {
+    return MakeBoxedValue(VALUE_FUNCTION, function.location);
+}
+
+static inline Value MakeValueI32(int32_t i) {
+    return MakeBoxedValue(VALUE_I32, (uint32_t)i);
+}
+
+static inline double ValueAsF64(Value v) {
+    double d;
+    memcpy(&d, &v.bits, sizeof(double));
+    return d;
+}
+
+static inline bool ValueAsBool(Value v) {
+    return GetValuePayload(v) != 0;
+}
+
+static inline Object* ValueAsObject(Value v) {
+    return (Object*)(uintptr_t)(v.bits & ~(VALUE_SIGN_BIT | VALUE_QNAN));
+}
+
+static inline OperatorType ValueAsOperator(Value v) {
+    return (OperatorType)GetValuePayload(v);
+}
+
+static inline ComptimeOperatorType ValueAsComptimeOperator(Value v) {
+    return (ComptimeOperatorType)GetValuePayload(v);
+}
+
+static inline Function ValueAsFunction(Value v) {
+    return (Function) { .location = GetValuePayload(v) };
+}
+
+static inline int32_t ValueAsI32(Value v) {
+    return (int32_t)GetValuePayload(v);
+}
+
+#else
+/*
+ * Tagged values are a type and a union of the possible payloads.
+ * This is the default, because it is easier to inspect in a debugger.
+ */
 typedef struct {
     ValueType type;
     union {
@@ -52,13 +200,95 @@ typedef struct {
         OperatorType operator;
         ComptimeOperatorType comptimeOperator;
         Function function;
+        int32_t i32;
     } as;
 } Value;
 
+static inline ValueType GetValueType(Value v) {
+    return v.type;
+}
+
+static inline Value MakeValueNil() {
+    return (Value) { .type = VALUE_NIL };
+}
+
+static inline Value MakeValueF64(double d) {
+    return (Value) { .type = VALUE_F64, .as.f64 = d };
+}
+
+static inline Value MakeValueBool(bool b) {
+    return (Value) { .type = VALUE_BOOL, .as.boolValue = b };
+}
+
+static inline Value MakeValueObject(Object* obj) {
+    return (Value) { .type = VALUE_OBJECT, .as.object = obj };
+}
+
+static inline Value MakeValueOperator(OperatorType op) {
+    return (Value) { .type = VALUE_OPERATOR, .as.operator = op };
+}
+
+static inline Value MakeValueComptimeOperator(ComptimeOperatorType op) {
+    return (Value) { .type = VALUE_COMPTIME_OPERATOR, .as.comptimeOperator = op };
+}
+
+static inline Value MakeValueFunction(Function function) {
+    return (Value) { .type = VALUE_FUNCTION, .as.function = function };
+}
+
+static inline Value MakeValueI32(int32_t i) {
+    return (Value) { .type = VALUE_I32, .as.i32 = i };
+}
+
+static inline double ValueAsF64(Value v) {
+    return v.as.f64;
+}
+
+static inline bool ValueAsBool(Value v) {
+    return v.as.boolValue;
+}
+
+static inline Object* ValueAsObject(Value v) {
+    return v.as.object;
+}
+
+static inline OperatorType ValueAsOperator(Value v) {
+    return v.as.operator;
+}
+
+static inline ComptimeOperatorType ValueAsComptimeOperator(Value v) {
+    return v.as.comptimeOperator;
+}
+
+static inline Function ValueAsFunction(Value v) {
+    return v.as.function;
+}
+
+static inline int32_t ValueAsI32(Value v) {
+    return v.as.i32;
+}
+
+#endif
+
+#define MAKE_VALUE_NIL() MakeValueNil()
+#define MAKE_VALUE_F64(x) MakeValueF64(x)
+#define MAKE_VALUE_I32(x) MakeValueI32(x)
+#define MAKE_VALUE_BOOL(b) MakeValueBool(b)
+#define MAKE_VALUE_OBJECT(obj) MakeValueObject(obj)
+#define MAKE_VALUE_OPERATOR(op) MakeValueOperator(op)
+#define MAKE_VALUE_COMPTIME_OPERATOR(op) MakeValueComptimeOperator(op)
+
 typedef enum {
     OBJECT_STRING,
     OBJECT_SYMBOL,
     OBJECT_CONS,
+    OBJECT_MAP,
+    OBJECT_SET,
+    OBJECT_HAMT_NODE,
+    OBJECT_HASHTABLE,
+    OBJECT_VECTOR,
+    OBJECT_F64_ARRAY,
+    OBJECT_LAZY_SEQ,
 } ObjectType;
 
 typedef struct {
@@ -66,30 +296,271 @@ typedef struct {
     Value tail;
 } ConsCell;
 
+/*
+ * Strings own their characters. Short strings are stored in the object itself
+ * and longer strings in a separate allocation. A concatenation is a rope that
+ * shares its two parts, and it is only flattened to contiguous characters when
+ * they are needed. This keeps building a string piece by piece linear.
+ */
+typedef enum {
+    STRING_SMALL, // only as many bytes of the small buffer as needed are allocated
+    STRING_HEAP,
+    STRING_ROPE,
+} StringKind;
+
+#define STRING_SMALL_CAPACITY 16
+
+typedef struct {
+    uint32_t length;
+    uint32_t kind;
+    union {
+        char small[STRING_SMALL_CAPACITY];
+        const char* chars;
+        struct {
+            Object* left;
+            Object* right;
+        } rope;
+    } as;
+} StringData;
+
+/*
+ * Lists are CDR-coded. A list is built as one block of consecutive cons cells,
+ * where each cell only stores its head and the cdr code says where the tail is.
+ * Only the last cell of a block stores its tail, and only if it is not nil,
+ * which is how a list shares a tail it did not build itself.
+ *
+ * Every cell is still an object, so a pointer into the middle of a block is
+ * a valid list. Always go through ConsHead and ConsTail.
+ */
+typedef enum {
+    CDR_NORMAL, // the tail is stored in the cell
+    CDR_NEXT, // the tail is the cell right after this one
+    CDR_NIL, // the tail is nil
+} CdrCode;
+
+/*
+ * Maps and sets are persistent hash array mapped tries, see hamt.h.
+ * A transient map or set has a non-zero edit id and is updated in place.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t edit;
+    Object* root;
+} HamtData;
+
+/*
+ * A trie node is followed by capacity values. The bitmaps say which of the 32
+ * branches hold an entry and which hold a child node. Below the deepest level
+ * the hash is used up, and dataMap is the number of colliding entries instead.
+ */
+typedef struct {
+    uint32_t dataMap;
+    uint32_t nodeMap;
+    // nodes created by a transient can be updated in place by the same transient
+    uint32_t edit;
+    uint32_t capacity;
+} HamtNodeData;
+
+/*
+ * A mutable hash table, see hashtable.h. The slots live in a separate block,
+ * which starts with one control byte per slot followed by the key and value
+ * of each slot.
+ */
+typedef struct {
+    uint32_t count;
+    // the number of slots, a power of two and at least one probe group
+    uint32_t capacity;
+    // inserts left before the table has to be rehashed
+    uint32_t growthLeft;
+    uint8_t* controls;
+} HashTableData;
+
+// A growable array, see vector.h. The items live in a separate block.
+typedef struct {
+    uint32_t count;
+    uint32_t capacity;
+    Value* items;
+} VectorData;
+
+// Unboxed doubles, see f64array.h. The items live in a separate aligned block.
+typedef struct {
+    uint32_t count;
+    double* items;
+} F64ArrayData;
+
+// A sequence that is only produced while it is consumed, see lazyseq.h.
+typedef enum {
+    SEQ_RANGE,
+    SEQ_ITERATE,
+    SEQ_LINES,
+    SEQ_MAP,
+    SEQ_FILTER,
+    SEQ_TAKE,
+} SeqKind;
+
+typedef struct {
+    uint32_t kind;
+    union {
+        struct {
+            int32_t start;
+            int32_t end;
+        } range;
+        struct {
+            Value fn;
+            Value seed;
+        } iterate;
+        Object* path;
+        // map and filter
+        struct {
+            Value fn;
+            Value source;
+        } transform;
+        struct {
+            uint32_t count;
+            Value source;
+        } take;
+    } as;
+} LazySeqData;
+
+/*
+ * Objects are variable sized. The header is one packed word with the type,
+ * the cdr code of cons cells and the reference count. It is followed by only
+ * the part of the payload union that the object uses, so a symbol does not
+ * pay for a cons cell.
+ */
+#define OBJECT_TYPE_BITS 6
+#define OBJECT_CDR_CODE_BITS 2
+#define OBJECT_REFCOUNT_BITS 24
+#define OBJECT_MAX_REFCOUNT ((1u << OBJECT_REFCOUNT_BITS) - 1)
+
 struct Object {
-    ObjectType type;
-    int refCount;
+    uint32_t type : OBJECT_TYPE_BITS;
+    uint32_t cdrCode : OBJECT_CDR_CODE_BITS;
+    uint32_t refCount : OBJECT_REFCOUNT_BITS;
+    // cached hash of interned and hash-consed objects, fits in the padding before the payload
+    uint32_t hash;
     union {
-        String string;
+        StringData string;
         String symbol;
         ConsCell cons;
+        HamtData hamt;
+        HamtNodeData hamtNode;
+        HashTableData hashTable;
+        VectorData vector;
+        F64ArrayData f64Array;
+        LazySeqData lazySeq;
     } as;
 };
 
+// Bytes taken by an object that uses the given member of the payload union.
+#define OBJECT_SIZE(member) (offsetof(Object, as) + sizeof(((Object*)0)->as.member))
+
+// A cons cell that does not store its tail.
+#define CONS_COMPACT_SIZE OBJECT_SIZE(cons.head)
 
-#define MAKE_VALUE_NIL() (Value) { .type = VALUE_NIL }
-#define MAKE_VALUE_F64(x) (Value) { .type = VALUE_F64, .as.f64 = x }
-#define MAKE_VALUE_BOOL(b) (Value) { .type = VALUE_BOOL, .as.boolValue = b }
-#define MAKE_VALUE_OBJECT(obj) (Value) { .type = VALUE_OBJECT, .as.object = obj }
-#define MAKE_VALUE_OPERATOR(op) (Value) { .type = VALUE_OPERATOR, .as.operator = op }
-#define MAKE_VALUE_COMPTIME_OPERATOR(op) (Value) { .type = VALUE_COMPTIME_OPERATOR, .as.comptimeOperator = op }
+size_t GetObjectSize(Object* obj);
+// Allocates an object and initializes its header. The payload is left to the caller.
+Object* AllocateObject(ObjectType type, size_t bytes, Allocator* allocator);
 
+// Copies the characters of s.
 Object* CreateStringObject(String s, Allocator* allocator);
+// A string of the given length whose characters are written by the caller.
+Object* AllocateStringObject(size_t length, char** chars, Allocator* allocator);
+// Short slices are copied, longer slices share the characters of the flattened string.
+Object* CreateStringSlice(Object* str, size_t start, size_t end, Allocator* allocator);
+// Short results are copied, longer results are ropes.
+Object* CreateConcatObject(Object* left, Object* right, Allocator* allocator);
+// Copies the characters of any kind of string to a buffer of at least the string length.
+void CopyStringChars(Object* str, char* dest);
+// The characters of a string. A rope is flattened in place, into the given allocator.
+String GetStringChars(Object* str, Allocator* allocator);
+/*
+ * Ropes flattened on this thread so far. A rope that is flattened after an
+ * arena mark points into the memory that releasing the mark frees.
+ */
+size_t GetNumFlattenedRopes();
+// Creates a symbol that is not interned. Use InternSymbol for symbols in programs.
 Object* CreateSymbolObject(String s, Allocator* allocator);
 Object* CreateConsCellObject(Value head, Value tail, Allocator* allocator);
+// Creates the list (items[0] items[1] ... items[count - 1] . tail) as a single block.
+Object* CreateListObject(Value* items, size_t count, Value tail, Allocator* allocator);
 
 DA_DECLARE(Value);
 
+static inline Value ConsHead(Object* cons) {
+    return cons->as.cons.head;
+}
+
+static inline Value ConsTail(Object* cons) {
+    switch (cons->cdrCode) {
+        case CDR_NEXT: return MAKE_VALUE_OBJECT((Object*)((char*)cons + CONS_COMPACT_SIZE));
+        case CDR_NIL: return MAKE_VALUE_NIL();
+        default: return cons->as.cons.tail;
+    }
+}
+
+// Number of cons cells in a list, not counting a non-nil tail.
+size_t GetListLength(Value list);
+
+/*
+ * Keys of maps, sets and hash tables. Numbers and strings are compared by
+ * value and other objects by identity. A key is prepared once, which flattens
+ * strings so that hashing and comparing them never has to allocate.
+ */
+Value PrepareKey(Value key, Allocator* allocator);
+uint32_t HashKey(Value key);
+bool KeysEqual(Value first, Value second);
+
+/*
+ * Symbols are interned, so there is a single symbol object per name
+ * and symbols are equal if they are the same object.
+ *
+ * The symbol table owns its symbols and their names, and keeps a reference
+ * to each of them. The table is per thread, like the rest of the pipeline.
+ * FreeSymbolTable invalidates every symbol created on the thread.
+ */
+Object* InternSymbol(String name);
+void FreeSymbolTable();
+
+// Same type and same payload. Objects are compared by identity.
+bool ValuesIdentical(Value first, Value second);
+// Consistent with ValuesIdentical. Objects use their cached hash, which may be 0.
+uint32_t HashValue(Value v);
+
+/*
+ * Hash-consing maps structurally equal strings and lists to a single canonical
+ * object, so canonical values are equal if and only if they are identical.
+ *
+ * Lists are canonical cell by cell. Every cell of a new list block is added to
+ * the table, so a list shares the longest suffix that is already in the table.
+ * The parts of a list must be canonical already, that is numbers, symbols and
+ * other hash-consed objects.
+ *
+ * Canonical objects are immutable and are allocated with the table allocator,
+ * which keeps a reference to them. They outlive the table itself.
+ */
+typedef struct {
+    Object** entries;
+    size_t capacity;
+    size_t count;
+    Allocator* allocator;
+} HashConsTable;
+
+HashConsTable CreateHashConsTable(Allocator* allocator);
+Object* HashConsString(String s, HashConsTable* table);
+Object* HashConsList(Value* items, size_t count, Value tail, HashConsTable* table);
+void FreeHashConsTable(HashConsTable* table);
+
+// Numbers are either VALUE_I32 or VALUE_F64. Integers are converted exactly.
+static inline bool IsNumber(Value v) {
+    ValueType type = GetValueType(v);
+    return type == VALUE_I32 || type == VALUE_F64;
+}
+
+static inline double NumberAsF64(Value v) {
+    return GetValueType(v) == VALUE_I32 ? ValueAsI32(v) : ValueAsF64(v);
+}
+
 void PrintValue(Value v);
 
 #endif
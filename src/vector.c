@@ -0,0 +1,66 @@
+#include <string.h>
+#include "vector.h"
+#include "asserts.h"
+
+#define VECTOR_MIN_CAPACITY 4
+
+static Object* AllocateVector(size_t capacity, Allocator* allocator) {
+    Assert(capacity <= UINT32_MAX, "Too many vector items");
+
+    Object* vector = AllocateObject(OBJECT_VECTOR, OBJECT_SIZE(vector), allocator);
+    vector->as.vector = (VectorData) {
+        .count = 0,
+        .capacity = capacity,
+        .items = capacity == 0 ? NULL : AllocatorAlloc(capacity * sizeof(Value), allocator),
+    };
+    return vector;
+}
+
+Object* CreateVectorObject(Value* items, size_t count, Allocator* allocator) {
+    Object* vector = AllocateVector(count, allocator);
+    if (count > 0) {
+        memcpy(vector->as.vector.items, items, count * sizeof(Value));
+    }
+    vector->as.vector.count = count;
+    return vector;
+}
+
+Object* CreateVectorFromList(Value list, Allocator* allocator) {
+    Object* vector = AllocateVector(GetListLength(list), allocator);
+    Value* items = vector->as.vector.items;
+    while (GetValueType(list) == VALUE_OBJECT && ValueAsObject(list)->type == OBJECT_CONS) {
+        items[vector->as.vector.count++] = ConsHead(ValueAsObject(list));
+        list = ConsTail(ValueAsObject(list));
+    }
+    return vector;
+}
+
+Object* CreateVectorSlice(Object* vector, size_t start, size_t end, Allocator* allocator) {
+    Assert(start <= end && end <= vector->as.vector.count, "Expected a slice within the vector");
+    return CreateVectorObject(vector->as.vector.items + start, end - start, allocator);
+}
+
+Value VectorToList(Object* vector, Allocator* allocator) {
+    if (vector->as.vector.count == 0) {
+        return MAKE_VALUE_NIL();
+    }
+    Object* list = CreateListObject(vector->as.vector.items, vector->as.vector.count, MAKE_VALUE_NIL(), allocator);
+    return MAKE_VALUE_OBJECT(list);
+}
+
+void VectorPush(Object* vector, Value value, Allocator* allocator) {
+    VectorData* data = &vector->as.vector;
+    if (data->count == data->capacity) {
+        size_t capacity = data->capacity < VECTOR_MIN_CAPACITY ? VECTOR_MIN_CAPACITY : (size_t)data->capacity * 2;
+        Assert(capacity <= UINT32_MAX, "Too many vector items");
+
+        Value* items = AllocatorAlloc(capacity * sizeof(Value), allocator);
+        if (data->count > 0) {
+            memcpy(items, data->items, data->count * sizeof(Value));
+            AllocatorFreeObject(data->items, data->capacity * sizeof(Value), allocator);
+        }
+        data->items = items;
+        data->capacity = capacity;
+    }
+    data->items[data->count++] = value;
+}
@@ -0,0 +1,21 @@
+/*
+ * Vectors are contiguous arrays of values with constant time indexing.
+ * Pushing to a vector updates it in place and grows it when it is full.
+ */
+#ifndef vector_h
+#define vector_h
+
+#include "values.h"
+
+// Copies the items.
+Object* CreateVectorObject(Value* items, size_t count, Allocator* allocator);
+// Copies the items of a proper list.
+Object* CreateVectorFromList(Value list, Allocator* allocator);
+// Copies the items from start up to but not including end.
+Object* CreateVectorSlice(Object* vector, size_t start, size_t end, Allocator* allocator);
+// Builds the items as a single list block. An empty vector is nil.
+Value VectorToList(Object* vector, Allocator* allocator);
+
+void VectorPush(Object* vector, Value value, Allocator* allocator);
+
+#endif
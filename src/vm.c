@@ -3,24 +3,46 @@
 #include "asserts.h"
 #include "da.h"
 #include "bytecode.h"
+#include "hamt.h"
+#include "hashtable.h"
+#include "vector.h"
+#include "f64array.h"
+#include "stringops.h"
+#include "lazyseq.h"
 
 typedef struct {
     size_t programCounter;
     ByteDa byteCode;
+    ValueDa constants;
     ValueDa values;
 } VmState;
 
-VmState vmState = {0};
+_Thread_local VmState vmState = {0};
 
 typedef Object* ObjectPtr;
 DA_DECLARE(ObjectPtr);
-ObjectPtrDa freeList = {0};
+_Thread_local ObjectPtrDa freeList = {0};
 
-Allocator* objectAllocator = NULL;
+_Thread_local Allocator* objectAllocator = NULL;
+
+// The value stack and free list are kept between runs, up to the retention.
+_Thread_local size_t vmRetentionBytes = VM_DEFAULT_RETENTION_BYTES;
+
+// Empties a dynamic array for the next run. Keeps the buffer unless it is too large.
+#define RETAIN_DA(da, type) \
+    do { \
+        if ((da)->items == NULL || (da)->capacity * sizeof((da)->items[0]) > vmRetentionBytes) { \
+            DA_FREE(da); \
+            *(da) = DA_MAKE_DEFAULT(type); \
+        } \
+        (da)->count = 0; \
+    } while(0)
 
 static void PushValue(Value val) {
-    if (val.type == VALUE_OBJECT) {
-        val.as.object->refCount++;
+    if (GetValueType(val) == VALUE_OBJECT) {
+        Object* obj = ValueAsObject(val);
+        Assert(obj->refCount < OBJECT_MAX_REFCOUNT, "Too many references to an object");
+        obj->refCount++;
     }
 
     DA_APPEND(&vmState.values, val);
@@ -29,15 +51,16 @@ static void PushValue(Value val) {
 static Value PopValue() {
     Value val = DA_POP(&vmState.values);
 
-    if (val.type == VALUE_OBJECT) {
-        Assertf(val.as.object->refCount > 0,
+    if (GetValueType(val) == VALUE_OBJECT) {
+        Object* obj = ValueAsObject(val);
+        Assertf(obj->refCount > 0,
                 "Unexpected refcount %d. Objects on the stack should have at least one reference.",
-                val.as.object->refCount);
-        val.as.object->refCount--;
+                obj->refCount);
+        obj->refCount--;
 
         // soft delete - handled by GC later if the refcount stays zero
-        if (val.as.object->refCount == 0) {
-            DA_APPEND(&freeList, val.as.object);
+        if (obj->refCount == 0) {
+            DA_APPEND(&freeList, obj);
         }
     }
 
@@ -48,9 +71,9 @@ static Value PopValue() {
 static void CollectGarbage() {
     for (int i = 0; i < freeList.count; i++) {
         Object* item = freeList.items[i];
-        DA_REMOVE_UNORDERED(&freeList, i);
-        AllocatorFreeObject(item, sizeof(Object), objectAllocator);
+        AllocatorFreeObject(item, GetObjectSize(item), objectAllocator);
     }
+    freeList.count = 0;
 }
 
 static bool IsDone() {
@@ -87,100 +110,875 @@ static VmResult CreateSuccess() {
     return result;
 }
 
-#define BINARY_OP(o) \
+#define ARITHMETIC_ERROR_MESSAGE "Arithmetic operator failed. Expected numbers or f64 arrays of the same length."
+
+/*
+ * Integers stay integers as long as the result fits, otherwise
+ * the operation is done with doubles, like any mixed arithmetic.
+ */
+#define BINARY_OP(o, checkedOp, f64Op) \
     do { \
         Value v1 = PopValue(); \
         Value v2 = PopValue(); \
-        if (v1.type != VALUE_F64 || v2.type != VALUE_F64) { \
-            return CreateError("Arithmetic operator failed. Expected F64 values."); \
+        int32_t n = 0; \
+        Value array = MAKE_VALUE_NIL(); \
+        if (GetValueType(v1) == VALUE_I32 && GetValueType(v2) == VALUE_I32 \
+                && !checkedOp(ValueAsI32(v1), ValueAsI32(v2), &n)) { \
+            PushValue(MAKE_VALUE_I32(n)); \
+        } else if (IsNumber(v1) && IsNumber(v2)) { \
+            PushValue(MAKE_VALUE_F64(NumberAsF64(v1) o NumberAsF64(v2))); \
+        } else if (TryF64ArrayArithmetic(f64Op, v1, v2, &array, allocator)) { \
+            PushValue(array); \
+        } else { \
+            return CreateError(ARITHMETIC_ERROR_MESSAGE); \
         } \
-        PushValue(MAKE_VALUE_F64(v1.as.f64 o v2.as.f64)); \
     } while(0)
 
-VmResult ExecuteByteCode(ByteDa byteCode, Allocator* allocator) {
-    vmState = (VmState) {
-        .programCounter = 0,
-        .byteCode = byteCode,
-        .values = DA_MAKE_DEFAULT(Value),
+static bool IsStringValue(Value v) {
+    return GetValueType(v) == VALUE_OBJECT && ValueAsObject(v)->type == OBJECT_STRING;
+}
+
+static bool IsObjectValue(Value v, ObjectType type) {
+    return GetValueType(v) == VALUE_OBJECT && ValueAsObject(v)->type == type;
+}
+
+static bool IsMapOrSetValue(Value v) {
+    return IsObjectValue(v, OBJECT_MAP) || IsObjectValue(v, OBJECT_SET);
+}
+
+/*
+ * An f64 array is combined element-wise with another array of the
+ * same length, and a number on either side applies to every element.
+ */
+static bool TryF64ArrayArithmetic(F64Op op, Value v1, Value v2, Value* result, Allocator* allocator) {
+    bool isArray1 = IsObjectValue(v1, OBJECT_F64_ARRAY);
+    bool isArray2 = IsObjectValue(v2, OBJECT_F64_ARRAY);
+    Object* array = NULL;
+    if (isArray1 && isArray2) {
+        if (ValueAsObject(v1)->as.f64Array.count != ValueAsObject(v2)->as.f64Array.count) {
+            return false;
+        }
+        array = F64ArrayArithmetic(op, ValueAsObject(v1), ValueAsObject(v2), allocator);
+    } else if (isArray1 && IsNumber(v2)) {
+        array = F64ArrayScalarArithmetic(op, ValueAsObject(v1), NumberAsF64(v2), allocator);
+    } else if (IsNumber(v1) && isArray2) {
+        array = F64ScalarArrayArithmetic(op, NumberAsF64(v1), ValueAsObject(v2), allocator);
+    } else {
+        return false;
+    }
+    *result = MAKE_VALUE_OBJECT(array);
+    return true;
+}
+
+// Finds the length of a list that ends with nil.
+static bool TryGetProperListLength(Value list, size_t* length) {
+    *length = 0;
+    while (GetValueType(list) == VALUE_OBJECT && ValueAsObject(list)->type == OBJECT_CONS) {
+        list = ConsTail(ValueAsObject(list));
+        (*length)++;
+    }
+    return GetValueType(list) == VALUE_NIL;
+}
+
+// Builds a map or set from a list with a transient, so that no intermediate versions are allocated.
+static Object* CreateHamtFromList(ObjectType type, Value list, Allocator* allocator) {
+    Object* empty = type == OBJECT_MAP ? CreateMapObject(allocator) : CreateSetObject(allocator);
+    Object* transient = HamtTransient(empty, allocator);
+
+    while (GetValueType(list) == VALUE_OBJECT) {
+        Object* cons = ValueAsObject(list);
+        Value key = ConsHead(cons);
+        list = ConsTail(cons);
+
+        Value value = MAKE_VALUE_NIL();
+        if (type == OBJECT_MAP) {
+            value = ConsHead(ValueAsObject(list));
+            list = ConsTail(ValueAsObject(list));
+        }
+        HamtTransientAssoc(transient, key, value, allocator);
+    }
+
+    return HamtPersistent(transient);
+}
+
+// Unboxes the numbers in a list or vector. Returns NULL if there is anything else.
+static Object* CreateF64ArrayFromValues(Value source, Allocator* allocator) {
+    size_t count = 0;
+    if (IsObjectValue(source, OBJECT_VECTOR)) {
+        count = ValueAsObject(source)->as.vector.count;
+    } else if (!TryGetProperListLength(source, &count) || count > UINT32_MAX) {
+        return NULL;
+    }
+
+    Object* array = CreateF64ArrayObject(count, allocator);
+    for (size_t i = 0; i < count; i++) {
+        Value v;
+        if (IsObjectValue(source, OBJECT_VECTOR)) {
+            v = ValueAsObject(source)->as.vector.items[i];
+        } else {
+            v = ConsHead(ValueAsObject(source));
+            source = ConsTail(ValueAsObject(source));
+        }
+        if (!IsNumber(v)) {
+            return NULL;
+        }
+        array->as.f64Array.items[i] = NumberAsF64(v);
+    }
+    return array;
+}
+
+// -- Function calls --
+
+static VmResult ExecuteInstruction(OpCode op, Allocator* allocator);
+
+// The builtin that an op code executes, for builtins that are passed as values.
+static bool TryMapOpCodeToOperator(OpCode op, OperatorType* operator) {
+    for (OperatorType o = 0; o < OPERATOR_ENUM_COUNT; o++) {
+        if (MapOperatorToOpCode(o) == op) {
+            *operator = o;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * User defined functions are not called by the VM yet, so the functions
+ * are builtins, and maps, sets and hash tables, which are functions of
+ * their keys.
+ */
+static bool IsCallable(Value fn, size_t numArgs) {
+    if (GetValueType(fn) == VALUE_OPERATOR) {
+        OperatorType operator = ValueAsOperator(fn);
+        return MapOperatorToOpCode(operator) != OP_ENUM_COUNT && GetOperatorArity(operator) == numArgs;
+    }
+    return numArgs == 1 && (IsMapOrSetValue(fn) || IsObjectValue(fn, OBJECT_HASHTABLE));
+}
+
+static VmResult ApplyFunction(Value fn, Value* args, size_t numArgs, Value* result, Allocator* allocator) {
+    if (!IsCallable(fn, numArgs)) {
+        return CreateError("Unable to call. Expected a builtin that takes the arguments, a map, a set or a hash table.");
+    }
+
+    *result = MAKE_VALUE_NIL();
+    if (IsMapOrSetValue(fn)) {
+        HamtGet(ValueAsObject(fn), args[0], result, allocator);
+        return (VmResult) { .type = RESULT_SUCCESS };
+    } else if (IsObjectValue(fn, OBJECT_HASHTABLE)) {
+        if (IsHashTableKey(args[0])) {
+            HashTableGet(ValueAsObject(fn), args[0], result, allocator);
+        }
+        return (VmResult) { .type = RESULT_SUCCESS };
+    }
+
+    // the first argument goes on top of the stack, like in a direct call
+    for (size_t k = numArgs; k > 0; k--) {
+        PushValue(args[k - 1]);
+    }
+    VmResult call = ExecuteInstruction(MapOperatorToOpCode(ValueAsOperator(fn)), allocator);
+    if (call.type != RESULT_ERROR) {
+        *result = PopValue();
+    }
+    return call;
+}
+
+// -- Lazy sequences --
+
+typedef struct {
+    VmResult result;
+    Allocator* allocator;
+} SeqCallContext;
+
+static bool ApplySeqFunction(Value fn, Value arg, Value* result, void* ctx) {
+    SeqCallContext* call = ctx;
+    call->result = ApplyFunction(fn, &arg, 1, result, call->allocator);
+    return call->result.type != RESULT_ERROR;
+}
+
+static void OpenVmSeqCursor(SeqCursor* cursor, SeqCallContext* call, Value seq, Allocator* allocator) {
+    *call = (SeqCallContext) { .allocator = allocator };
+    OpenSeqCursor(cursor, seq, ApplySeqFunction, call, allocator);
+}
+
+// Prefers the error of a function call, which says more than that the sequence failed.
+static VmResult GetSeqError(SeqCursor* cursor, SeqCallContext* call) {
+    return call->result.type == RESULT_ERROR ? call->result : CreateError(cursor->error);
+}
+
+/*
+ * Everything that is allocated to produce and use one element of a sequence
+ * is garbage once the next element is produced, except for the value that is
+ * kept, such as the accumulator of reduce. The memory of such a step is released
+ * right away when nothing that outlives the step can point into it, so that
+ * consuming a long sequence does not grow the heap. That is when the value
+ * that is kept is not an object, the cursor does not keep an object for the
+ * next element, and no older rope was flattened during the step.
+ */
+typedef struct {
+    ArenaMark mark;
+    size_t freeListCount;
+    size_t numFlattenedRopes;
+} SeqStep;
+
+static SeqStep BeginSeqStep(Allocator* allocator) {
+    return (SeqStep) {
+        .mark = AllocatorMark(allocator),
+        .freeListCount = freeList.count,
+        .numFlattenedRopes = GetNumFlattenedRopes(),
     };
-    freeList = DA_MAKE_DEFAULT(ObjectPtr);
-    objectAllocator = allocator;
+}
 
-    int i = 0;
-    int guard = 1337;
+static void EndSeqStep(SeqStep step, SeqCursor* cursor, Value kept, Allocator* allocator) {
+    if (GetValueType(kept) == VALUE_OBJECT || SeqCursorKeepsObjects(cursor)
+            || GetNumFlattenedRopes() != step.numFlattenedRopes) {
+        return;
+    }
+    AllocatorRelease(step.mark, allocator);
+    /*
+     * The objects that the step soft deleted are either released already, or
+     * older objects that are still referenced by the sequence or the kept value.
+     */
+    freeList.count = step.freeListCount;
+}
 
-    VmResult result = {0};
+// Consumes a sequence into a list. The sequence must be finite.
+static VmResult RealizeSeqAsList(Value seq, Value* list, Allocator* allocator) {
+    ValueDa items = DA_MAKE_DEFAULT(Value);
+    SeqCallContext call;
+    SeqCursor cursor;
+    OpenVmSeqCursor(&cursor, &call, seq, allocator);
 
-    while (!IsDone() && i++ < guard) {
-        OpCode op = ConsumeByte();
+    Value element = MAKE_VALUE_NIL();
+    SeqNextResult next = SEQ_NEXT_END;
+    SeqStep step = BeginSeqStep(allocator);
+    while ((next = NextSeqValue(&cursor, &element)) == SEQ_NEXT_VALUE) {
+        EndSeqStep(step, &cursor, element, allocator);
+        DA_APPEND(&items, element);
+        step = BeginSeqStep(allocator);
+    }
+
+    VmResult result = next == SEQ_NEXT_ERROR ? GetSeqError(&cursor, &call) : (VmResult) { .type = RESULT_SUCCESS };
+    CloseSeqCursor(&cursor);
+    if (result.type != RESULT_ERROR) {
+        *list = items.count == 0 ? MAKE_VALUE_NIL() : MAKE_VALUE_OBJECT(CreateListObject(items.items, items.count, MAKE_VALUE_NIL(), allocator));
+    }
+    DA_FREE(&items);
+    return result;
+}
+
+// Consumes a sequence into a vector. The sequence must be finite.
+static VmResult RealizeSeqAsVector(Value seq, Object** vector, Allocator* allocator) {
+    *vector = CreateVectorObject(NULL, 0, allocator);
+    SeqCallContext call;
+    SeqCursor cursor;
+    OpenVmSeqCursor(&cursor, &call, seq, allocator);
 
-        switch (op) {
-            case OP_NIL:
-                PushValue(MAKE_VALUE_NIL());
+    Value element = MAKE_VALUE_NIL();
+    SeqNextResult next = SEQ_NEXT_END;
+    SeqStep step = BeginSeqStep(allocator);
+    while ((next = NextSeqValue(&cursor, &element)) == SEQ_NEXT_VALUE) {
+        if ((*vector)->as.vector.count == INT32_MAX) {
+            CloseSeqCursor(&cursor);
+            return CreateError("Unable to create a vector. The sequence is too long.");
+        }
+        // the step ends before the push, which may grow the vector
+        EndSeqStep(step, &cursor, element, allocator);
+        VectorPush(*vector, element, allocator);
+        step = BeginSeqStep(allocator);
+    }
+
+    VmResult result = next == SEQ_NEXT_ERROR ? GetSeqError(&cursor, &call) : (VmResult) { .type = RESULT_SUCCESS };
+    CloseSeqCursor(&cursor);
+    return result;
+}
+
+// Folds a sequence, list or vector one element at a time, without realizing it.
+static VmResult ReduceSeq(Value fn, Value init, Value seq, Value* acc, Allocator* allocator) {
+    SeqCallContext call;
+    SeqCursor cursor;
+    OpenVmSeqCursor(&cursor, &call, seq, allocator);
+
+    *acc = init;
+    Value args[2] = {0};
+    VmResult result = { .type = RESULT_SUCCESS };
+    SeqNextResult next = SEQ_NEXT_END;
+    SeqStep step = BeginSeqStep(allocator);
+    while ((next = NextSeqValue(&cursor, &args[1])) == SEQ_NEXT_VALUE) {
+        args[0] = *acc;
+        result = ApplyFunction(fn, args, 2, acc, allocator);
+        if (result.type == RESULT_ERROR) {
+            break;
+        }
+        EndSeqStep(step, &cursor, *acc, allocator);
+        step = BeginSeqStep(allocator);
+    }
+
+    if (next == SEQ_NEXT_ERROR) {
+        result = GetSeqError(&cursor, &call);
+    }
+    CloseSeqCursor(&cursor);
+    return result;
+}
+
+// -- Instructions --
+
+static VmResult ExecuteInstruction(OpCode op, Allocator* allocator) {
+    VmResult result = {0};
+
+    switch (op) {
+        case OP_NIL:
+            PushValue(MAKE_VALUE_NIL());
+            break;
+        case OP_TRUE:
+            PushValue(MAKE_VALUE_BOOL(true));
+            break;
+        case OP_FALSE:
+            PushValue(MAKE_VALUE_BOOL(false));
+            break;
+        case OP_F64: {
+            Byte* bytes = ConsumeBytes(8);
+            double d = ReadDoubleFromLittleEndian8(bytes);
+            PushValue(MAKE_VALUE_F64(d));
+            break;
+        }
+        case OP_I32: {
+            Byte* bytes = ConsumeBytes(4);
+            PushValue(MAKE_VALUE_I32(ReadI32FromLittleEndian4(bytes)));
+            break;
+        }
+        case OP_CONSTANT_16: {
+            uint16_t index = ReadU16FromLittleEndian2(ConsumeBytes(2));
+            if (index >= vmState.constants.count) {
+                result = CreateError("Constant index out of bounds");
                 break;
-            case OP_TRUE:
-                PushValue(MAKE_VALUE_BOOL(true));
+            }
+            PushValue(vmState.constants.items[index]);
+            break;
+        }
+        case OP_BUILTIN_FN: {
+            // the builtin is passed as the op code that executes it
+            OperatorType operator = OPERATOR_ADD;
+            if (!TryMapOpCodeToOperator(ConsumeByte(), &operator)) {
+                result = CreateError("Unexpected builtin operator");
                 break;
-            case OP_FALSE:
-                PushValue(MAKE_VALUE_BOOL(false));
+            }
+            PushValue(MAKE_VALUE_OPERATOR(operator));
+            break;
+        }
+        case OP_ADD: {
+            BINARY_OP(+, __builtin_add_overflow, F64_OP_ADD);
+            break;
+        }
+        case OP_SUBTRACT: {
+            BINARY_OP(-, __builtin_sub_overflow, F64_OP_SUBTRACT);
+            break;
+        }
+        case OP_MULTIPLY: {
+            BINARY_OP(*, __builtin_mul_overflow, F64_OP_MULTIPLY);
+            break;
+        }
+        case OP_DIVIDE: {
+            // the quotient of two integers is generally not an integer
+            Value v1 = PopValue();
+            Value v2 = PopValue();
+            Value array = MAKE_VALUE_NIL();
+            if (IsNumber(v1) && IsNumber(v2)) {
+                PushValue(MAKE_VALUE_F64(NumberAsF64(v1) / NumberAsF64(v2)));
+            } else if (TryF64ArrayArithmetic(F64_OP_DIVIDE, v1, v2, &array, allocator)) {
+                PushValue(array);
+            } else {
+                return CreateError(ARITHMETIC_ERROR_MESSAGE);
+            }
+            break;
+        }
+        case OP_NEGATE: {
+            Value v = PopValue();
+            if (GetValueType(v) == VALUE_I32 && ValueAsI32(v) != INT32_MIN) {
+                PushValue(MAKE_VALUE_I32(-ValueAsI32(v)));
+            } else if (IsNumber(v)) {
+                PushValue(MAKE_VALUE_F64(-NumberAsF64(v)));
+            } else {
+                result = CreateError("Unable to negate. Expected number value.");
+            }
+            break;
+        }
+        case OP_PRINT: {
+            Value v = PopValue();
+            PrintValue(v);
+            PushValue(MAKE_VALUE_NIL());
+            break;
+        }
+        case OP_CONCAT: {
+            Value v1 = PopValue();
+            Value v2 = PopValue();
+            if (!IsStringValue(v1) || !IsStringValue(v2)) {
+                result = CreateError("Unable to concatenate. Expected string values.");
                 break;
-            case OP_F64: {
-                Byte* bytes = ConsumeBytes(8);
-                double d = ReadDoubleFromLittleEndian8(bytes);
-                PushValue(MAKE_VALUE_F64(d));
+            }
+            Object* left = ValueAsObject(v1);
+            Object* right = ValueAsObject(v2);
+            if ((size_t)left->as.string.length + right->as.string.length > UINT32_MAX) {
+                result = CreateError("Unable to concatenate. The string is too long.");
                 break;
             }
-            case OP_BUILTIN_FN: {
-                OpCode o = ConsumeByte();
-                if (o < OPERATOR_ADD || o > OPERATOR_PRINT) {
-                    result = CreateError("Unexpected builtin operator");
-                    break;
-                }
-                PushValue(MAKE_VALUE_OPERATOR(o));
+            PushValue(MAKE_VALUE_OBJECT(CreateConcatObject(left, right, allocator)));
+            break;
+        }
+        case OP_HASHMAP:
+        case OP_HASHSET: {
+            Value list = PopValue();
+            size_t length = 0;
+            if (!TryGetProperListLength(list, &length)) {
+                result = CreateError("Unable to create a map or set. Expected a list.");
                 break;
             }
-            case OP_ADD: {
-                BINARY_OP(+);
+            ObjectType type = op == OP_HASHMAP ? OBJECT_MAP : OBJECT_SET;
+            if (type == OBJECT_MAP && length % 2 != 0) {
+                result = CreateError("Unable to create a map. Expected a list of keys and values.");
                 break;
             }
-            case OP_SUBTRACT: {
-                BINARY_OP(-);
+            PushValue(MAKE_VALUE_OBJECT(CreateHamtFromList(type, list, allocator)));
+            break;
+        }
+        case OP_ASSOC: {
+            Value map = PopValue();
+            Value key = PopValue();
+            Value value = PopValue();
+            if (!IsObjectValue(map, OBJECT_MAP)) {
+                result = CreateError("Unable to assoc. Expected a map.");
                 break;
             }
-            case OP_MULTIPLY: {
-                BINARY_OP(*);
+            PushValue(MAKE_VALUE_OBJECT(HamtAssoc(ValueAsObject(map), key, value, allocator)));
+            break;
+        }
+        case OP_CONJ: {
+            Value set = PopValue();
+            Value key = PopValue();
+            if (!IsObjectValue(set, OBJECT_SET)) {
+                result = CreateError("Unable to conj. Expected a set.");
                 break;
             }
-            case OP_DIVIDE: {
-                BINARY_OP(/);
+            PushValue(MAKE_VALUE_OBJECT(HamtAssoc(ValueAsObject(set), key, MAKE_VALUE_NIL(), allocator)));
+            break;
+        }
+        case OP_DISSOC: {
+            Value hamt = PopValue();
+            Value key = PopValue();
+            if (!IsMapOrSetValue(hamt)) {
+                result = CreateError("Unable to dissoc. Expected a map or set.");
                 break;
             }
-            case OP_NEGATE: {
-                Value v = PopValue();
-                if (v.type != VALUE_F64) {
-                    result = CreateError("Unable to negate. Expected F64 value.");
-                    break;
+            PushValue(MAKE_VALUE_OBJECT(HamtDissoc(ValueAsObject(hamt), key, allocator)));
+            break;
+        }
+        case OP_GET:
+        case OP_CONTAINS: {
+            Value collection = PopValue();
+            Value key = PopValue();
+            Value value = MAKE_VALUE_NIL();
+            bool found = false;
+            if (IsMapOrSetValue(collection)) {
+                found = HamtGet(ValueAsObject(collection), key, &value, allocator);
+            } else if (IsObjectValue(collection, OBJECT_HASHTABLE)) {
+                found = HashTableGet(ValueAsObject(collection), key, &value, allocator);
+            } else {
+                result = CreateError("Unable to look up a key. Expected a map, set or hash table.");
+                break;
+            }
+            PushValue(op == OP_GET ? value : MAKE_VALUE_BOOL(found));
+            break;
+        }
+        case OP_HASHTABLE:
+            PushValue(MAKE_VALUE_OBJECT(CreateHashTableObject(0, allocator)));
+            break;
+        case OP_PUT: {
+            Value table = PopValue();
+            Value key = PopValue();
+            Value value = PopValue();
+            if (!IsObjectValue(table, OBJECT_HASHTABLE)) {
+                result = CreateError("Unable to put. Expected a hash table.");
+                break;
+            }
+            if (!IsHashTableKey(key)) {
+                result = CreateError("Unable to put. Hash table keys are numbers, strings or symbols.");
+                break;
+            }
+            HashTablePut(ValueAsObject(table), key, value, allocator);
+            PushValue(table);
+            break;
+        }
+        case OP_REMOVE: {
+            Value table = PopValue();
+            Value key = PopValue();
+            if (!IsObjectValue(table, OBJECT_HASHTABLE)) {
+                result = CreateError("Unable to remove. Expected a hash table.");
+                break;
+            }
+            PushValue(MAKE_VALUE_BOOL(HashTableRemove(ValueAsObject(table), key, allocator)));
+            break;
+        }
+        case OP_COUNT: {
+            Value collection = PopValue();
+            if (IsMapOrSetValue(collection)) {
+                PushValue(MAKE_VALUE_I32(ValueAsObject(collection)->as.hamt.count));
+            } else if (IsObjectValue(collection, OBJECT_HASHTABLE)) {
+                PushValue(MAKE_VALUE_I32(ValueAsObject(collection)->as.hashTable.count));
+            } else if (IsObjectValue(collection, OBJECT_VECTOR)) {
+                PushValue(MAKE_VALUE_I32(ValueAsObject(collection)->as.vector.count));
+            } else if (IsObjectValue(collection, OBJECT_F64_ARRAY)) {
+                PushValue(MAKE_VALUE_I32(ValueAsObject(collection)->as.f64Array.count));
+            } else {
+                result = CreateError("Unable to count. Expected a map, set, hash table, vector or f64 array.");
+            }
+            break;
+        }
+        case OP_VECTOR: {
+            uint16_t count = ReadU16FromLittleEndian2(ConsumeBytes(2));
+            if (count > vmState.values.count) {
+                result = CreateError("Not enough values on the stack to build the vector");
+                break;
+            }
+            Value* items = &vmState.values.items[vmState.values.count - count];
+            Object* vector = CreateVectorObject(items, count, allocator);
+            for (size_t k = 0; k < count; k++) {
+                PopValue();
+            }
+            PushValue(MAKE_VALUE_OBJECT(vector));
+            break;
+        }
+        case OP_NTH: {
+            Value vector = PopValue();
+            Value index = PopValue();
+            bool isArray = IsObjectValue(vector, OBJECT_F64_ARRAY);
+            if (!(IsObjectValue(vector, OBJECT_VECTOR) || isArray) || GetValueType(index) != VALUE_I32) {
+                result = CreateError("Unable to index. Expected a vector or f64 array and an integer.");
+                break;
+            }
+            uint32_t count = isArray ? ValueAsObject(vector)->as.f64Array.count : ValueAsObject(vector)->as.vector.count;
+            int32_t i = ValueAsI32(index);
+            if (i < 0 || (uint32_t)i >= count) {
+                result = CreateError("Unable to index. The index is out of bounds.");
+                break;
+            }
+            if (isArray) {
+                PushValue(MAKE_VALUE_F64(ValueAsObject(vector)->as.f64Array.items[i]));
+            } else {
+                PushValue(ValueAsObject(vector)->as.vector.items[i]);
+            }
+            break;
+        }
+        case OP_PUSH: {
+            Value vector = PopValue();
+            Value value = PopValue();
+            if (!IsObjectValue(vector, OBJECT_VECTOR)) {
+                result = CreateError("Unable to push. Expected a vector.");
+                break;
+            }
+            if (ValueAsObject(vector)->as.vector.count == INT32_MAX) {
+                result = CreateError("Unable to push. The vector is too long.");
+                break;
+            }
+            VectorPush(ValueAsObject(vector), value, allocator);
+            PushValue(vector);
+            break;
+        }
+        case OP_SLICE: {
+            Value vector = PopValue();
+            Value start = PopValue();
+            Value end = PopValue();
+            if (!IsObjectValue(vector, OBJECT_VECTOR) || GetValueType(start) != VALUE_I32 || GetValueType(end) != VALUE_I32) {
+                result = CreateError("Unable to slice. Expected a vector, a start and an end.");
+                break;
+            }
+            int32_t from = ValueAsI32(start);
+            int32_t to = ValueAsI32(end);
+            if (from < 0 || from > to || (uint32_t)to > ValueAsObject(vector)->as.vector.count) {
+                result = CreateError("Unable to slice. The range is out of bounds.");
+                break;
+            }
+            PushValue(MAKE_VALUE_OBJECT(CreateVectorSlice(ValueAsObject(vector), from, to, allocator)));
+            break;
+        }
+        case OP_VEC: {
+            Value list = PopValue();
+            size_t length = 0;
+            if (IsObjectValue(list, OBJECT_LAZY_SEQ)) {
+                Object* vector = NULL;
+                result = RealizeSeqAsVector(list, &vector, allocator);
+                PushValue(MAKE_VALUE_OBJECT(vector));
+                break;
+            }
+            if (!TryGetProperListLength(list, &length)) {
+                result = CreateError("Unable to create a vector. Expected a list or lazy sequence.");
+                break;
+            }
+            PushValue(MAKE_VALUE_OBJECT(CreateVectorFromList(list, allocator)));
+            break;
+        }
+        case OP_TOLIST: {
+            Value vector = PopValue();
+            if (IsObjectValue(vector, OBJECT_LAZY_SEQ)) {
+                Value list = MAKE_VALUE_NIL();
+                result = RealizeSeqAsList(vector, &list, allocator);
+                PushValue(list);
+                break;
+            }
+            if (!IsObjectValue(vector, OBJECT_VECTOR)) {
+                result = CreateError("Unable to create a list. Expected a vector or lazy sequence.");
+                break;
+            }
+            PushValue(VectorToList(ValueAsObject(vector), allocator));
+            break;
+        }
+        case OP_F64ARRAY: {
+            Value source = PopValue();
+            Object* array = CreateF64ArrayFromValues(source, allocator);
+            if (array == NULL) {
+                result = CreateError("Unable to create an f64 array. Expected a list or vector of numbers.");
+                break;
+            }
+            PushValue(MAKE_VALUE_OBJECT(array));
+            break;
+        }
+        case OP_SUM: {
+            Value array = PopValue();
+            if (!IsObjectValue(array, OBJECT_F64_ARRAY)) {
+                result = CreateError("Unable to sum. Expected an f64 array.");
+                break;
+            }
+            PushValue(MAKE_VALUE_F64(F64ArraySum(ValueAsObject(array))));
+            break;
+        }
+        case OP_MIN:
+        case OP_MAX: {
+            Value array = PopValue();
+            if (!IsObjectValue(array, OBJECT_F64_ARRAY) || ValueAsObject(array)->as.f64Array.count == 0) {
+                result = CreateError("Unable to find the min or max. Expected a non-empty f64 array.");
+                break;
+            }
+            double extreme = op == OP_MIN ? F64ArrayMin(ValueAsObject(array)) : F64ArrayMax(ValueAsObject(array));
+            PushValue(MAKE_VALUE_F64(extreme));
+            break;
+        }
+        case OP_DOT: {
+            Value first = PopValue();
+            Value second = PopValue();
+            if (!IsObjectValue(first, OBJECT_F64_ARRAY) || !IsObjectValue(second, OBJECT_F64_ARRAY)
+                    || ValueAsObject(first)->as.f64Array.count != ValueAsObject(second)->as.f64Array.count) {
+                result = CreateError("Unable to compute the dot product. Expected f64 arrays of the same length.");
+                break;
+            }
+            PushValue(MAKE_VALUE_F64(F64ArrayDot(ValueAsObject(first), ValueAsObject(second))));
+            break;
+        }
+        case OP_LENGTH: {
+            Value str = PopValue();
+            if (!IsStringValue(str)) {
+                result = CreateError("Unable to get the length. Expected a string.");
+                break;
+            }
+            PushValue(MAKE_VALUE_I32(ValueAsObject(str)->as.string.length));
+            break;
+        }
+        case OP_FIND: {
+            Value str = PopValue();
+            Value needle = PopValue();
+            if (!IsStringValue(str) || !IsStringValue(needle)) {
+                result = CreateError("Unable to find. Expected a string and a substring.");
+                break;
+            }
+            String haystack = GetStringChars(ValueAsObject(str), allocator);
+            ptrdiff_t i = FindSubstring(haystack, GetStringChars(ValueAsObject(needle), allocator), 0);
+            PushValue(i < 0 ? MAKE_VALUE_NIL() : MAKE_VALUE_I32(i));
+            break;
+        }
+        case OP_OCCURRENCES: {
+            Value str = PopValue();
+            Value needle = PopValue();
+            if (!IsStringValue(str) || !IsStringValue(needle) || ValueAsObject(needle)->as.string.length == 0) {
+                result = CreateError("Unable to count occurrences. Expected a string and a non-empty substring.");
+                break;
+            }
+            String haystack = GetStringChars(ValueAsObject(str), allocator);
+            PushValue(MAKE_VALUE_I32(CountSubstring(haystack, GetStringChars(ValueAsObject(needle), allocator))));
+            break;
+        }
+        case OP_COMPARE: {
+            Value v1 = PopValue();
+            Value v2 = PopValue();
+            if (!IsStringValue(v1) || !IsStringValue(v2)) {
+                result = CreateError("Unable to compare. Expected string values.");
+                break;
+            }
+            int order = CompareStrings(GetStringChars(ValueAsObject(v1), allocator), GetStringChars(ValueAsObject(v2), allocator));
+            PushValue(MAKE_VALUE_I32((order > 0) - (order < 0)));
+            break;
+        }
+        case OP_SPLIT: {
+            Value str = PopValue();
+            Value delimiter = PopValue();
+            if (!IsStringValue(str) || !IsStringValue(delimiter) || ValueAsObject(delimiter)->as.string.length == 0) {
+                result = CreateError("Unable to split. Expected a string and a non-empty delimiter.");
+                break;
+            }
+            String chars = GetStringChars(ValueAsObject(delimiter), allocator);
+            PushValue(MAKE_VALUE_OBJECT(SplitString(ValueAsObject(str), chars, allocator)));
+            break;
+        }
+        case OP_JOIN: {
+            Value separator = PopValue();
+            Value parts = PopValue();
+            size_t count = 0;
+            if (IsObjectValue(parts, OBJECT_VECTOR)) {
+                count = ValueAsObject(parts)->as.vector.count;
+            } else if (TryGetProperListLength(parts, &count)) {
+                parts = MAKE_VALUE_OBJECT(CreateVectorFromList(parts, allocator));
+            } else {
+                result = CreateError("Unable to join. Expected a separator and a list or vector of strings.");
+                break;
+            }
+            Value* items = ValueAsObject(parts)->as.vector.items;
+
+            bool isValid = IsStringValue(separator);
+            size_t length = 0;
+            for (size_t k = 0; isValid && k < count; k++) {
+                isValid = IsStringValue(items[k]);
+                if (isValid) {
+                    length += ValueAsObject(items[k])->as.string.length;
                 }
-                PushValue(MAKE_VALUE_F64(-v.as.f64));
+            }
+            if (!isValid) {
+                result = CreateError("Unable to join. Expected a separator and a list or vector of strings.");
                 break;
             }
-            case OP_PRINT: {
-                Value v = PopValue();
-                PrintValue(v);
-                PushValue(MAKE_VALUE_NIL());
+            if (count > 1) {
+                length += (count - 1) * ValueAsObject(separator)->as.string.length;
+            }
+            if (length > UINT32_MAX) {
+                result = CreateError("Unable to join. The string is too long.");
+                break;
+            }
+            PushValue(MAKE_VALUE_OBJECT(JoinStrings(ValueAsObject(separator), items, count, allocator)));
+            break;
+        }
+        case OP_RANGE: {
+            Value start = PopValue();
+            Value end = PopValue();
+            if (GetValueType(start) != VALUE_I32 || GetValueType(end) != VALUE_I32) {
+                result = CreateError("Unable to create a range. Expected a start and an end integer.");
                 break;
             }
-            case OP_CONS_CELL: {
-                Value head = PopValue();
-                Value tail = PopValue();
-                Object* consObj = CreateConsCellObject(head, tail, allocator);
-                Value objVal = MAKE_VALUE_OBJECT(consObj);
-                PushValue(objVal);
+            PushValue(MAKE_VALUE_OBJECT(CreateRangeSeq(ValueAsI32(start), ValueAsI32(end), allocator)));
+            break;
+        }
+        case OP_ITERATE: {
+            Value fn = PopValue();
+            Value seed = PopValue();
+            if (!IsCallable(fn, 1)) {
+                result = CreateError("Unable to iterate. Expected a function of one argument.");
                 break;
             }
-            default:
-                result = CreateError("Unsupported op code.");
+            PushValue(MAKE_VALUE_OBJECT(CreateIterateSeq(fn, seed, allocator)));
+            break;
+        }
+        case OP_LINES: {
+            Value path = PopValue();
+            if (!IsStringValue(path)) {
+                result = CreateError("Unable to read lines. Expected a file path.");
                 break;
+            }
+            PushValue(MAKE_VALUE_OBJECT(CreateLinesSeq(ValueAsObject(path), allocator)));
+            break;
+        }
+        case OP_TAKE: {
+            Value count = PopValue();
+            Value source = PopValue();
+            if (GetValueType(count) != VALUE_I32 || ValueAsI32(count) < 0 || !IsSeqSource(source)) {
+                result = CreateError("Unable to take. Expected a count and a sequence, list or vector.");
+                break;
+            }
+            PushValue(MAKE_VALUE_OBJECT(CreateTakeSeq(ValueAsI32(count), source, allocator)));
+            break;
+        }
+        case OP_MAP:
+        case OP_FILTER: {
+            Value fn = PopValue();
+            Value source = PopValue();
+            if (!IsCallable(fn, 1) || !IsSeqSource(source)) {
+                result = CreateError("Unable to map or filter. Expected a function of one argument and a sequence, list or vector.");
+                break;
+            }
+            SeqKind kind = op == OP_MAP ? SEQ_MAP : SEQ_FILTER;
+            PushValue(MAKE_VALUE_OBJECT(CreateTransformSeq(kind, fn, source, allocator)));
+            break;
+        }
+        case OP_REDUCE: {
+            Value fn = PopValue();
+            Value init = PopValue();
+            Value source = PopValue();
+            if (!IsCallable(fn, 2) || !IsSeqSource(source)) {
+                result = CreateError("Unable to reduce. Expected a function of two arguments, an initial value and a sequence, list or vector.");
+                break;
+            }
+            Value acc = MAKE_VALUE_NIL();
+            result = ReduceSeq(fn, init, source, &acc, allocator);
+            PushValue(acc);
+            break;
+        }
+        case OP_CONS_CELL: {
+            Value head = PopValue();
+            Value tail = PopValue();
+            Object* consObj = CreateConsCellObject(head, tail, allocator);
+            Value objVal = MAKE_VALUE_OBJECT(consObj);
+            PushValue(objVal);
+            break;
+        }
+        case OP_LIST: {
+            uint16_t count = ReadU16FromLittleEndian2(ConsumeBytes(2));
+            if (count == 0 || count >= vmState.values.count) {
+                result = CreateError("Not enough values on the stack to build the list");
+                break;
+            }
+            // the elements are on top of the stack in order, with the tail right below them
+            Value* items = &vmState.values.items[vmState.values.count - count];
+            Object* list = CreateListObject(items, count, items[-1], allocator);
+            for (size_t k = 0; k <= count; k++) {
+                PopValue();
+            }
+            PushValue(MAKE_VALUE_OBJECT(list));
+            break;
+        }
+        default:
+            result = CreateError("Unsupported op code.");
+            break;
+    }
+
+    return result;
+}
+
+VmResult ExecuteByteCode(ByteDa byteCode, ValueDa constants, Allocator* allocator) {
+    ValueDa values = vmState.values;
+    RETAIN_DA(&values, Value);
+    // objects left over from the previous run belong to its heap
+    RETAIN_DA(&freeList, ObjectPtr);
+
+    vmState = (VmState) {
+        .programCounter = 0,
+        .byteCode = byteCode,
+        .constants = constants,
+        .values = values,
+    };
+    objectAllocator = allocator;
+
+    int i = 0;
+    int guard = 1337;
+
+    VmResult result = {0};
+
+    while (!IsDone() && i++ < guard) {
+        result = ExecuteInstruction(ConsumeByte(), allocator);
+        if (result.type == RESULT_ERROR) {
+            break;
         }
     }
 
@@ -191,6 +989,16 @@ VmResult ExecuteByteCode(ByteDa byteCode, Allocator* allocator) {
     }
 }
 
+void SetVmRetention(size_t bytes) {
+    vmRetentionBytes = bytes;
+}
+
+void FreeVm() {
+    DA_FREE(&vmState.values);
+    DA_FREE(&freeList);
+    vmState = (VmState) {0};
+}
+
 void PrintVmResult(VmResult vmResult) {
     if (vmResult.type == RESULT_ERROR) {
         VmError error = vmResult.as.error;
@@ -21,7 +21,25 @@ typedef struct {
     } as;
 } VmResult;
 
-VmResult ExecuteByteCode(ByteDa byteCode, Allocator* allocator);
+/*
+ * The allocator is the runtime heap. The constants must outlive the run,
+ * for example by being on the same heap.
+ *
+ * Every thread has one VM, which keeps its value stack between runs so that
+ * running many programs does not allocate. The values of a result are owned
+ * by the VM and are only valid until the next run on the same thread.
+ */
+VmResult ExecuteByteCode(ByteDa byteCode, ValueDa constants, Allocator* allocator);
+
+#define VM_DEFAULT_RETENTION_BYTES (64 * 1024)
+
+/*
+ * Sets how many bytes the value stack and the free list may keep
+ * between runs. Anything greater is released before the next run.
+ */
+void SetVmRetention(size_t bytes);
+// Releases the memory that the VM of this thread keeps between runs.
+void FreeVm();
 
 void PrintVmResult(VmResult vmResult);
 
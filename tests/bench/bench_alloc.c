@@ -0,0 +1,125 @@
+/*
+ * Times the allocation fast path and the code that sits on top of it.
+ * Run it with scripts/bench.sh. Each benchmark is run a few times and
+ * the best run is reported, since the slower runs are mostly noise.
+ */
+#include <stdio.h>
+#include <time.h>
+#include "da.h"
+#include "tokens.h"
+#include "parser.h"
+#include "memory.h"
+#include "values.h"
+
+#define BENCH_PAGE_SIZE 4096
+// enough pages for a batch, so that the batches measure allocation rather than page growth
+#define BENCH_NUM_PAGES 128
+#define BENCH_NUM_RUNS 3
+#define BENCH_BATCH_SIZE 10000
+#define BENCH_NUM_BATCHES 1000
+#define BENCH_ALLOC_SIZE 24
+// a block of another size on the free list, like the ones vectors and hash tables leave behind
+#define BENCH_FREED_SIZE (BENCH_PAGE_SIZE - 8)
+#define BENCH_LIST_LENGTH 10000
+#define BENCH_NUM_PARSES 200
+
+static double GetSeconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Keeps the compiler from dropping the allocations.
+static volatile uintptr_t sink = 0;
+
+static double BenchAllocatorAlloc(Allocator* allocator) {
+    double start = GetSeconds();
+    for (int batch = 0; batch < BENCH_NUM_BATCHES; batch++) {
+        AllocatorReset(allocator);
+        for (int i = 0; i < BENCH_BATCH_SIZE; i++) {
+            sink ^= (uintptr_t)AllocatorAlloc(BENCH_ALLOC_SIZE, allocator);
+        }
+    }
+    return (GetSeconds() - start) / (BENCH_NUM_BATCHES * BENCH_BATCH_SIZE);
+}
+
+static double BenchAllocatorAllocWithFreedBlock(Allocator* allocator) {
+    double start = GetSeconds();
+    for (int batch = 0; batch < BENCH_NUM_BATCHES; batch++) {
+        AllocatorReset(allocator);
+        AllocatorFreeObject(AllocatorAlloc(BENCH_FREED_SIZE, allocator), BENCH_FREED_SIZE, allocator);
+        for (int i = 0; i < BENCH_BATCH_SIZE; i++) {
+            sink ^= (uintptr_t)AllocatorAlloc(BENCH_ALLOC_SIZE, allocator);
+        }
+    }
+    return (GetSeconds() - start) / (BENCH_NUM_BATCHES * BENCH_BATCH_SIZE);
+}
+
+static double BenchCreateConsCell(Allocator* allocator) {
+    double start = GetSeconds();
+    for (int batch = 0; batch < BENCH_NUM_BATCHES; batch++) {
+        AllocatorReset(allocator);
+        Value list = MAKE_VALUE_NIL();
+        for (int i = 0; i < BENCH_BATCH_SIZE; i++) {
+            list = MAKE_VALUE_OBJECT(CreateConsCellObject(MAKE_VALUE_I32(i), list, allocator));
+        }
+        sink ^= (uintptr_t)ValueAsObject(list);
+    }
+    return (GetSeconds() - start) / (BENCH_NUM_BATCHES * BENCH_BATCH_SIZE);
+}
+
+static double BenchParseList(Allocator* allocator) {
+    // '(0 1 2 ...)
+    size_t capacity = BENCH_LIST_LENGTH * 8 + 8;
+    char* program = AllocateArray(NULL, capacity, sizeof(char));
+    size_t length = snprintf(program, capacity, "'(");
+    for (int i = 0; i < BENCH_LIST_LENGTH; i++) {
+        length += snprintf(program + length, capacity - length, "%d ", i);
+    }
+    snprintf(program + length, capacity - length, ")");
+
+    InitTokenizer(program);
+    TokenDa tokens = DA_MAKE_CAPACITY(Token, BENCH_LIST_LENGTH + 8);
+    Token token = {0};
+    do {
+        token = ConsumeToken();
+        DA_APPEND(&tokens, token);
+    } while (token.type != TOKEN_EOF && token.type != TOKEN_ERROR);
+
+    double start = GetSeconds();
+    for (int i = 0; i < BENCH_NUM_PARSES; i++) {
+        AllocatorReset(allocator);
+        ParseResult result = ParseTokens(tokens, allocator);
+        sink ^= result.type;
+    }
+    double seconds = GetSeconds() - start;
+
+    DA_FREE(&tokens);
+    FreeMemory(program);
+    return seconds / BENCH_NUM_PARSES;
+}
+
+typedef double (*BenchFunc)(Allocator* allocator);
+
+// The best time of a few runs, each with a fresh allocator.
+static double RunBench(BenchFunc bench) {
+    double best = 0;
+    for (int i = 0; i < BENCH_NUM_RUNS; i++) {
+        Allocator* allocator = CreateBumpAllocator(BENCH_PAGE_SIZE, BENCH_NUM_PAGES);
+        double seconds = bench(allocator);
+        AllocatorFree(allocator);
+        if (i == 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+    return best;
+}
+
+int main() {
+    printf("Bump allocator, %d byte pages, best of %d runs\n", BENCH_PAGE_SIZE, BENCH_NUM_RUNS);
+    printf("  AllocatorAlloc(%d)          %6.1f ns\n", BENCH_ALLOC_SIZE, RunBench(BenchAllocatorAlloc) * 1e9);
+    printf("  ... after freeing %d bytes%6.1f ns\n", BENCH_FREED_SIZE, RunBench(BenchAllocatorAllocWithFreedBlock) * 1e9);
+    printf("  CreateConsCellObject        %6.1f ns\n", RunBench(BenchCreateConsCell) * 1e9);
+    printf("  parse a %dk-element list    %6.2f ms\n", BENCH_LIST_LENGTH / 1000, RunBench(BenchParseList) * 1e3);
+    return 0;
+}
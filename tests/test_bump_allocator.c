@@ -82,12 +82,47 @@ static void TestAllocateNewPageStruct(Allocator* allocator) {
     ASSERT_BUMP_STRUCT_EQUALS(expected, actual, "Expected initial data to not be modified after second allocation");
 }
 
-static void TestShouldNotExceedPageSize(Allocator* allocator) {
+static void TestAllocateLargeObject(Allocator* allocator) {
+    // page size 2
+    char* b1 = AllocatorAlloc(1, allocator);
+    *b1 = 'a';
+
+    BumpMixedTestData* large = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    Assert(large != NULL, "Expected objects greater than the page size to be allocated.");
+    *large = (BumpMixedTestData){ .i = 1, .c = 'a', .f = 1.2, .d = 3.4 };
+
+    // the large object should not take up room in the current page
+    char* b2 = AllocatorAlloc(1, allocator);
+    *b2 = 'b';
+
+    size_t diff = (b2 - b1) * sizeof(char);
+    Assertf(diff == sizeof(char), "Expected small bytes to be sequential, but the diff was %ld bytes.", diff);
+    Assert(*b1 == 'a' && large->i == 1 && large->d == 3.4,
+           "Expected initial data to not be modified after further allocations.");
+}
+
+static void TestFreeLargeObject(Allocator* allocator) {
     // page size 1
-    SetAssertEnabledFromTest(false);
-    void* result = AllocatorAlloc(2, allocator);
-    SetAssertEnabledFromTest(true);
-    Assert(result == NULL, "Cannot allocate more than a page in a single call.");
+    BumpMixedTestData* s1 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    BumpMixedTestData* s2 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    *s2 = (BumpMixedTestData){ .i = 2, .c = 'b', .f = 4.5, .d = 6.7 };
+
+    AllocatorFreeObject(s1, sizeof(BumpMixedTestData), allocator);
+
+    Assert(s2->i == 2 && s2->d == 6.7, "Expected remaining large object to not be modified.");
+    AllocatorFreeObject(s2, sizeof(BumpMixedTestData), allocator);
+}
+
+static void TestResetReleasesLargeObjects(Allocator* allocator) {
+    // page size 1
+    AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+
+    AllocatorReset(allocator);
+
+    BumpMixedTestData* s = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    *s = (BumpMixedTestData){ .i = 1, .c = 'a', .f = 1.2, .d = 3.4 };
+    Assert(s->i == 1, "Expected large object allocation to work after reset.");
 }
 
 static void TestResetAndReuse(Allocator* allocator) {
@@ -120,6 +155,291 @@ static void TestResetAndReuseMultiPage(Allocator* allocator) {
     // second byte is in a brand new page
 }
 
+static void TestFreedObjectIsReused(Allocator* allocator) {
+    BumpMixedTestData* s1 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    AllocatorFreeObject(s1, sizeof(BumpMixedTestData), allocator);
+    BumpMixedTestData* s2 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+
+    Assert(s1 == s2, "Expected freed struct address to be re-used");
+}
+
+static void TestFreedObjectIsReusedOnlyForSameSize(Allocator* allocator) {
+    BumpMixedTestData* s1 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    AllocatorFreeObject(s1, sizeof(BumpMixedTestData), allocator);
+
+    void* p = AllocatorAlloc(sizeof(BumpMixedTestData) + 1, allocator);
+    Assert((void*)s1 != p, "Expected freed struct address to NOT be re-used for a different size");
+
+    BumpMixedTestData* s2 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    Assert(s1 == s2, "Expected freed struct address to be re-used");
+}
+
+static void TestFreedObjectsAreReusedLastInFirstOut(Allocator* allocator) {
+    BumpMixedTestData* s1 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    BumpMixedTestData* s2 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    AllocatorFreeObject(s1, sizeof(BumpMixedTestData), allocator);
+    AllocatorFreeObject(s2, sizeof(BumpMixedTestData), allocator);
+
+    BumpMixedTestData* s3 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    BumpMixedTestData* s4 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+
+    Assert(s3 == s2, "Expected last freed struct address to be re-used first");
+    Assert(s4 == s1, "Expected first freed struct address to be re-used last");
+}
+
+/*
+ * Simulates a steady state workload that keeps allocating and dropping
+ * objects. The page fits exactly two structs, so without recycling
+ * the allocations would spill over to new pages.
+ */
+static void TestSteadyStateDoesNotGrow(Allocator* allocator) {
+    BumpMixedTestData* first = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    for (int i = 0; i < 1000; i++) {
+        BumpMixedTestData* s = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+        Assertf(s == first + 1, "Expected iteration %d to re-use the freed struct", i);
+        AllocatorFreeObject(s, sizeof(BumpMixedTestData), allocator);
+    }
+}
+
+static void TestFreedObjectOfOtherSizeKeepsFastPath(Allocator* allocator) {
+    void* big = AllocatorAlloc(64, allocator);
+    AllocatorFreeObject(big, 64, allocator);
+
+    AllocatorFastPath* fastPath = (AllocatorFastPath*)allocator;
+    char* b1 = AllocatorAlloc(24, allocator);
+    char* b2 = AllocatorAlloc(24, allocator);
+
+    Assertf(fastPath->numAllocs == 2, "Expected both allocations on the fast path, but there were %ld.", fastPath->numAllocs);
+    Assertf(b2 - b1 == 24, "Expected the allocations to be sequential, but the diff was %ld bytes.", b2 - b1);
+    Assert(AllocatorAlloc(64, allocator) == big, "Expected the freed object to be re-used");
+}
+
+static void TestResetClearsFreedObjects(Allocator* allocator) {
+    BumpMixedTestData* s1 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    BumpMixedTestData* s2 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    AllocatorFreeObject(s2, sizeof(BumpMixedTestData), allocator);
+
+    AllocatorReset(allocator);
+
+    BumpMixedTestData* s3 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+    BumpMixedTestData* s4 = AllocatorAlloc(sizeof(BumpMixedTestData), allocator);
+
+    Assert(s1 == s3, "Expected first struct address to be re-used by bumping");
+    Assert(s2 == s4, "Expected second struct address to be re-used by bumping");
+}
+
+static void TestDefaultAlignment(Allocator* allocator) {
+    char* b = AllocatorAlloc(1, allocator);
+    *b = 'a';
+    double* d = AllocatorAlloc(sizeof(double), allocator);
+    *d = 1.2;
+
+    size_t diff = (char*)d - b;
+    Assertf((size_t)d % sizeof(double) == 0, "Expected double to be aligned, but the address was %ld.", (size_t)d);
+    Assertf(diff == sizeof(double), "Expected padding up to the double alignment, but the diff was %ld bytes.", diff);
+}
+
+static void TestAllocateAligned(Allocator* allocator) {
+    char* b = AllocatorAlloc(1, allocator);
+    *b = 'a';
+    double* d32 = AllocatorAllocAligned(sizeof(double) * 4, 32, allocator);
+    double* d64 = AllocatorAllocAligned(sizeof(double) * 8, 64, allocator);
+
+    Assertf((size_t)d32 % 32 == 0, "Expected 32 byte alignment, but the address was %ld.", (size_t)d32);
+    Assertf((size_t)d64 % 64 == 0, "Expected 64 byte alignment, but the address was %ld.", (size_t)d64);
+
+    for (int i = 0; i < 8; i++) {
+        d64[i] = i;
+    }
+    for (int i = 0; i < 4; i++) {
+        d32[i] = i;
+    }
+    Assert(*b == 'a' && d64[7] == 7, "Expected data to not be modified by aligned allocations.");
+}
+
+static void TestAllocateAlignedInNewPage(Allocator* allocator) {
+    // page size 64
+    char* b = AllocatorAlloc(1, allocator);
+    *b = 'a';
+    double* d = AllocatorAllocAligned(sizeof(double) * 8, 64, allocator);
+
+    Assertf((size_t)d % 64 == 0, "Expected 64 byte alignment, but the address was %ld.", (size_t)d);
+    Assert(d != (double*)(b + 64), "Expected aligned data to be on a new page.");
+}
+
+static void TestFreedObjectIsNotReusedForStricterAlignment(Allocator* allocator) {
+    AllocatorAlloc(8, allocator);
+    double* d1 = AllocatorAlloc(sizeof(double) * 4, allocator);
+    AllocatorFreeObject(d1, sizeof(double) * 4, allocator);
+    double* d2 = AllocatorAllocAligned(sizeof(double) * 4, 64, allocator);
+
+    Assertf((size_t)d2 % 64 == 0, "Expected 64 byte alignment, but the address was %ld.", (size_t)d2);
+}
+
+#define ASSERT_STATS_EQUALS(field, expected, stats) \
+    Assertf(stats.field == expected, "Expected %s to be %ld, but received %ld", #field, (size_t)expected, stats.field)
+
+static void TestStatsCountAllocations(Allocator* allocator) {
+    // page size 10
+    int* i1 = AllocatorAlloc(sizeof(int), allocator);
+    AllocatorAlloc(sizeof(int), allocator);
+    AllocatorFreeObject(i1, sizeof(int), allocator);
+
+    AllocatorStats stats = AllocatorGetStats(allocator);
+    ASSERT_STATS_EQUALS(numAllocs, 2, stats);
+    ASSERT_STATS_EQUALS(numFrees, 1, stats);
+    ASSERT_STATS_EQUALS(bytesRequested, 2 * sizeof(int), stats);
+    ASSERT_STATS_EQUALS(bytesInUse, sizeof(int), stats);
+    ASSERT_STATS_EQUALS(numPages, 1, stats);
+    ASSERT_STATS_EQUALS(bytesReserved, 10, stats);
+    ASSERT_STATS_EQUALS(wastedBytes, 0, stats);
+}
+
+static void TestStatsWastedPageTail(Allocator* allocator) {
+    // page size 10
+    AllocatorAlloc(6, allocator);
+    AllocatorAlloc(6, allocator);
+
+    AllocatorStats stats = AllocatorGetStats(allocator);
+    ASSERT_STATS_EQUALS(numPages, 2, stats);
+    ASSERT_STATS_EQUALS(bytesReserved, 20, stats);
+    ASSERT_STATS_EQUALS(wastedBytes, 4, stats);
+}
+
+static void TestStatsLargeObjects(Allocator* allocator) {
+    // page size 10
+    void* large = AllocatorAlloc(100, allocator);
+
+    AllocatorStats stats = AllocatorGetStats(allocator);
+    ASSERT_STATS_EQUALS(numPages, 1, stats);
+    ASSERT_STATS_EQUALS(bytesReserved, 110, stats);
+
+    AllocatorFreeObject(large, 100, allocator);
+
+    stats = AllocatorGetStats(allocator);
+    ASSERT_STATS_EQUALS(bytesReserved, 10, stats);
+    ASSERT_STATS_EQUALS(highWaterMark, 110, stats);
+}
+
+static void TestFreeOverAlignedObject(Allocator* allocator) {
+    // page size 256
+    void* aligned = AllocatorAllocAligned(64, 128, allocator);
+    AllocatorFreeObject(aligned, 64, allocator);
+
+    AllocatorStats stats = AllocatorGetStats(allocator);
+    ASSERT_STATS_EQUALS(bytesReserved, 256, stats);
+
+    void* p = AllocatorAlloc(64, allocator);
+    Assert(p != aligned, "Expected the dedicated block to NOT be re-used as an ordinary object");
+}
+
+static void TestStatsHighWaterMarkAfterReset(Allocator* allocator) {
+    // page size 10
+    AllocatorAlloc(10, allocator);
+    AllocatorAlloc(10, allocator);
+    AllocatorAlloc(6, allocator);
+    AllocatorAlloc(6, allocator);
+
+    AllocatorStats stats = AllocatorGetStats(allocator);
+    ASSERT_STATS_EQUALS(numPages, 4, stats);
+    ASSERT_STATS_EQUALS(highWaterMark, 40, stats);
+
+    AllocatorReset(allocator);
+
+    stats = AllocatorGetStats(allocator);
+    ASSERT_STATS_EQUALS(numPages, 1, stats);
+    ASSERT_STATS_EQUALS(bytesReserved, 10, stats);
+    ASSERT_STATS_EQUALS(bytesInUse, 0, stats);
+    ASSERT_STATS_EQUALS(wastedBytes, 0, stats);
+    ASSERT_STATS_EQUALS(highWaterMark, 40, stats);
+    ASSERT_STATS_EQUALS(numAllocs, 4, stats);
+}
+
+static void TestReleaseMarkWithinPage(Allocator* allocator) {
+    // page size 256
+    int* i1 = AllocatorAlloc(sizeof(int), allocator);
+    *i1 = 123;
+
+    ArenaMark mark = AllocatorMark(allocator);
+    int* i2 = AllocatorAlloc(sizeof(int), allocator);
+    AllocatorAlloc(sizeof(int), allocator);
+    AllocatorRelease(mark, allocator);
+
+    int* i3 = AllocatorAlloc(sizeof(int), allocator);
+    Assert(i2 == i3, "Expected the memory after the mark to be re-used");
+    Assert(*i1 == 123, "Expected the data before the mark to not be modified");
+}
+
+static void TestReleaseMarkAcrossPages(Allocator* allocator) {
+    // page size 10
+    AllocatorAlloc(6, allocator);
+    ArenaMark mark = AllocatorMark(allocator);
+    char* b2 = AllocatorAlloc(2, allocator);
+    AllocatorAlloc(6, allocator);
+    AllocatorAlloc(6, allocator);
+
+    AllocatorStats before = AllocatorGetStats(allocator);
+    AllocatorRelease(mark, allocator);
+
+    char* b3 = AllocatorAlloc(2, allocator);
+    Assert(b2 == b3, "Expected the allocation to continue from the mark");
+
+    // the released pages are kept and re-used
+    AllocatorAlloc(6, allocator);
+    AllocatorAlloc(6, allocator);
+    AllocatorStats after = AllocatorGetStats(allocator);
+    ASSERT_STATS_EQUALS(numPages, before.numPages, after);
+}
+
+static void TestReleaseMarkFreesLargeObjects(Allocator* allocator) {
+    // page size 10
+    AllocatorAlloc(100, allocator);
+    ArenaMark mark = AllocatorMark(allocator);
+    void* large = AllocatorAlloc(200, allocator);
+    AllocatorAlloc(300, allocator);
+    AllocatorFreeObject(large, 200, allocator);
+    AllocatorRelease(mark, allocator);
+
+    AllocatorStats stats = AllocatorGetStats(allocator);
+    ASSERT_STATS_EQUALS(bytesReserved, 110, stats);
+    ASSERT_STATS_EQUALS(bytesInUse, 100, stats);
+}
+
+static void TestReleaseNestedMarks(Allocator* allocator) {
+    // page size 256
+    ArenaMark outer = AllocatorMark(allocator);
+    int* i1 = AllocatorAlloc(sizeof(int), allocator);
+    ArenaMark inner = AllocatorMark(allocator);
+    int* i2 = AllocatorAlloc(sizeof(int), allocator);
+
+    AllocatorRelease(inner, allocator);
+    int* i3 = AllocatorAlloc(sizeof(int), allocator);
+    Assert(i2 == i3, "Expected the inner mark to be released");
+
+    AllocatorRelease(outer, allocator);
+    int* i4 = AllocatorAlloc(sizeof(int), allocator);
+    Assert(i1 == i4, "Expected the outer mark to be released");
+}
+
+static void TestResetKeepsRetainedPages(Allocator* allocator) {
+    // page size 10
+    AllocatorSetRetention(20, allocator);
+    for (int i = 0; i < 4; i++) {
+        AllocatorAlloc(10, allocator);
+    }
+
+    AllocatorReset(allocator);
+    AllocatorStats stats = AllocatorGetStats(allocator);
+    ASSERT_STATS_EQUALS(numPages, 2, stats);
+
+    // the retained pages are re-used before growing
+    AllocatorAlloc(10, allocator);
+    AllocatorAlloc(10, allocator);
+    stats = AllocatorGetStats(allocator);
+    ASSERT_STATS_EQUALS(numPages, 2, stats);
+    ASSERT_STATS_EQUALS(highWaterMark, 40, stats);
+}
+
 static void RunTestCase(BumpTestCase testCase) {
     printf("%s\n", testCase.desc);
     Allocator* allocator = CreateBumpAllocator(testCase.pageSize, testCase.initialNumPages);
@@ -161,8 +481,20 @@ void BumpAllocatorTests() {
         .pageSize = sizeof(BumpMixedTestData) * 2 - 1,
     });
     RunTestCase((BumpTestCase) {
-        .desc = "Fail to allocate more than page size",
-        .testFn = &TestShouldNotExceedPageSize,
+        .desc = "Allocate more than page size",
+        .testFn = &TestAllocateLargeObject,
+        .initialNumPages = 1,
+        .pageSize = 2
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Free objects greater than page size",
+        .testFn = &TestFreeLargeObject,
+        .initialNumPages = 1,
+        .pageSize = 1
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Reset releases objects greater than page size",
+        .testFn = &TestResetReleasesLargeObjects,
         .initialNumPages = 1,
         .pageSize = 1
     });
@@ -178,4 +510,124 @@ void BumpAllocatorTests() {
         .initialNumPages = 1,
         .pageSize = 1
     });
+    RunTestCase((BumpTestCase) {
+        .desc = "Re-use freed object",
+        .testFn = &TestFreedObjectIsReused,
+        .initialNumPages = 1,
+        .pageSize = 100
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Re-use freed object only for the same size",
+        .testFn = &TestFreedObjectIsReusedOnlyForSameSize,
+        .initialNumPages = 1,
+        .pageSize = 100
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Re-use freed objects in LIFO order",
+        .testFn = &TestFreedObjectsAreReusedLastInFirstOut,
+        .initialNumPages = 1,
+        .pageSize = 100
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Steady state allocations do not grow the arena",
+        .testFn = &TestSteadyStateDoesNotGrow,
+        .initialNumPages = 1,
+        .pageSize = sizeof(BumpMixedTestData) * 2
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Freed object of another size keeps the fast path",
+        .testFn = &TestFreedObjectOfOtherSizeKeepsFastPath,
+        .initialNumPages = 1,
+        .pageSize = 256
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Reset forgets freed objects",
+        .testFn = &TestResetClearsFreedObjects,
+        .initialNumPages = 1,
+        .pageSize = 100
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Default alignment",
+        .testFn = &TestDefaultAlignment,
+        .initialNumPages = 1,
+        .pageSize = 100
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Explicit alignment",
+        .testFn = &TestAllocateAligned,
+        .initialNumPages = 1,
+        .pageSize = 256
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Explicit alignment in new page",
+        .testFn = &TestAllocateAlignedInNewPage,
+        .initialNumPages = 1,
+        .pageSize = 64
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Do not re-use freed object for stricter alignment",
+        .testFn = &TestFreedObjectIsNotReusedForStricterAlignment,
+        .initialNumPages = 1,
+        .pageSize = 256
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Stats - count allocations",
+        .testFn = &TestStatsCountAllocations,
+        .initialNumPages = 1,
+        .pageSize = 10
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Stats - wasted page tail",
+        .testFn = &TestStatsWastedPageTail,
+        .initialNumPages = 1,
+        .pageSize = 10
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Stats - objects greater than page size",
+        .testFn = &TestStatsLargeObjects,
+        .initialNumPages = 1,
+        .pageSize = 10
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Free an over-aligned object",
+        .testFn = &TestFreeOverAlignedObject,
+        .initialNumPages = 1,
+        .pageSize = 256
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Stats - high-water mark after reset",
+        .testFn = &TestStatsHighWaterMarkAfterReset,
+        .initialNumPages = 1,
+        .pageSize = 10
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Reset keeps retained pages",
+        .testFn = &TestResetKeepsRetainedPages,
+        .initialNumPages = 1,
+        .pageSize = 10
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Release mark within a page",
+        .testFn = &TestReleaseMarkWithinPage,
+        .initialNumPages = 1,
+        .pageSize = 256
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Release mark across pages",
+        .testFn = &TestReleaseMarkAcrossPages,
+        .initialNumPages = 1,
+        .pageSize = 10
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Release mark frees large objects",
+        .testFn = &TestReleaseMarkFreesLargeObjects,
+        .initialNumPages = 1,
+        .pageSize = 10
+    });
+    RunTestCase((BumpTestCase) {
+        .desc = "Release nested marks",
+        .testFn = &TestReleaseNestedMarks,
+        .initialNumPages = 1,
+        .pageSize = 256
+    });
 }
@@ -7,6 +7,7 @@ typedef struct {
     char* desc;
     char* input;
     ByteCodeResult expected;
+    size_t numConstants;
 } BytecodeGeneratorTestCase;
 
 #define BYTECODE_GENERATOR_TEST_PAGE_SIZE 100
@@ -52,12 +53,13 @@ static void RunTestCase(BytecodeGeneratorTestCase testCase) {
 
     Assert(token.type != TOKEN_ERROR, "Failed to tokenize");
 
-    Allocator* allocator = CreateBumpAllocator(BYTECODE_GENERATOR_TEST_PAGE_SIZE, 1);
-    ParseResult parseResult = ParseTokens(tokens, allocator);
+    Allocator* compileAllocator = CreateBumpAllocator(BYTECODE_GENERATOR_TEST_PAGE_SIZE, 1);
+    Allocator* runtimeAllocator = CreateBumpAllocator(BYTECODE_GENERATOR_TEST_PAGE_SIZE, 1);
+    ParseResult parseResult = ParseTokens(tokens, compileAllocator);
 
     Assert(parseResult.type == RESULT_SUCCESS, "Failed to parse");
 
-    ByteCodeResult result = GenerateByteCode(parseResult.as.success.ast, allocator);
+    ByteCodeResult result = GenerateByteCode(parseResult.as.success.ast, runtimeAllocator);
 
     if (!BytecodeResultEquals(testCase.expected, result)) {
         PRINT_TEST_FAILURE();
@@ -69,7 +71,15 @@ static void RunTestCase(BytecodeGeneratorTestCase testCase) {
         AssertFail("Unexpected bytecode result.");
     }
 
-    AllocatorFree(allocator);
+    if (result.type == RESULT_SUCCESS) {
+        ValueDa constants = result.as.success.constants;
+        Assertf(constants.count == testCase.numConstants,
+                "Expected %ld constants, but received %ld", testCase.numConstants, constants.count);
+        DA_FREE(&constants);
+    }
+
+    AllocatorFree(compileAllocator);
+    AllocatorFree(runtimeAllocator);
     DA_FREE(&tokens);
 }
 
@@ -88,7 +98,10 @@ static ByteCodeResult MakeSuccess(Byte* bytes, size_t count) {
 }
 
 #define F64_LITTLE_ENDIAN_1 0, 0, 0, 0, 0, 0, 240, 63
-#define F64_LITTLE_ENDIAN_2 0, 0, 0, 0, 0, 0, 0, 64
+#define F64_LITTLE_ENDIAN_2_POW_32 0, 0, 0, 0, 0, 0, 240, 65
+#define I32_LITTLE_ENDIAN_1 1, 0, 0, 0
+#define I32_LITTLE_ENDIAN_2 2, 0, 0, 0
+#define I32_LITTLE_ENDIAN_3 3, 0, 0, 0
 #define ZERO_32 0, 0, 0, 0
 #define ZERO_16 0, 0
 
@@ -104,19 +117,32 @@ void BytecodeGeneratorTests() {
     RunTestCase((BytecodeGeneratorTestCase) {
         .desc = "Only number",
         .input = "1",
+        .expected = MakeSuccess((Byte[]){ OP_I32, I32_LITTLE_ENDIAN_1 }, 5),
+    });
+
+    RunTestCase((BytecodeGeneratorTestCase) {
+        .desc = "Only decimal number",
+        .input = "1.0",
         .expected = MakeSuccess((Byte[]){ OP_F64, F64_LITTLE_ENDIAN_1 }, 9),
     });
 
+    RunTestCase((BytecodeGeneratorTestCase) {
+        .desc = "Integer literal out of range",
+        .input = "4294967296",
+        .expected = MakeSuccess((Byte[]){ OP_F64, F64_LITTLE_ENDIAN_2_POW_32 }, 9),
+    });
+
     RunTestCase((BytecodeGeneratorTestCase) {
         .desc = "Simple cons",
         .input = "'(1 . 2)",
         .expected = MakeSuccess((Byte[]){
-                OP_F64,
-                F64_LITTLE_ENDIAN_2,
-                OP_F64,
-                F64_LITTLE_ENDIAN_1,
-                OP_CONS_CELL
-        }, 19),
+                OP_I32,
+                I32_LITTLE_ENDIAN_2,
+                OP_I32,
+                I32_LITTLE_ENDIAN_1,
+                OP_LIST,
+                1, 0,
+        }, 13),
     });
 
     RunTestCase((BytecodeGeneratorTestCase) {
@@ -124,25 +150,40 @@ void BytecodeGeneratorTests() {
         .input = "'(1 2)",
         .expected = MakeSuccess((Byte[]){
                 OP_NIL,
-                OP_F64,
-                F64_LITTLE_ENDIAN_2,
-                OP_CONS_CELL,
-                OP_F64,
-                F64_LITTLE_ENDIAN_1,
-                OP_CONS_CELL
-        }, 21),
+                OP_I32,
+                I32_LITTLE_ENDIAN_1,
+                OP_I32,
+                I32_LITTLE_ENDIAN_2,
+                OP_LIST,
+                2, 0,
+        }, 14),
+    });
+
+    RunTestCase((BytecodeGeneratorTestCase) {
+        .desc = "Dotted list",
+        .input = "'(1 . (2 . 3))",
+        .expected = MakeSuccess((Byte[]){
+                OP_I32,
+                I32_LITTLE_ENDIAN_3,
+                OP_I32,
+                I32_LITTLE_ENDIAN_1,
+                OP_I32,
+                I32_LITTLE_ENDIAN_2,
+                OP_LIST,
+                2, 0,
+        }, 18),
     });
 
     RunTestCase((BytecodeGeneratorTestCase) {
         .desc = "Simple add",
         .input = "(+ 1 2)",
         .expected = MakeSuccess((Byte[]){
-                OP_F64,
-                F64_LITTLE_ENDIAN_2,
-                OP_F64,
-                F64_LITTLE_ENDIAN_1,
+                OP_I32,
+                I32_LITTLE_ENDIAN_2,
+                OP_I32,
+                I32_LITTLE_ENDIAN_1,
                 OP_ADD,
-        }, 19),
+        }, 11),
     });
 
     RunTestCase((BytecodeGeneratorTestCase) {
@@ -150,27 +191,81 @@ void BytecodeGeneratorTests() {
         .input = "'(+ 1 2)",
         .expected = MakeSuccess((Byte[]){
                 OP_NIL,
-                OP_F64,
-                F64_LITTLE_ENDIAN_2,
-                OP_CONS_CELL,
-                OP_F64,
-                F64_LITTLE_ENDIAN_1,
-                OP_CONS_CELL,
                 OP_BUILTIN_FN,
                 OP_ADD,
-                OP_CONS_CELL,
-        }, 24),
+                OP_I32,
+                I32_LITTLE_ENDIAN_1,
+                OP_I32,
+                I32_LITTLE_ENDIAN_2,
+                OP_LIST,
+                3, 0,
+        }, 16),
+    });
+
+    RunTestCase((BytecodeGeneratorTestCase) {
+        .desc = "Builtin with too few arguments",
+        .input = "(sum)",
+        .expected = { .type = RESULT_ERROR },
+    });
+
+    RunTestCase((BytecodeGeneratorTestCase) {
+        .desc = "Builtin with too few arguments, one given",
+        .input = "(dot '(1 2))",
+        .expected = { .type = RESULT_ERROR },
+    });
+
+    RunTestCase((BytecodeGeneratorTestCase) {
+        .desc = "Builtin with too many arguments",
+        .input = "(hashtable 1)",
+        .expected = { .type = RESULT_ERROR },
+    });
+
+    RunTestCase((BytecodeGeneratorTestCase) {
+        .desc = "Hash table put with too few arguments",
+        .input = "(put (hashtable) 1)",
+        .expected = { .type = RESULT_ERROR },
+    });
+
+    RunTestCase((BytecodeGeneratorTestCase) {
+        .desc = "Hash table get with too many arguments",
+        .input = "(get (hashtable) 1 2)",
+        .expected = { .type = RESULT_ERROR },
+    });
+
+    RunTestCase((BytecodeGeneratorTestCase) {
+        .desc = "Quoted symbol constant",
+        .input = "'a",
+        .expected = MakeSuccess((Byte[]){
+                OP_CONSTANT_16,
+                ZERO_16
+        }, 3),
+        .numConstants = 1,
+    });
+
+    RunTestCase((BytecodeGeneratorTestCase) {
+        .desc = "List with constants",
+        .input = "'(a \"b\")",
+        .expected = MakeSuccess((Byte[]){
+                OP_NIL,
+                OP_CONSTANT_16,
+                ZERO_16,
+                OP_CONSTANT_16,
+                1, 0,
+                OP_LIST,
+                2, 0,
+        }, 10),
+        .numConstants = 2,
     });
 
     RunTestCase((BytecodeGeneratorTestCase) {
         .desc = "Simple anonymous function",
         .input = "(fun () 1)",
         .expected = MakeSuccess((Byte[]){
-                OP_F64,
-                F64_LITTLE_ENDIAN_1,
+                OP_I32,
+                I32_LITTLE_ENDIAN_1,
                 OP_FUN,
                 ZERO_32
-        }, 14),
+        }, 10),
     });
 
 
@@ -178,11 +273,11 @@ void BytecodeGeneratorTests() {
         .desc = "Set global",
         .input = "(set x 1)",
         .expected = MakeSuccess((Byte[]){
-                OP_F64,
-                F64_LITTLE_ENDIAN_1,
+                OP_I32,
+                I32_LITTLE_ENDIAN_1,
                 OP_SET_GLOBAL,
                 ZERO_16
-        }, 12),
+        }, 8),
     });
 
     RunTestCase((BytecodeGeneratorTestCase) {
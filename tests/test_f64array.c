@@ -0,0 +1,141 @@
+#include <stdint.h>
+#include "tests.h"
+#include "memory.h"
+#include "f64array.h"
+
+typedef void (*F64ArrayTestCaseFunc)(Allocator* allocator);
+
+typedef struct {
+    char* desc;
+    F64ArrayTestCaseFunc testFn;
+} F64ArrayTestCase;
+
+#define F64ARRAY_TEST_PAGE_SIZE 4096
+// not a multiple of any vector width, so that the remainder loops run too
+#define F64ARRAY_TEST_COUNT 37
+
+// Small integers and halves are exact, so every kernel level gets the same results.
+static Object* CreateTestArray(int seed, Allocator* allocator) {
+    Object* array = CreateF64ArrayObject(F64ARRAY_TEST_COUNT, allocator);
+    for (int i = 0; i < F64ARRAY_TEST_COUNT; i++) {
+        array->as.f64Array.items[i] = ((i * seed) % 17 - 8) * 0.5;
+    }
+    return array;
+}
+
+static void AssertArraysEqual(Object* expected, Object* actual, F64KernelLevel level) {
+    Assertf(expected->as.f64Array.count == actual->as.f64Array.count, "Unexpected count at kernel level %d", level);
+    for (uint32_t i = 0; i < expected->as.f64Array.count; i++) {
+        Assertf(expected->as.f64Array.items[i] == actual->as.f64Array.items[i],
+                "Unexpected item %d at kernel level %d", i, level);
+    }
+}
+
+static void TestKernelsMatchScalar(Allocator* allocator) {
+    Object* first = CreateTestArray(3, allocator);
+    Object* second = CreateTestArray(5, allocator);
+    // no zeros in the divisor
+    for (int i = 0; i < F64ARRAY_TEST_COUNT; i++) {
+        second->as.f64Array.items[i] += second->as.f64Array.items[i] >= 0 ? 0.25 : -0.25;
+    }
+
+    SetF64KernelLevel(F64_KERNELS_SCALAR);
+    Object* expected[F64_OP_ENUM_COUNT][3];
+    for (F64Op op = 0; op < F64_OP_ENUM_COUNT; op++) {
+        expected[op][0] = F64ArrayArithmetic(op, first, second, allocator);
+        expected[op][1] = F64ArrayScalarArithmetic(op, first, 4, allocator);
+        expected[op][2] = F64ScalarArrayArithmetic(op, 4, second, allocator);
+    }
+    double sum = F64ArraySum(first);
+    double min = F64ArrayMin(first);
+    double max = F64ArrayMax(first);
+    double dot = F64ArrayDot(first, second);
+
+    for (F64KernelLevel level = F64_KERNELS_SSE2; level <= GetSupportedF64KernelLevel(); level++) {
+        SetF64KernelLevel(level);
+        for (F64Op op = 0; op < F64_OP_ENUM_COUNT; op++) {
+            AssertArraysEqual(expected[op][0], F64ArrayArithmetic(op, first, second, allocator), level);
+            AssertArraysEqual(expected[op][1], F64ArrayScalarArithmetic(op, first, 4, allocator), level);
+            AssertArraysEqual(expected[op][2], F64ScalarArrayArithmetic(op, 4, second, allocator), level);
+        }
+        Assertf(F64ArraySum(first) == sum, "Unexpected sum at kernel level %d", level);
+        Assertf(F64ArrayMin(first) == min, "Unexpected min at kernel level %d", level);
+        Assertf(F64ArrayMax(first) == max, "Unexpected max at kernel level %d", level);
+        Assertf(F64ArrayDot(first, second) == dot, "Unexpected dot product at kernel level %d", level);
+    }
+
+    SetF64KernelLevel(GetSupportedF64KernelLevel());
+}
+
+static void TestScalarResults(Allocator* allocator) {
+    SetF64KernelLevel(F64_KERNELS_SCALAR);
+    Object* array = CreateF64ArrayObject(3, allocator);
+    array->as.f64Array.items[0] = 1;
+    array->as.f64Array.items[1] = -2;
+    array->as.f64Array.items[2] = 3;
+
+    Object* result = F64ScalarArrayArithmetic(F64_OP_SUBTRACT, 1, array, allocator);
+    Assert(result->as.f64Array.items[0] == 0 && result->as.f64Array.items[1] == 3 && result->as.f64Array.items[2] == -2,
+           "Expected the scalar to be the first operand");
+    Assert(F64ArraySum(array) == 2, "Unexpected sum");
+    Assert(F64ArrayMin(array) == -2 && F64ArrayMax(array) == 3, "Unexpected min or max");
+    Assert(F64ArrayDot(array, array) == 14, "Unexpected dot product");
+
+    SetF64KernelLevel(GetSupportedF64KernelLevel());
+}
+
+static void TestShortAndEmptyArrays(Allocator* allocator) {
+    // shorter than one vector, so only the remainder loops run
+    for (F64KernelLevel level = F64_KERNELS_SCALAR; level <= GetSupportedF64KernelLevel(); level++) {
+        SetF64KernelLevel(level);
+        Object* empty = CreateF64ArrayObject(0, allocator);
+        Assertf(F64ArraySum(empty) == 0 && F64ArrayDot(empty, empty) == 0, "Expected zero at kernel level %d", level);
+        Assertf(F64ArrayArithmetic(F64_OP_ADD, empty, empty, allocator)->as.f64Array.count == 0,
+                "Expected an empty result at kernel level %d", level);
+
+        Object* single = CreateF64ArrayObject(1, allocator);
+        single->as.f64Array.items[0] = 2.5;
+        Assertf(F64ArraySum(single) == 2.5 && F64ArrayMin(single) == 2.5 && F64ArrayMax(single) == 2.5,
+                "Unexpected reduction at kernel level %d", level);
+    }
+    SetF64KernelLevel(GetSupportedF64KernelLevel());
+}
+
+static void TestItemsAreAligned(Allocator* allocator) {
+    for (size_t count = 1; count < F64ARRAY_TEST_COUNT; count++) {
+        Object* array = CreateF64ArrayObject(count, allocator);
+        Assertf((uintptr_t)array->as.f64Array.items % F64_ARRAY_ALIGNMENT == 0, "Unaligned items for count %ld", count);
+    }
+}
+
+static void RunTestCase(F64ArrayTestCase testCase) {
+    printf("%s\n", testCase.desc);
+
+    Allocator* allocator = CreateBumpAllocator(F64ARRAY_TEST_PAGE_SIZE, 1);
+    testCase.testFn(allocator);
+    AllocatorFree(allocator);
+}
+
+void F64ArrayTests() {
+    PRINT_TEST_TITLE();
+
+    RunTestCase((F64ArrayTestCase) {
+        .desc = "Vector kernels match the scalar kernels",
+        .testFn = TestKernelsMatchScalar,
+    });
+
+    RunTestCase((F64ArrayTestCase) {
+        .desc = "Scalar results",
+        .testFn = TestScalarResults,
+    });
+
+    RunTestCase((F64ArrayTestCase) {
+        .desc = "Short and empty arrays",
+        .testFn = TestShortAndEmptyArrays,
+    });
+
+    RunTestCase((F64ArrayTestCase) {
+        .desc = "Items are aligned",
+        .testFn = TestItemsAreAligned,
+    });
+}
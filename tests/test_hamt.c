@@ -0,0 +1,245 @@
+#include "tests.h"
+#include "memory.h"
+#include "hamt.h"
+
+typedef void (*HamtTestCaseFunc)(Allocator* allocator);
+
+typedef struct {
+    char* desc;
+    HamtTestCaseFunc testFn;
+} HamtTestCase;
+
+#define HAMT_TEST_PAGE_SIZE 4096
+#define HAMT_TEST_NUM_KEYS 10000
+#define HAMT_TEST_NUM_VERSIONS 5
+#define HAMT_TEST_NUM_COLLISIONS 5
+
+static void AssertMapEntry(Object* map, Value key, int32_t expected) {
+    Value value = MAKE_VALUE_NIL();
+    Assertf(HamtGet(map, key, &value, NULL), "Expected key %d to be found", ValueAsI32(key));
+    Assertf(GetValueType(value) == VALUE_I32 && ValueAsI32(value) == expected,
+            "Unexpected value for key %d", ValueAsI32(key));
+}
+
+static void AssertMissingKey(Object* hamt, Value key) {
+    Value value = MAKE_VALUE_NIL();
+    Assert(!HamtGet(hamt, key, &value, NULL), "Expected the key to be missing");
+}
+
+static void TestAssocGetDissoc(Allocator* allocator) {
+    Object* map = CreateMapObject(allocator);
+    map = HamtAssoc(map, MAKE_VALUE_I32(1), MAKE_VALUE_I32(10), allocator);
+    map = HamtAssoc(map, MAKE_VALUE_I32(2), MAKE_VALUE_I32(20), allocator);
+    map = HamtAssoc(map, MAKE_VALUE_I32(1), MAKE_VALUE_I32(11), allocator);
+
+    Assertf(map->as.hamt.count == 2, "Expected 2 entries, but received %d", map->as.hamt.count);
+    AssertMapEntry(map, MAKE_VALUE_I32(1), 11);
+    AssertMapEntry(map, MAKE_VALUE_I32(2), 20);
+    AssertMissingKey(map, MAKE_VALUE_I32(3));
+    AssertMissingKey(map, MAKE_VALUE_F64(1));
+
+    Assert(HamtAssoc(map, MAKE_VALUE_I32(2), MAKE_VALUE_I32(20), allocator) == map,
+           "Expected an unchanged map when the entry is already there");
+    Assert(HamtDissoc(map, MAKE_VALUE_I32(3), allocator) == map,
+           "Expected an unchanged map when the key is missing");
+
+    map = HamtDissoc(map, MAKE_VALUE_I32(1), allocator);
+    Assertf(map->as.hamt.count == 1, "Expected 1 entry, but received %d", map->as.hamt.count);
+    AssertMissingKey(map, MAKE_VALUE_I32(1));
+    AssertMapEntry(map, MAKE_VALUE_I32(2), 20);
+}
+
+static void TestOldVersionsAreKept(Allocator* allocator) {
+    Object* versions[HAMT_TEST_NUM_VERSIONS + 1];
+    versions[0] = CreateMapObject(allocator);
+    for (int i = 1; i <= HAMT_TEST_NUM_VERSIONS; i++) {
+        versions[i] = HamtAssoc(versions[i - 1], MAKE_VALUE_I32(i), MAKE_VALUE_I32(i), allocator);
+    }
+    Object* removed = HamtDissoc(versions[HAMT_TEST_NUM_VERSIONS], MAKE_VALUE_I32(1), allocator);
+
+    for (int i = 0; i <= HAMT_TEST_NUM_VERSIONS; i++) {
+        Assertf(versions[i]->as.hamt.count == i, "Unexpected count in version %d", i);
+        for (int k = 1; k <= HAMT_TEST_NUM_VERSIONS; k++) {
+            if (k <= i) {
+                AssertMapEntry(versions[i], MAKE_VALUE_I32(k), k);
+            } else {
+                AssertMissingKey(versions[i], MAKE_VALUE_I32(k));
+            }
+        }
+    }
+    AssertMissingKey(removed, MAKE_VALUE_I32(1));
+}
+
+static void TestManyKeys(Allocator* allocator) {
+    Object* map = CreateMapObject(allocator);
+    for (int i = 0; i < HAMT_TEST_NUM_KEYS; i++) {
+        map = HamtAssoc(map, MAKE_VALUE_I32(i), MAKE_VALUE_I32(-i), allocator);
+    }
+    Assertf(map->as.hamt.count == HAMT_TEST_NUM_KEYS, "Unexpected count %d", map->as.hamt.count);
+    for (int i = 0; i < HAMT_TEST_NUM_KEYS; i++) {
+        AssertMapEntry(map, MAKE_VALUE_I32(i), -i);
+    }
+
+    for (int i = 0; i < HAMT_TEST_NUM_KEYS; i += 2) {
+        map = HamtDissoc(map, MAKE_VALUE_I32(i), allocator);
+    }
+    Assertf(map->as.hamt.count == HAMT_TEST_NUM_KEYS / 2, "Unexpected count %d", map->as.hamt.count);
+    for (int i = 0; i < HAMT_TEST_NUM_KEYS; i++) {
+        if (i % 2 == 0) {
+            AssertMissingKey(map, MAKE_VALUE_I32(i));
+        } else {
+            AssertMapEntry(map, MAKE_VALUE_I32(i), -i);
+        }
+    }
+
+    for (int i = 1; i < HAMT_TEST_NUM_KEYS; i += 2) {
+        map = HamtDissoc(map, MAKE_VALUE_I32(i), allocator);
+    }
+    Assertf(map->as.hamt.count == 0, "Unexpected count %d", map->as.hamt.count);
+    Object* root = map->as.hamt.root;
+    Assert(root->as.hamtNode.dataMap == 0 && root->as.hamtNode.nodeMap == 0, "Expected an empty root node");
+}
+
+static void TestHashCollisions(Allocator* allocator) {
+    // symbols that are not interned are compared by identity, so they can share a hash
+    Value keys[HAMT_TEST_NUM_COLLISIONS];
+    for (int i = 0; i < HAMT_TEST_NUM_COLLISIONS; i++) {
+        Object* symbol = CreateSymbolObject(MakeString("collision"), allocator);
+        symbol->hash = 42;
+        keys[i] = MAKE_VALUE_OBJECT(symbol);
+    }
+
+    Object* map = CreateMapObject(allocator);
+    for (int i = 0; i < HAMT_TEST_NUM_COLLISIONS; i++) {
+        map = HamtAssoc(map, keys[i], MAKE_VALUE_I32(i), allocator);
+    }
+    Assertf(map->as.hamt.count == HAMT_TEST_NUM_COLLISIONS, "Unexpected count %d", map->as.hamt.count);
+    for (int i = 0; i < HAMT_TEST_NUM_COLLISIONS; i++) {
+        Value value = MAKE_VALUE_NIL();
+        Assertf(HamtGet(map, keys[i], &value, NULL) && ValueAsI32(value) == i, "Expected colliding key %d", i);
+    }
+
+    for (int i = 0; i < HAMT_TEST_NUM_COLLISIONS - 1; i++) {
+        map = HamtDissoc(map, keys[i], allocator);
+        Value value = MAKE_VALUE_NIL();
+        Assertf(!HamtGet(map, keys[i], &value, NULL), "Expected colliding key %d to be removed", i);
+    }
+    // the last entry is moved all the way up to the root
+    Object* root = map->as.hamt.root;
+    Assert(root->as.hamtNode.nodeMap == 0 && __builtin_popcount(root->as.hamtNode.dataMap) == 1,
+           "Expected a single entry in the root node");
+}
+
+static void TestTransient(Allocator* allocator) {
+    Object* map = CreateMapObject(allocator);
+    for (int i = 0; i < HAMT_TEST_NUM_KEYS / 10; i++) {
+        map = HamtAssoc(map, MAKE_VALUE_I32(i), MAKE_VALUE_I32(i), allocator);
+    }
+
+    Object* transient = HamtTransient(map, allocator);
+    for (int i = 0; i < HAMT_TEST_NUM_KEYS; i++) {
+        HamtTransientAssoc(transient, MAKE_VALUE_I32(i), MAKE_VALUE_I32(-i), allocator);
+    }
+
+    // the transient owns its nodes now, so updating them again does not allocate
+    size_t numAllocs = AllocatorGetStats(allocator).numAllocs;
+    for (int i = 0; i < HAMT_TEST_NUM_KEYS; i++) {
+        HamtTransientAssoc(transient, MAKE_VALUE_I32(i), MAKE_VALUE_I32(i), allocator);
+    }
+    Assert(AllocatorGetStats(allocator).numAllocs == numAllocs, "Expected the transient to be updated in place");
+
+    for (int i = 0; i < HAMT_TEST_NUM_KEYS; i += 2) {
+        HamtTransientDissoc(transient, MAKE_VALUE_I32(i), allocator);
+    }
+    Object* result = HamtPersistent(transient);
+
+    Assertf(result->as.hamt.count == HAMT_TEST_NUM_KEYS / 2, "Unexpected count %d", result->as.hamt.count);
+    for (int i = 0; i < HAMT_TEST_NUM_KEYS; i++) {
+        if (i % 2 == 0) {
+            AssertMissingKey(result, MAKE_VALUE_I32(i));
+        } else {
+            AssertMapEntry(result, MAKE_VALUE_I32(i), i);
+        }
+    }
+
+    // the map the transient started from is unchanged
+    Assertf(map->as.hamt.count == HAMT_TEST_NUM_KEYS / 10, "Unexpected count %d", map->as.hamt.count);
+    for (int i = 0; i < HAMT_TEST_NUM_KEYS / 10; i++) {
+        AssertMapEntry(map, MAKE_VALUE_I32(i), i);
+    }
+
+    // and so is the result when it is updated again
+    Object* next = HamtAssoc(result, MAKE_VALUE_I32(1), MAKE_VALUE_I32(0), allocator);
+    AssertMapEntry(result, MAKE_VALUE_I32(1), 1);
+    AssertMapEntry(next, MAKE_VALUE_I32(1), 0);
+}
+
+static void SumKeys(Value key, Value value, void* ctx) {
+    int32_t* sum = ctx;
+    *sum += ValueAsI32(key);
+}
+
+static void TestSets(Allocator* allocator) {
+    Object* set = CreateSetObject(allocator);
+    set = HamtAssoc(set, MAKE_VALUE_I32(1), MAKE_VALUE_NIL(), allocator);
+    set = HamtAssoc(set, MAKE_VALUE_I32(2), MAKE_VALUE_NIL(), allocator);
+    set = HamtAssoc(set, MAKE_VALUE_I32(1), MAKE_VALUE_NIL(), allocator);
+    Assertf(set->as.hamt.count == 2, "Expected 2 keys, but received %d", set->as.hamt.count);
+
+    Value value = MAKE_VALUE_NIL();
+    Assert(HamtGet(set, MAKE_VALUE_I32(2), &value, NULL) && ValueAsI32(value) == 2, "Expected the key as the value");
+
+    int32_t sum = 0;
+    HamtForEach(set, SumKeys, &sum);
+    Assertf(sum == 3, "Expected each key to be visited once, but the sum was %d", sum);
+
+    // strings are keys by their contents, also when one of them is a rope
+    Object* left = CreateStringObject(MakeString("a string that is long "), allocator);
+    Object* right = CreateStringObject(MakeString("enough to be a rope"), allocator);
+    Object* rope = CreateConcatObject(left, right, allocator);
+    Object* flat = CreateStringObject(MakeString("a string that is long enough to be a rope"), allocator);
+    set = HamtAssoc(set, MAKE_VALUE_OBJECT(rope), MAKE_VALUE_NIL(), allocator);
+    Assert(HamtGet(set, MAKE_VALUE_OBJECT(flat), &value, NULL), "Expected equal strings to be the same key");
+}
+
+static void RunTestCase(HamtTestCase testCase) {
+    printf("%s\n", testCase.desc);
+
+    Allocator* allocator = CreateBumpAllocator(HAMT_TEST_PAGE_SIZE, 1);
+    testCase.testFn(allocator);
+    AllocatorFree(allocator);
+}
+
+void HamtTests() {
+    PRINT_TEST_TITLE();
+
+    RunTestCase((HamtTestCase) {
+        .desc = "Assoc, get and dissoc",
+        .testFn = TestAssocGetDissoc,
+    });
+
+    RunTestCase((HamtTestCase) {
+        .desc = "Old versions are kept",
+        .testFn = TestOldVersionsAreKept,
+    });
+
+    RunTestCase((HamtTestCase) {
+        .desc = "Many keys",
+        .testFn = TestManyKeys,
+    });
+
+    RunTestCase((HamtTestCase) {
+        .desc = "Hash collisions",
+        .testFn = TestHashCollisions,
+    });
+
+    RunTestCase((HamtTestCase) {
+        .desc = "Transient",
+        .testFn = TestTransient,
+    });
+
+    RunTestCase((HamtTestCase) {
+        .desc = "Sets",
+        .testFn = TestSets,
+    });
+}
@@ -0,0 +1,160 @@
+#include "tests.h"
+#include "memory.h"
+#include "hashtable.h"
+
+typedef void (*HashTableTestCaseFunc)(Allocator* allocator);
+
+typedef struct {
+    char* desc;
+    HashTableTestCaseFunc testFn;
+} HashTableTestCase;
+
+#define HASHTABLE_TEST_PAGE_SIZE 4096
+#define HASHTABLE_TEST_NUM_KEYS 100000
+#define HASHTABLE_TEST_NUM_LIVE_KEYS 16
+#define HASHTABLE_TEST_NUM_COLLISIONS 40
+
+static void AssertTableEntry(Object* table, Value key, int32_t expected) {
+    Value value = MAKE_VALUE_NIL();
+    Assert(HashTableGet(table, key, &value, NULL), "Expected the key to be found");
+    Assertf(GetValueType(value) == VALUE_I32 && ValueAsI32(value) == expected,
+            "Expected the value %d", expected);
+}
+
+static void AssertMissingKey(Object* table, Value key) {
+    Value value = MAKE_VALUE_NIL();
+    Assert(!HashTableGet(table, key, &value, NULL), "Expected the key to be missing");
+}
+
+static void TestPutGetRemove(Allocator* allocator) {
+    Object* table = CreateHashTableObject(0, allocator);
+    HashTablePut(table, MAKE_VALUE_I32(1), MAKE_VALUE_I32(10), allocator);
+    HashTablePut(table, MAKE_VALUE_F64(1.5), MAKE_VALUE_I32(15), allocator);
+    HashTablePut(table, MAKE_VALUE_I32(1), MAKE_VALUE_I32(11), allocator);
+
+    Assertf(table->as.hashTable.count == 2, "Expected 2 entries, but received %d", table->as.hashTable.count);
+    AssertTableEntry(table, MAKE_VALUE_I32(1), 11);
+    AssertTableEntry(table, MAKE_VALUE_F64(1.5), 15);
+    AssertMissingKey(table, MAKE_VALUE_I32(2));
+
+    Assert(HashTableRemove(table, MAKE_VALUE_I32(1), allocator), "Expected the key to be removed");
+    Assert(!HashTableRemove(table, MAKE_VALUE_I32(1), allocator), "Expected the key to be removed only once");
+    Assertf(table->as.hashTable.count == 1, "Expected 1 entry, but received %d", table->as.hashTable.count);
+    AssertMissingKey(table, MAKE_VALUE_I32(1));
+    AssertTableEntry(table, MAKE_VALUE_F64(1.5), 15);
+}
+
+static void TestManyKeys(Allocator* allocator) {
+    Object* table = CreateHashTableObject(0, allocator);
+    for (int i = 0; i < HASHTABLE_TEST_NUM_KEYS; i++) {
+        HashTablePut(table, MAKE_VALUE_I32(i), MAKE_VALUE_I32(-i), allocator);
+    }
+    Assertf(table->as.hashTable.count == HASHTABLE_TEST_NUM_KEYS, "Unexpected count %d", table->as.hashTable.count);
+    for (int i = 0; i < HASHTABLE_TEST_NUM_KEYS; i++) {
+        AssertTableEntry(table, MAKE_VALUE_I32(i), -i);
+    }
+
+    for (int i = 0; i < HASHTABLE_TEST_NUM_KEYS; i += 2) {
+        HashTableRemove(table, MAKE_VALUE_I32(i), allocator);
+    }
+    for (int i = 0; i < HASHTABLE_TEST_NUM_KEYS; i++) {
+        if (i % 2 == 0) {
+            AssertMissingKey(table, MAKE_VALUE_I32(i));
+        } else {
+            AssertTableEntry(table, MAKE_VALUE_I32(i), -i);
+        }
+    }
+}
+
+static void TestReuseDeletedSlots(Allocator* allocator) {
+    Object* table = CreateHashTableObject(HASHTABLE_TEST_NUM_LIVE_KEYS * 2, allocator);
+    uint32_t capacity = table->as.hashTable.capacity;
+
+    // removing and adding keys over and over does not grow the table
+    for (int i = 0; i < HASHTABLE_TEST_NUM_KEYS; i++) {
+        HashTablePut(table, MAKE_VALUE_I32(i), MAKE_VALUE_I32(i), allocator);
+        if (i >= HASHTABLE_TEST_NUM_LIVE_KEYS) {
+            HashTableRemove(table, MAKE_VALUE_I32(i - HASHTABLE_TEST_NUM_LIVE_KEYS), allocator);
+        }
+    }
+    Assertf(table->as.hashTable.capacity == capacity, "Expected %d slots, but received %d", capacity, table->as.hashTable.capacity);
+    Assertf(table->as.hashTable.count == HASHTABLE_TEST_NUM_LIVE_KEYS, "Unexpected count %d", table->as.hashTable.count);
+    for (int i = HASHTABLE_TEST_NUM_KEYS - HASHTABLE_TEST_NUM_LIVE_KEYS; i < HASHTABLE_TEST_NUM_KEYS; i++) {
+        AssertTableEntry(table, MAKE_VALUE_I32(i), i);
+    }
+}
+
+static void TestHashCollisions(Allocator* allocator) {
+    // more keys with the same hash than fit in a probe group
+    Value keys[HASHTABLE_TEST_NUM_COLLISIONS];
+    Object* table = CreateHashTableObject(0, allocator);
+    for (int i = 0; i < HASHTABLE_TEST_NUM_COLLISIONS; i++) {
+        Object* symbol = CreateSymbolObject(MakeString("collision"), allocator);
+        symbol->hash = 42;
+        keys[i] = MAKE_VALUE_OBJECT(symbol);
+        HashTablePut(table, keys[i], MAKE_VALUE_I32(i), allocator);
+    }
+
+    for (int i = 0; i < HASHTABLE_TEST_NUM_COLLISIONS; i += 2) {
+        HashTableRemove(table, keys[i], allocator);
+    }
+    for (int i = 0; i < HASHTABLE_TEST_NUM_COLLISIONS; i++) {
+        if (i % 2 == 0) {
+            AssertMissingKey(table, keys[i]);
+        } else {
+            AssertTableEntry(table, keys[i], i);
+        }
+    }
+}
+
+static void TestStringKeys(Allocator* allocator) {
+    Object* table = CreateHashTableObject(0, allocator);
+    Object* left = CreateStringObject(MakeString("a string that is long "), allocator);
+    Object* right = CreateStringObject(MakeString("enough to be a rope"), allocator);
+    Object* rope = CreateConcatObject(left, right, allocator);
+    HashTablePut(table, MAKE_VALUE_OBJECT(rope), MAKE_VALUE_I32(1), allocator);
+
+    Object* flat = CreateStringObject(MakeString("a string that is long enough to be a rope"), allocator);
+    AssertTableEntry(table, MAKE_VALUE_OBJECT(flat), 1);
+
+    HashTablePut(table, MAKE_VALUE_OBJECT(InternSymbol(MakeString("a"))), MAKE_VALUE_I32(2), allocator);
+    AssertTableEntry(table, MAKE_VALUE_OBJECT(InternSymbol(MakeString("a"))), 2);
+    AssertMissingKey(table, MAKE_VALUE_OBJECT(CreateStringObject(MakeString("a"), allocator)));
+}
+
+static void RunTestCase(HashTableTestCase testCase) {
+    printf("%s\n", testCase.desc);
+
+    Allocator* allocator = CreateBumpAllocator(HASHTABLE_TEST_PAGE_SIZE, 1);
+    testCase.testFn(allocator);
+    AllocatorFree(allocator);
+}
+
+void HashTableTests() {
+    PRINT_TEST_TITLE();
+
+    RunTestCase((HashTableTestCase) {
+        .desc = "Put, get and remove",
+        .testFn = TestPutGetRemove,
+    });
+
+    RunTestCase((HashTableTestCase) {
+        .desc = "Many keys",
+        .testFn = TestManyKeys,
+    });
+
+    RunTestCase((HashTableTestCase) {
+        .desc = "Reuse deleted slots",
+        .testFn = TestReuseDeletedSlots,
+    });
+
+    RunTestCase((HashTableTestCase) {
+        .desc = "Hash collisions",
+        .testFn = TestHashCollisions,
+    });
+
+    RunTestCase((HashTableTestCase) {
+        .desc = "String and symbol keys",
+        .testFn = TestStringKeys,
+    });
+}
@@ -0,0 +1,204 @@
+#include "tests.h"
+#include "memory.h"
+#include "lazyseq.h"
+#include "vector.h"
+
+typedef void (*LazySeqTestCaseFunc)(Allocator* allocator);
+
+typedef struct {
+    char* desc;
+    LazySeqTestCaseFunc testFn;
+} LazySeqTestCase;
+
+#define LAZYSEQ_TEST_PAGE_SIZE 4096
+#define LAZYSEQ_TEST_MAX_VALUES 64
+
+/*
+ * The cursors call functions through a callback, so the tests use the
+ * operators as stand-ins for a few small functions.
+ */
+typedef struct {
+    size_t numCalls;
+} TestApplyContext;
+
+static bool TestApply(Value fn, Value arg, Value* result, void* ctx) {
+    TestApplyContext* test = ctx;
+    test->numCalls++;
+    int32_t n = ValueAsI32(arg);
+    switch (ValueAsOperator(fn)) {
+        // doubles
+        case OPERATOR_ADD:
+            *result = MAKE_VALUE_I32(n + n);
+            return true;
+        // keeps even numbers
+        case OPERATOR_MULTIPLY:
+            *result = MAKE_VALUE_BOOL(n % 2 == 0);
+            return true;
+        // fails past 3
+        case OPERATOR_DIVIDE:
+            *result = arg;
+            return n <= 3;
+        default:
+            AssertFail("Unexpected test function");
+            return false;
+    }
+}
+
+static size_t Collect(Value seq, int32_t* values, TestApplyContext* ctx, SeqNextResult* last, Allocator* allocator) {
+    SeqCursor cursor;
+    OpenSeqCursor(&cursor, seq, TestApply, ctx, allocator);
+
+    size_t count = 0;
+    Value value = MAKE_VALUE_NIL();
+    while ((*last = NextSeqValue(&cursor, &value)) == SEQ_NEXT_VALUE) {
+        Assert(count < LAZYSEQ_TEST_MAX_VALUES, "Expected a finite sequence");
+        values[count++] = ValueAsI32(value);
+    }
+    CloseSeqCursor(&cursor);
+    return count;
+}
+
+static void AssertValues(Value seq, int32_t* expected, size_t numExpected, Allocator* allocator) {
+    int32_t values[LAZYSEQ_TEST_MAX_VALUES];
+    TestApplyContext ctx = {0};
+    SeqNextResult last = SEQ_NEXT_VALUE;
+    size_t count = Collect(seq, values, &ctx, &last, allocator);
+
+    Assert(last == SEQ_NEXT_END, "Expected the sequence to end");
+    Assertf(count == numExpected, "Expected %ld values, but received %ld", numExpected, count);
+    for (size_t i = 0; i < count; i++) {
+        Assertf(values[i] == expected[i], "Expected %d at %ld, but received %d", expected[i], i, values[i]);
+    }
+}
+
+static void TestRange(Allocator* allocator) {
+    Value range = MAKE_VALUE_OBJECT(CreateRangeSeq(2, 6, allocator));
+    AssertValues(range, (int32_t[]) { 2, 3, 4, 5 }, 4, allocator);
+    // a sequence is a recipe, so it can be consumed again
+    AssertValues(range, (int32_t[]) { 2, 3, 4, 5 }, 4, allocator);
+
+    Value empty = MAKE_VALUE_OBJECT(CreateRangeSeq(3, 3, allocator));
+    AssertValues(empty, NULL, 0, allocator);
+}
+
+static void TestTransformChain(Allocator* allocator) {
+    Value doubled = MAKE_VALUE_OBJECT(CreateTransformSeq(SEQ_MAP, MAKE_VALUE_OPERATOR(OPERATOR_ADD),
+            MAKE_VALUE_OBJECT(CreateRangeSeq(0, 10, allocator)), allocator));
+    Value evens = MAKE_VALUE_OBJECT(CreateTransformSeq(SEQ_FILTER, MAKE_VALUE_OPERATOR(OPERATOR_MULTIPLY),
+            MAKE_VALUE_OBJECT(CreateRangeSeq(0, 10, allocator)), allocator));
+    AssertValues(doubled, (int32_t[]) { 0, 2, 4, 6, 8, 10, 12, 14, 16, 18 }, 10, allocator);
+    AssertValues(evens, (int32_t[]) { 0, 2, 4, 6, 8 }, 5, allocator);
+}
+
+static void TestListAndVectorSources(Allocator* allocator) {
+    Value items[] = { MAKE_VALUE_I32(1), MAKE_VALUE_I32(2), MAKE_VALUE_I32(3) };
+    Value list = MAKE_VALUE_OBJECT(CreateListObject(items, 3, MAKE_VALUE_NIL(), allocator));
+    Value vector = MAKE_VALUE_OBJECT(CreateVectorObject(items, 3, allocator));
+
+    Value fn = MAKE_VALUE_OPERATOR(OPERATOR_ADD);
+    AssertValues(MAKE_VALUE_OBJECT(CreateTransformSeq(SEQ_MAP, fn, list, allocator)), (int32_t[]) { 2, 4, 6 }, 3, allocator);
+    AssertValues(MAKE_VALUE_OBJECT(CreateTransformSeq(SEQ_MAP, fn, vector, allocator)), (int32_t[]) { 2, 4, 6 }, 3, allocator);
+    AssertValues(MAKE_VALUE_OBJECT(CreateTakeSeq(5, MAKE_VALUE_NIL(), allocator)), NULL, 0, allocator);
+}
+
+static void TestTakeOfInfiniteSequence(Allocator* allocator) {
+    Value powers = MAKE_VALUE_OBJECT(CreateIterateSeq(MAKE_VALUE_OPERATOR(OPERATOR_ADD), MAKE_VALUE_I32(1), allocator));
+    Value seq = MAKE_VALUE_OBJECT(CreateTakeSeq(5, powers, allocator));
+
+    int32_t values[LAZYSEQ_TEST_MAX_VALUES];
+    TestApplyContext ctx = {0};
+    SeqNextResult last = SEQ_NEXT_VALUE;
+    size_t count = Collect(seq, values, &ctx, &last, allocator);
+
+    Assertf(count == 5 && values[4] == 16, "Expected 5 powers of two, but received %ld", count);
+    // the seed is not computed, and nothing past the last element is
+    Assertf(ctx.numCalls == 4, "Expected 4 calls, but received %ld", ctx.numCalls);
+}
+
+static void TestFailingFunction(Allocator* allocator) {
+    Value seq = MAKE_VALUE_OBJECT(CreateTransformSeq(SEQ_MAP, MAKE_VALUE_OPERATOR(OPERATOR_DIVIDE),
+            MAKE_VALUE_OBJECT(CreateRangeSeq(0, 10, allocator)), allocator));
+
+    int32_t values[LAZYSEQ_TEST_MAX_VALUES];
+    TestApplyContext ctx = {0};
+    SeqNextResult last = SEQ_NEXT_VALUE;
+    size_t count = Collect(seq, values, &ctx, &last, allocator);
+
+    Assert(last == SEQ_NEXT_ERROR, "Expected the sequence to fail");
+    Assertf(count == 4, "Expected 4 values before the failure, but received %ld", count);
+}
+
+static void AssertLine(SeqCursor* cursor, const char* expected) {
+    Value line = MAKE_VALUE_NIL();
+    Assert(NextSeqValue(cursor, &line) == SEQ_NEXT_VALUE, "Expected a line");
+    Assertf(StringEquals(GetStringChars(ValueAsObject(line), NULL), MakeString(expected)), "Expected the line %s", expected);
+}
+
+static void TestLines(Allocator* allocator) {
+    char path[] = "/tmp/parens_lazyseq_XXXXXX";
+    int fd = mkstemp(path);
+    Assert(fd >= 0, "Failed to create a temporary file");
+    FILE* file = fdopen(fd, "w");
+    // longer than the initial buffer, so that the buffer grows
+    fprintf(file, "first\n\n%0200d\nlast", 0);
+    fclose(file);
+
+    Value seq = MAKE_VALUE_OBJECT(CreateLinesSeq(CreateStringObject(MakeString(path), allocator), allocator));
+    SeqCursor cursor;
+    OpenSeqCursor(&cursor, seq, TestApply, NULL, allocator);
+    AssertLine(&cursor, "first");
+    AssertLine(&cursor, "");
+    Value line = MAKE_VALUE_NIL();
+    Assert(NextSeqValue(&cursor, &line) == SEQ_NEXT_VALUE && ValueAsObject(line)->as.string.length == 200, "Expected a long line");
+    AssertLine(&cursor, "last");
+    Assert(NextSeqValue(&cursor, &line) == SEQ_NEXT_END, "Expected the file to end");
+    CloseSeqCursor(&cursor);
+    remove(path);
+
+    Value missing = MAKE_VALUE_OBJECT(CreateLinesSeq(CreateStringObject(MakeString(path), allocator), allocator));
+    OpenSeqCursor(&cursor, missing, TestApply, NULL, allocator);
+    Assert(NextSeqValue(&cursor, &line) == SEQ_NEXT_ERROR && cursor.error != NULL, "Expected a missing file to fail");
+    CloseSeqCursor(&cursor);
+}
+
+static void RunTestCase(LazySeqTestCase testCase) {
+    printf("%s\n", testCase.desc);
+
+    Allocator* allocator = CreateBumpAllocator(LAZYSEQ_TEST_PAGE_SIZE, 1);
+    testCase.testFn(allocator);
+    AllocatorFree(allocator);
+}
+
+void LazySeqTests() {
+    PRINT_TEST_TITLE();
+
+    RunTestCase((LazySeqTestCase) {
+        .desc = "Range",
+        .testFn = TestRange,
+    });
+
+    RunTestCase((LazySeqTestCase) {
+        .desc = "Map and filter",
+        .testFn = TestTransformChain,
+    });
+
+    RunTestCase((LazySeqTestCase) {
+        .desc = "Lists and vectors as sources",
+        .testFn = TestListAndVectorSources,
+    });
+
+    RunTestCase((LazySeqTestCase) {
+        .desc = "Take of an infinite sequence",
+        .testFn = TestTakeOfInfiniteSequence,
+    });
+
+    RunTestCase((LazySeqTestCase) {
+        .desc = "Failing function",
+        .testFn = TestFailingFunction,
+    });
+
+    RunTestCase((LazySeqTestCase) {
+        .desc = "Lines of a file",
+        .testFn = TestLines,
+    });
+}
@@ -3,6 +3,15 @@
 int main() {
     DynamicArrayTests();
     BumpAllocatorTests();
+    SlabAllocatorTests();
+    VirtualArenaAllocatorTests();
+    ThreadSafeAllocatorTests();
+    HamtTests();
+    HashTableTests();
+    VectorTests();
+    F64ArrayTests();
+    StringOpsTests();
+    LazySeqTests();
     TokenizerTests();
     ParserTests();
     BytecodeGeneratorTests();
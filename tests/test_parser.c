@@ -19,32 +19,35 @@ static bool AstAtomEquals(Ast* first, Ast* second) {
     Value v1 = first->as.atom.value;
     Value v2 = second->as.atom.value;
 
-    if (v1.type != v2.type) {
+    if (GetValueType(v1) != GetValueType(v2)) {
         return false;
     }
 
-    switch (v1.type) {
+    switch (GetValueType(v1)) {
         case VALUE_NIL:
             return true; // already checked the type
         case VALUE_F64:
-            return v1.as.f64 == v2.as.f64;
+            return ValueAsF64(v1) == ValueAsF64(v2);
+        case VALUE_I32:
+            return ValueAsI32(v1) == ValueAsI32(v2);
         case VALUE_OBJECT: {
-            Object* o1 = v1.as.object;
-            Object* o2 = v2.as.object;
+            Object* o1 = ValueAsObject(v1);
+            Object* o2 = ValueAsObject(v2);
             if (o1->type != o2->type) {
                 return false;
             }
             if (o1->type == OBJECT_STRING) {
-                return StringEquals(o1->as.string, o2->as.string);
+                return StringEquals(GetStringChars(o1, NULL), GetStringChars(o2, NULL));
             } else if (o1->type == OBJECT_SYMBOL) {
-                return StringEquals(o1->as.symbol, o2->as.symbol);
+                // symbols are interned
+                return o1 == o2;
             }
             break;
         }
         case VALUE_OPERATOR:
-            return v1.as.operator == v2.as.operator;
+            return ValueAsOperator(v1) == ValueAsOperator(v2);
         case VALUE_COMPTIME_OPERATOR:
-            return v1.as.comptimeOperator == v2.as.comptimeOperator;
+            return ValueAsComptimeOperator(v1) == ValueAsComptimeOperator(v2);
         default:
             break;
     }
@@ -70,6 +73,8 @@ static bool AstEquals(Ast* first, Ast* second) {
         case AST_CONS:
             return AstEquals(first->as.cons.head, second->as.cons.head)
                 && AstEquals(first->as.cons.tail, second->as.cons.tail);
+        case AST_VECTOR:
+            return AstEquals(first->as.vector.elements, second->as.vector.elements);
         default: break;
     }
 
@@ -128,26 +133,15 @@ static void RunTestCase(ParserTestCase testCase) {
     DA_FREE(&tokens);
 }
 
-static void AssertExpectedSymbol(Object* symbol, const char* cs, size_t length) {
-    Assert(symbol->type == OBJECT_SYMBOL, "Expected a symbol object");
-    Assertf(symbol->as.symbol.length == length, "Expected string length %ld, but received %ld\n", 1, symbol->as.symbol.length);
-    if (!StringEquals(symbol->as.symbol, MakeString(cs))) {
-        printf("Unexpected string:");
-        PrintString(symbol->as.symbol);
-        printf("\n");
-        AssertFailf("Expected symbol string \"%s\"", cs);
-    }
-}
-
 static void AssertExpectedSymbolAtom(Ast* ast, Object* expected) {
     Assertf(ast->type == AST_ATOM, "Expected atom, but received %d", ast->type);
     AstAtom* atom = &ast->as.atom;
-    Assertf(atom->value.type == VALUE_OBJECT, "Expected object value, but received %d", atom->value.type);
-    Assertf(atom->value.as.object == expected, "Expected object reference to be %ld, but received %ld", expected, atom->value.as.object);
+    Assertf(GetValueType(atom->value) == VALUE_OBJECT, "Expected object value, but received %d", GetValueType(atom->value));
+    Assertf(ValueAsObject(atom->value) == expected, "Expected object reference to be %ld, but received %ld", expected, ValueAsObject(atom->value));
 }
 
-// (a . b) = 2 symbols, 2 atoms, 1 cons
-#define PARSE_TEST_SIMPLE_CONS_SIZE (sizeof(Object) * 2 + sizeof(Ast) * 3)
+// (a . b) = 2 atoms, 1 cons
+#define PARSE_TEST_SIMPLE_CONS_SIZE (sizeof(Ast) * 3)
 
 /*
  * This is a memory layout test for parsing with a bump allocator.
@@ -161,14 +155,14 @@ static void AssertExpectedSymbolAtom(Ast* ast, Object* expected) {
  * Output = CONS(SYMBOL("a"), SYMBOL("b"))
  *
  * The traversal is in post-order (head, tail, parent).
- * Symbol values are allocated before their atom wrappers are.
+ * Symbols are interned, so only the atoms refer to them.
  * This gives the following memory layout.
  *
- *                     PAGE 1
- * | symbol a, atom a, symbol b, atom b cons(a, b) |
- *                                      ^
- *                                      |
- *                                      Result AST pointer
+ *           PAGE 1
+ * | atom a, atom b cons(a, b) |
+ *                  ^
+ *                  |
+ *                  Result AST pointer
  *
  * The parse result points to the beginning of the final CONS.
  */
@@ -183,20 +177,12 @@ static void TestSimpleConsIsSequentialSinglePage(Allocator* allocator, ParseResu
 
     Byte* current = firstNodeStart;
 
-    AssertExpectedSymbol((Object*)current, "a", 1);
-
-    Object* prevSymbol = (Object*)current;
-    current += sizeof(Object);
     Ast* head = (Ast*)current;
-    AssertExpectedSymbolAtom((Ast*)current, prevSymbol);
+    AssertExpectedSymbolAtom((Ast*)current, InternSymbol(MakeString("a")));
 
     current += sizeof(Ast);
-    AssertExpectedSymbol((Object*)current, "b", 1);
-
-    prevSymbol = (Object*)current;
-    current += sizeof(Object);
     Ast* tail = (Ast*)current;
-    AssertExpectedSymbolAtom((Ast*)current, prevSymbol);
+    AssertExpectedSymbolAtom((Ast*)current, InternSymbol(MakeString("b")));
 
     current += sizeof(Ast);
     Ast* ast = (Ast*)current;
@@ -214,11 +200,11 @@ static void TestSimpleConsIsSequentialSinglePage(Allocator* allocator, ParseResu
  *
  * This is the memory layout.
  *
- *               PAGE 1                     PAGE 2
- * | symbol a, atom a, symbol b, atom b | cons(a, b) |
- *             ^                          ^
- *             |                          |
- *             this is the cons head      Result AST pointer
+ *         PAGE 1            PAGE 2
+ * | atom a, atom b | cons(a, b) |
+ *   ^                ^
+ *   |                |
+ *   the cons head    Result AST pointer
  *
  */
 static void TestSimpleConsIsSequentialMultiPage(Allocator* allocator, ParseResult result) {
@@ -230,27 +216,18 @@ static void TestSimpleConsIsSequentialMultiPage(Allocator* allocator, ParseResul
     Ast* ast = (Ast*)current;
     Assertf(ast->type == AST_CONS, "Expected Cons, but received %d", ast->type);
 
-    Byte* headStart = (Byte*)ast->as.cons.head;
-    Byte* firstNodeStart = headStart - sizeof(Object); // page 1 start
+    Byte* firstNodeStart = (Byte*)ast->as.cons.head; // page 1 start
 
     current = firstNodeStart;
 
     // -- Verify page 1 --
 
-    AssertExpectedSymbol((Object*)current, "a", 1);
-
-    Object* prevSymbol = (Object*)current;
-    current += sizeof(Object);
     Ast* head = (Ast*)current;
-    AssertExpectedSymbolAtom((Ast*)current, prevSymbol);
+    AssertExpectedSymbolAtom((Ast*)current, InternSymbol(MakeString("a")));
 
     current += sizeof(Ast);
-    AssertExpectedSymbol((Object*)current, "b", 1);
-
-    prevSymbol = (Object*)current;
-    current += sizeof(Object);
     Ast* tail = (Ast*)current;
-    AssertExpectedSymbolAtom((Ast*)current, prevSymbol);
+    AssertExpectedSymbolAtom((Ast*)current, InternSymbol(MakeString("b")));
 
     // -- Verify page 2 --
 
@@ -261,6 +238,39 @@ static void TestSimpleConsIsSequentialMultiPage(Allocator* allocator, ParseResul
     Assertf(ast->as.cons.tail == tail, "Expected tail to be %ld, but received %ld", (size_t)tail, (size_t)ast->as.cons.tail);
 }
 
+static void TestSymbolsAreInterned(Allocator* allocator, ParseResult result) {
+    Assert(result.type == RESULT_SUCCESS, "Expected parse success");
+
+    // (a b a)
+    Ast* first = result.as.success.ast->as.cons.head;
+    Ast* second = result.as.success.ast->as.cons.tail->as.cons.head;
+    Ast* third = result.as.success.ast->as.cons.tail->as.cons.tail->as.cons.head;
+
+    Object* a = InternSymbol(MakeString("a"));
+    AssertExpectedSymbolAtom(first, a);
+    AssertExpectedSymbolAtom(third, a);
+    Assert(ValueAsObject(second->as.atom.value) != a, "Expected different symbols to be different objects");
+
+    // grow the table past its initial capacity
+    char name[16];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(name, sizeof(name), "sym%d", i);
+        InternSymbol(MakeString(name));
+    }
+    Assert(InternSymbol(MakeString("a")) == a, "Expected the symbol to survive the table growing");
+    snprintf(name, sizeof(name), "sym%d", 123);
+    Assert(InternSymbol(MakeString(name)) == InternSymbol(MakeString("sym123")),
+           "Expected a copied name to give the same symbol");
+}
+
+static void TestFailedParseIsReleased(Allocator* allocator, ParseResult result) {
+    Assert(result.type == RESULT_ERROR, "Expected parse error");
+
+    AllocatorStats stats = AllocatorGetStats(allocator);
+    Assert(stats.numAllocs > 0, "Expected the parser to allocate nodes before failing");
+    Assertf(stats.bytesInUse == 0, "Expected the partial tree to be released, but %ld bytes are in use", stats.bytesInUse);
+}
+
 static Ast* QuoteAst(Ast* ast) {
     ast->isQuoted = true;
     return ast;
@@ -270,9 +280,11 @@ static Ast* QuoteAst(Ast* ast) {
 #define CONS(h, t) CreateCons(h, t, inputAllocator)
 #define NIL() CreateAtom(MAKE_VALUE_NIL(), DUMMY_TOKEN, inputAllocator)
 #define F64(x) CreateAtom(MAKE_VALUE_F64(x), DUMMY_TOKEN, inputAllocator)
+#define I32(x) CreateAtom(MAKE_VALUE_I32(x), DUMMY_TOKEN, inputAllocator)
 #define SYMBOL(cs) CreateSymbolAtom(MakeString(cs), DUMMY_TOKEN, inputAllocator)
 #define STRING(cs) CreateStringAtom(MakeString(cs), DUMMY_TOKEN, inputAllocator)
 #define QUOTE(ast) QuoteAst(ast)
+#define VECTOR(elements) CreateVector(elements, DUMMY_TOKEN, inputAllocator)
 #define OPERATOR(op) CreateAtom(MAKE_VALUE_OPERATOR(op), DUMMY_TOKEN, inputAllocator)
 #define FUN() CreateAtom(MAKE_VALUE_COMPTIME_OPERATOR(COMPTIME_OPERATOR_FUN), DUMMY_TOKEN, inputAllocator)
 
@@ -339,10 +351,10 @@ void ParserTests() {
         .expected = {
             .type = RESULT_SUCCESS,
             .as.success.ast = CONS(
-                CONS(F64(1), F64(2)),
+                CONS(I32(1), I32(2)),
                 CONS(
-                    F64(3),
-                    CONS(F64(4), F64(5))
+                    I32(3),
+                    CONS(I32(4), I32(5))
                 )
             ),
         },
@@ -353,7 +365,7 @@ void ParserTests() {
         .input = "(1 2)",
         .expected = {
             .type = RESULT_SUCCESS,
-            .as.success.ast = CONS(F64(1), CONS(F64(2), NIL())),
+            .as.success.ast = CONS(I32(1), CONS(I32(2), NIL())),
         },
     });
 
@@ -366,16 +378,16 @@ void ParserTests() {
                 /*
                  * (1 2) = (1 . (2 . nil))
                  */
-                CONS(F64(1), CONS(F64(2), NIL())),
+                CONS(I32(1), CONS(I32(2), NIL())),
                 // append nil after (3 (4 5))
                 CONS(
                     /*
                      * (3 (4 5)) = (3 . ((4 . (5 . nil)) . nil)
                      */
                     CONS(
-                        F64(3),
+                        I32(3),
                         CONS(
-                            CONS(F64(4), CONS(F64(5), NIL())),
+                            CONS(I32(4), CONS(I32(5), NIL())),
                             NIL()
                         )
                     ),
@@ -399,7 +411,32 @@ void ParserTests() {
         .input = "'(1 2)",
         .expected = {
             .type = RESULT_SUCCESS,
-            .as.success.ast = QUOTE(CONS(F64(1), CONS(F64(2), NIL()))),
+            .as.success.ast = QUOTE(CONS(I32(1), CONS(I32(2), NIL()))),
+        },
+    });
+
+    RunTestCase((ParserTestCase) {
+        .desc = "Vector literal",
+        .input = "[1 (+ 2 3) []]",
+        .expected = {
+            .type = RESULT_SUCCESS,
+            .as.success.ast = VECTOR(
+                CONS(
+                    I32(1),
+                    CONS(
+                        CONS(OPERATOR(OPERATOR_ADD), CONS(I32(2), CONS(I32(3), NIL()))),
+                        CONS(VECTOR(NIL()), NIL())
+                    )
+                )
+            ),
+        },
+    });
+
+    RunTestCase((ParserTestCase) {
+        .desc = "Unterminated vector",
+        .input = "[1 2",
+        .expected = {
+            .type = RESULT_ERROR,
         },
     });
 
@@ -408,7 +445,7 @@ void ParserTests() {
         .input = "(+ 1 2)",
         .expected = {
             .type = RESULT_SUCCESS,
-            .as.success.ast = CONS(OPERATOR(OPERATOR_ADD), CONS(F64(1), CONS(F64(2), NIL()))),
+            .as.success.ast = CONS(OPERATOR(OPERATOR_ADD), CONS(I32(1), CONS(I32(2), NIL()))),
         },
     });
 
@@ -417,7 +454,7 @@ void ParserTests() {
         .input = "(fun () 1)",
         .expected = {
             .type = RESULT_SUCCESS,
-            .as.success.ast = CONS(FUN(), CONS(NIL(), CONS(F64(1), NIL()))),
+            .as.success.ast = CONS(FUN(), CONS(NIL(), CONS(I32(1), NIL()))),
         },
     });
 
@@ -427,7 +464,7 @@ void ParserTests() {
         .expected = {
             .type = RESULT_SUCCESS,
             .as.success.ast = CONS(OPERATOR(OPERATOR_SET_GLOBAL),
-                                   CONS(SYMBOL("x"), CONS(F64(1), NIL())))
+                                   CONS(SYMBOL("x"), CONS(I32(1), NIL())))
         },
     });
 
@@ -439,7 +476,7 @@ void ParserTests() {
             .as.success.ast = CONS(
                 OPERATOR(OPERATOR_SET_GLOBAL),
                     CONS(SYMBOL("one"),
-                        CONS(FUN(), CONS(NIL(), CONS(F64(1), NIL())))
+                        CONS(FUN(), CONS(NIL(), CONS(I32(1), NIL())))
                     )
                 )
         },
@@ -472,14 +509,37 @@ void ParserTests() {
         .InspectAllocator = &TestSimpleConsIsSequentialMultiPage,
     });
 
+    RunTestCase((ParserTestCase) {
+        .desc = "Interned symbols",
+        .input = "(a b a)",
+        .expected = {
+            .type = RESULT_SUCCESS,
+            .as.success.ast = CONS(SYMBOL("a"), CONS(SYMBOL("b"), CONS(SYMBOL("a"), NIL()))),
+        },
+        .shouldInspectAllocator = true,
+        .InspectAllocator = &TestSymbolsAreInterned,
+    });
+
+    RunTestCase((ParserTestCase) {
+        .desc = "Inspect arena memory - Release partial tree on error",
+        .input = "(a b (c",
+        .expected = {
+            .type = RESULT_ERROR,
+        },
+        .shouldInspectAllocator = true,
+        .InspectAllocator = &TestFailedParseIsReleased,
+    });
+
     AllocatorFree(inputAllocator);
 }
 
 #undef CONS
 #undef NIL
 #undef F64
+#undef I32
 #undef SYMBOL
 #undef STRING
 #undef QUOTE
+#undef VECTOR
 #undef OPERATOR
 #undef FUN
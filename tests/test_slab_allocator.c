@@ -0,0 +1,222 @@
+#include "tests.h"
+#include "memory.h"
+
+typedef struct {
+    int i;
+    double d;
+} SlabTestData;
+
+typedef void (*SlabTestCaseFunc)();
+
+typedef struct {
+    char* desc;
+    SlabTestCaseFunc testFn;
+    size_t objectSize;
+    size_t objectsPerSlab;
+} SlabTestCase;
+
+static void TestAllocateOneObject(Allocator* allocator) {
+    SlabTestData* s = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    *s = (SlabTestData){ .i = 1, .d = 2.3 };
+}
+
+static void TestAllocateTwoObjectsSequentially(Allocator* allocator) {
+    SlabTestData* s1 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    *s1 = (SlabTestData){ .i = 1, .d = 2.3 };
+    SlabTestData* s2 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    *s2 = (SlabTestData){ .i = 4, .d = 5.6 };
+
+    size_t diff = (s2 - s1) * sizeof(SlabTestData);
+    Assertf(diff == sizeof(SlabTestData), "Expected objects to be sequential, but the diff was %ld bytes.", diff);
+    Assert(s1->i == 1 && s1->d == 2.3, "Expected initial data to not be modified after second allocation.");
+}
+
+static void TestShouldNotExceedObjectSize(Allocator* allocator) {
+    SetAssertEnabledFromTest(false);
+    void* result = AllocatorAlloc(sizeof(SlabTestData) + 1, allocator);
+    SetAssertEnabledFromTest(true);
+    Assert(result == NULL, "Cannot allocate more than the object size in a single call.");
+}
+
+static void TestShouldNotExceedSlotAlignment(Allocator* allocator) {
+    SlabTestData* s = AllocatorAllocAligned(sizeof(SlabTestData), 16, allocator);
+    Assertf((size_t)s % 16 == 0, "Expected 16 byte alignment, but the address was %ld.", (size_t)s);
+
+    SetAssertEnabledFromTest(false);
+    void* result = AllocatorAllocAligned(sizeof(SlabTestData), 64, allocator);
+    SetAssertEnabledFromTest(true);
+    Assert(result == NULL, "Cannot align to more than the slot alignment.");
+}
+
+static void TestFreedObjectIsReused(Allocator* allocator) {
+    SlabTestData* s1 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    SlabTestData* s2 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    AllocatorFreeObject(s1, sizeof(SlabTestData), allocator);
+    SlabTestData* s3 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+
+    Assert(s1 == s3, "Expected freed object address to be re-used");
+    Assert(s2 != s3, "Expected used object address to NOT be re-used");
+}
+
+static void TestAllocateNewSlab(Allocator* allocator) {
+    // two objects per slab
+    SlabTestData* s1 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    *s1 = (SlabTestData){ .i = 1, .d = 2.3 };
+    SlabTestData* s2 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    *s2 = (SlabTestData){ .i = 4, .d = 5.6 };
+    SlabTestData* s3 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    *s3 = (SlabTestData){ .i = 7, .d = 8.9 };
+
+    Assert(s3 != s1 + 2, "Expected third object to be in a new slab");
+    Assert(s1->i == 1 && s2->i == 4, "Expected initial data to not be modified after new slab.");
+}
+
+static void TestFullSlabIsReusedAfterFree(Allocator* allocator) {
+    // two objects per slab
+    SlabTestData* s1 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    SlabTestData* s2 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    SlabTestData* s3 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    SlabTestData* s4 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+
+    AllocatorFreeObject(s2, sizeof(SlabTestData), allocator);
+    SlabTestData* s5 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+
+    Assert(s2 == s5, "Expected freed slot in a full slab to be re-used");
+    Assert(s1 != s5 && s3 != s5 && s4 != s5, "Expected used slots to NOT be re-used");
+}
+
+/*
+ * Allocates and frees across several slabs, including slabs being
+ * released when they become empty, and makes sure live objects
+ * are never handed out twice.
+ */
+static void TestManyObjectsStayIntact(Allocator* allocator) {
+    #define SLAB_TEST_NUM_OBJECTS 100
+    SlabTestData* objects[SLAB_TEST_NUM_OBJECTS];
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < SLAB_TEST_NUM_OBJECTS; i++) {
+            objects[i] = AllocatorAlloc(sizeof(SlabTestData), allocator);
+            *objects[i] = (SlabTestData){ .i = i, .d = round };
+        }
+        // free every other object, then everything
+        for (int i = 0; i < SLAB_TEST_NUM_OBJECTS; i += 2) {
+            AllocatorFreeObject(objects[i], sizeof(SlabTestData), allocator);
+        }
+        for (int i = 1; i < SLAB_TEST_NUM_OBJECTS; i += 2) {
+            Assertf(objects[i]->i == i && objects[i]->d == round,
+                    "Expected object %d to be intact in round %d", i, round);
+            AllocatorFreeObject(objects[i], sizeof(SlabTestData), allocator);
+        }
+    }
+    #undef SLAB_TEST_NUM_OBJECTS
+}
+
+static void TestResetAndReuse(Allocator* allocator) {
+    SlabTestData* s1 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    SlabTestData* s2 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+
+    AllocatorReset(allocator);
+
+    SlabTestData* s3 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    SlabTestData* s4 = AllocatorAlloc(sizeof(SlabTestData), allocator);
+
+    Assert(s1 == s3, "Expected first object address to be re-used");
+    Assert(s2 == s4, "Expected second object address to be re-used");
+}
+
+/*
+ * Slabs are released when they become empty, except for one spare slab.
+ */
+static void TestEmptySlabsAreReleased(Allocator* allocator) {
+    // two objects per slab
+    SlabTestData* objects[6];
+    for (int i = 0; i < 6; i++) {
+        objects[i] = AllocatorAlloc(sizeof(SlabTestData), allocator);
+    }
+
+    AllocatorStats stats = AllocatorGetStats(allocator);
+    Assertf(stats.numPages == 3, "Expected 3 slabs, but received %ld", stats.numPages);
+
+    for (int i = 0; i < 6; i++) {
+        AllocatorFreeObject(objects[i], sizeof(SlabTestData), allocator);
+    }
+
+    stats = AllocatorGetStats(allocator);
+    Assertf(stats.numPages == 1, "Expected 1 slab, but received %ld", stats.numPages);
+    Assertf(stats.bytesInUse == 0, "Expected no bytes in use, but received %ld", stats.bytesInUse);
+    Assertf(stats.highWaterMark == 3 * stats.bytesReserved,
+            "Expected high-water mark to be 3 slabs, but received %ld", stats.highWaterMark);
+}
+
+static void RunTestCase(SlabTestCase testCase) {
+    printf("%s\n", testCase.desc);
+    Allocator* allocator = CreateSlabAllocator(testCase.objectSize, testCase.objectsPerSlab);
+    testCase.testFn(allocator);
+    AllocatorFree(allocator);
+}
+
+void SlabAllocatorTests() {
+    PRINT_TEST_TITLE();
+
+    RunTestCase((SlabTestCase) {
+        .desc = "One object",
+        .testFn = &TestAllocateOneObject,
+        .objectSize = sizeof(SlabTestData),
+        .objectsPerSlab = 1,
+    });
+    RunTestCase((SlabTestCase) {
+        .desc = "Two objects sequentially",
+        .testFn = &TestAllocateTwoObjectsSequentially,
+        .objectSize = sizeof(SlabTestData),
+        .objectsPerSlab = 10,
+    });
+    RunTestCase((SlabTestCase) {
+        .desc = "Fail to allocate more than object size",
+        .testFn = &TestShouldNotExceedObjectSize,
+        .objectSize = sizeof(SlabTestData),
+        .objectsPerSlab = 10,
+    });
+    RunTestCase((SlabTestCase) {
+        .desc = "Fail to align more than the slot alignment",
+        .testFn = &TestShouldNotExceedSlotAlignment,
+        .objectSize = sizeof(SlabTestData),
+        .objectsPerSlab = 10,
+    });
+    RunTestCase((SlabTestCase) {
+        .desc = "Re-use freed object",
+        .testFn = &TestFreedObjectIsReused,
+        .objectSize = sizeof(SlabTestData),
+        .objectsPerSlab = 10,
+    });
+    RunTestCase((SlabTestCase) {
+        .desc = "Grow by one slab",
+        .testFn = &TestAllocateNewSlab,
+        .objectSize = sizeof(SlabTestData),
+        .objectsPerSlab = 2,
+    });
+    RunTestCase((SlabTestCase) {
+        .desc = "Re-use freed object in a full slab",
+        .testFn = &TestFullSlabIsReusedAfterFree,
+        .objectSize = sizeof(SlabTestData),
+        .objectsPerSlab = 2,
+    });
+    RunTestCase((SlabTestCase) {
+        .desc = "Many objects across slabs stay intact",
+        .testFn = &TestManyObjectsStayIntact,
+        .objectSize = sizeof(SlabTestData),
+        .objectsPerSlab = 7,
+    });
+    RunTestCase((SlabTestCase) {
+        .desc = "Re-use reset memory",
+        .testFn = &TestResetAndReuse,
+        .objectSize = sizeof(SlabTestData),
+        .objectsPerSlab = 10,
+    });
+    RunTestCase((SlabTestCase) {
+        .desc = "Release empty slabs",
+        .testFn = &TestEmptySlabsAreReleased,
+        .objectSize = sizeof(SlabTestData),
+        .objectsPerSlab = 2,
+    });
+}
@@ -0,0 +1,179 @@
+#include "tests.h"
+#include "memory.h"
+#include "stringops.h"
+
+typedef void (*StringOpsTestCaseFunc)(Allocator* allocator);
+
+typedef struct {
+    char* desc;
+    StringOpsTestCaseFunc testFn;
+} StringOpsTestCase;
+
+#define STRINGOPS_TEST_PAGE_SIZE 4096
+// not a multiple of any vector width, so that the remainder loops run too
+#define STRINGOPS_TEST_LENGTH 301
+#define STRINGOPS_TEST_MAX_NEEDLE 40
+
+// A small alphabet, so that needles have both partial and full matches.
+static void FillText(char* text, size_t length, uint32_t seed) {
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245 + 12345;
+        text[i] = "abc"[(seed >> 16) % 3];
+    }
+}
+
+static ptrdiff_t NaiveFind(String haystack, String needle, size_t start) {
+    for (size_t i = start; i + needle.length <= haystack.length; i++) {
+        if (memcmp(haystack.start + i, needle.start, needle.length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static size_t NaiveCount(String haystack, String needle) {
+    size_t count = 0;
+    for (ptrdiff_t i = NaiveFind(haystack, needle, 0); i >= 0; i = NaiveFind(haystack, needle, i + needle.length)) {
+        count++;
+    }
+    return count;
+}
+
+static void TestKernelsMatchNaiveSearch(Allocator* allocator) {
+    char text[STRINGOPS_TEST_LENGTH];
+    FillText(text, STRINGOPS_TEST_LENGTH, 42);
+    String haystack = { .start = text, .length = STRINGOPS_TEST_LENGTH };
+
+    for (StringKernelLevel level = STRING_KERNELS_SCALAR; level <= GetSupportedStringKernelLevel(); level++) {
+        SetStringKernelLevel(level);
+        // needles are taken from the text, so that they are found at different offsets
+        for (size_t length = 1; length <= STRINGOPS_TEST_MAX_NEEDLE; length++) {
+            for (size_t offset = 0; offset + length <= STRINGOPS_TEST_LENGTH; offset += 7) {
+                String needle = { .start = text + offset, .length = length };
+                for (size_t start = 0; start <= offset; start += 13) {
+                    Assertf(FindSubstring(haystack, needle, start) == NaiveFind(haystack, needle, start),
+                            "Unexpected match at kernel level %d", level);
+                }
+                Assertf(CountSubstring(haystack, needle) == NaiveCount(haystack, needle),
+                        "Unexpected count at kernel level %d", level);
+            }
+        }
+
+        String missing = { .start = "abcd", .length = 4 };
+        Assertf(FindSubstring(haystack, missing, 0) == -1, "Expected no match at kernel level %d", level);
+        Assertf(FindSubstring(haystack, haystack, 0) == 0, "Expected the whole text at kernel level %d", level);
+        Assertf(FindSubstring(haystack, MakeString(""), 5) == 5, "Expected the empty needle at kernel level %d", level);
+        Assertf(FindSubstring(haystack, MakeString("a"), STRINGOPS_TEST_LENGTH + 1) == -1,
+                "Expected no match past the end at kernel level %d", level);
+    }
+    SetStringKernelLevel(GetSupportedStringKernelLevel());
+}
+
+static int Sign(int n) {
+    return (n > 0) - (n < 0);
+}
+
+static void TestCompare(Allocator* allocator) {
+    char first[STRINGOPS_TEST_LENGTH];
+    char second[STRINGOPS_TEST_LENGTH];
+    FillText(first, STRINGOPS_TEST_LENGTH, 7);
+
+    for (StringKernelLevel level = STRING_KERNELS_SCALAR; level <= GetSupportedStringKernelLevel(); level++) {
+        SetStringKernelLevel(level);
+        // a single difference at every position
+        for (size_t i = 0; i < STRINGOPS_TEST_LENGTH; i++) {
+            memcpy(second, first, STRINGOPS_TEST_LENGTH);
+            second[i] = 'z';
+            String s1 = { .start = first, .length = STRINGOPS_TEST_LENGTH };
+            String s2 = { .start = second, .length = STRINGOPS_TEST_LENGTH };
+            Assertf(CompareStrings(s1, s2) < 0 && CompareStrings(s2, s1) > 0,
+                    "Unexpected order for a difference at %d at kernel level %d", i, level);
+            Assertf(CompareStrings(s1, s1) == 0, "Expected equal strings at kernel level %d", level);
+        }
+
+        String prefix = { .start = first, .length = STRINGOPS_TEST_LENGTH - 1 };
+        String whole = { .start = first, .length = STRINGOPS_TEST_LENGTH };
+        Assertf(CompareStrings(prefix, whole) < 0, "Expected a prefix first at kernel level %d", level);
+        // characters are compared as unsigned bytes, like memcmp
+        Assertf(Sign(CompareStrings(MakeString("\xff"), MakeString("a"))) == Sign(memcmp("\xff", "a", 1)),
+                "Expected unsigned characters at kernel level %d", level);
+    }
+    SetStringKernelLevel(GetSupportedStringKernelLevel());
+}
+
+static void AssertPart(Object* parts, size_t i, const char* expected) {
+    Value part = parts->as.vector.items[i];
+    Assertf(GetValueType(part) == VALUE_OBJECT && ValueAsObject(part)->type == OBJECT_STRING, "Expected part %d to be a string", i);
+    Assertf(StringEquals(GetStringChars(ValueAsObject(part), NULL), MakeString(expected)), "Unexpected part %d", i);
+}
+
+static void TestSplitAndJoin(Allocator* allocator) {
+    Object* str = CreateStringObject(MakeString("a,bb,,a part that is long enough to share,"), allocator);
+    Object* parts = SplitString(str, MakeString(","), allocator);
+
+    Assertf(parts->as.vector.count == 5, "Expected 5 parts, but received %d", parts->as.vector.count);
+    AssertPart(parts, 0, "a");
+    AssertPart(parts, 1, "bb");
+    AssertPart(parts, 2, "");
+    AssertPart(parts, 3, "a part that is long enough to share");
+    AssertPart(parts, 4, "");
+
+    // long parts are not copied
+    const char* chars = GetStringChars(str, NULL).start;
+    Assert(GetStringChars(ValueAsObject(parts->as.vector.items[3]), NULL).start == chars + 6,
+           "Expected the part to share the characters of the string");
+
+    Object* joined = JoinStrings(CreateStringObject(MakeString(","), allocator), parts->as.vector.items, parts->as.vector.count, allocator);
+    Assert(StringEquals(GetStringChars(joined, NULL), GetStringChars(str, NULL)), "Expected join to undo split");
+
+    Object* words = SplitString(str, MakeString(",,"), allocator);
+    Assertf(words->as.vector.count == 2, "Expected 2 parts, but received %d", words->as.vector.count);
+    AssertPart(words, 0, "a,bb");
+
+    Object* empty = SplitString(CreateStringObject(MakeString(""), allocator), MakeString(","), allocator);
+    Assertf(empty->as.vector.count == 1, "Expected 1 part, but received %d", empty->as.vector.count);
+    AssertPart(empty, 0, "");
+}
+
+static void TestSplitRope(Allocator* allocator) {
+    Object* left = CreateStringObject(MakeString("one two three "), allocator);
+    Object* right = CreateStringObject(MakeString("four five six seven"), allocator);
+    Object* rope = CreateConcatObject(left, right, allocator);
+
+    Object* parts = SplitString(rope, MakeString(" "), allocator);
+    Assertf(parts->as.vector.count == 7, "Expected 7 parts, but received %d", parts->as.vector.count);
+    AssertPart(parts, 3, "four");
+    AssertPart(parts, 6, "seven");
+}
+
+static void RunTestCase(StringOpsTestCase testCase) {
+    printf("%s\n", testCase.desc);
+
+    Allocator* allocator = CreateBumpAllocator(STRINGOPS_TEST_PAGE_SIZE, 1);
+    testCase.testFn(allocator);
+    AllocatorFree(allocator);
+}
+
+void StringOpsTests() {
+    PRINT_TEST_TITLE();
+
+    RunTestCase((StringOpsTestCase) {
+        .desc = "Kernels match a naive search",
+        .testFn = TestKernelsMatchNaiveSearch,
+    });
+
+    RunTestCase((StringOpsTestCase) {
+        .desc = "Compare",
+        .testFn = TestCompare,
+    });
+
+    RunTestCase((StringOpsTestCase) {
+        .desc = "Split and join",
+        .testFn = TestSplitAndJoin,
+    });
+
+    RunTestCase((StringOpsTestCase) {
+        .desc = "Split a rope",
+        .testFn = TestSplitRope,
+    });
+}
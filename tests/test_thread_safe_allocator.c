@@ -0,0 +1,212 @@
+#include <pthread.h>
+#include "tests.h"
+#include "memory.h"
+#include "da.h"
+#include "tokens.h"
+#include "parser.h"
+#include "bytecode.h"
+#include "vm.h"
+
+typedef struct {
+    int i;
+    double d;
+} ThreadTestData;
+
+typedef void (*ThreadSafeTestCaseFunc)();
+
+typedef struct {
+    char* desc;
+    ThreadSafeTestCaseFunc testFn;
+} ThreadSafeTestCase;
+
+#define THREAD_TEST_NUM_THREADS 4
+#define THREAD_TEST_NUM_OBJECTS 1000
+#define THREAD_TEST_PAGE_SIZE 256
+
+static Allocator* CreateTestArena(void* ctx) {
+    return CreateBumpAllocator(THREAD_TEST_PAGE_SIZE, 1);
+}
+
+static void TestAllocateAndFreeSingleThread(Allocator* allocator) {
+    ThreadTestData* s1 = AllocatorAlloc(sizeof(ThreadTestData), allocator);
+    *s1 = (ThreadTestData){ .i = 1, .d = 2.3 };
+    ThreadTestData* s2 = AllocatorAlloc(sizeof(ThreadTestData), allocator);
+    *s2 = (ThreadTestData){ .i = 4, .d = 5.6 };
+
+    Assert(s1->i == 1 && s1->d == 2.3, "Expected initial data to not be modified after second allocation.");
+
+    AllocatorFreeObject(s1, sizeof(ThreadTestData), allocator);
+    ThreadTestData* s3 = AllocatorAlloc(sizeof(ThreadTestData), allocator);
+    Assert(s1 == s3, "Expected freed object address to be re-used");
+}
+
+static void TestAllocateAligned(Allocator* allocator) {
+    AllocatorAlloc(1, allocator);
+    double* d = AllocatorAllocAligned(sizeof(double) * 8, 64, allocator);
+    Assertf((size_t)d % 64 == 0, "Expected 64 byte alignment, but the address was %ld.", (size_t)d);
+
+    AllocatorFreeObject(d, sizeof(double) * 8, allocator);
+}
+
+typedef struct {
+    Allocator* allocator;
+    int threadIndex;
+    ThreadTestData** objects;
+} ThreadTestArgs;
+
+static void* AllocateObjectsThread(void* arg) {
+    ThreadTestArgs* args = arg;
+    for (int i = 0; i < THREAD_TEST_NUM_OBJECTS; i++) {
+        ThreadTestData* s = AllocatorAlloc(sizeof(ThreadTestData), args->allocator);
+        *s = (ThreadTestData){ .i = i, .d = args->threadIndex };
+        args->objects[i] = s;
+    }
+    for (int i = 0; i < THREAD_TEST_NUM_OBJECTS; i++) {
+        ThreadTestData* s = args->objects[i];
+        Assertf(s->i == i && s->d == args->threadIndex,
+                "Expected object %d of thread %d to be intact", i, args->threadIndex);
+    }
+    return NULL;
+}
+
+static void* FreeObjectsThread(void* arg) {
+    ThreadTestArgs* args = arg;
+    for (int i = 0; i < THREAD_TEST_NUM_OBJECTS; i++) {
+        AllocatorFreeObject(args->objects[i], sizeof(ThreadTestData), args->allocator);
+    }
+    return NULL;
+}
+
+static void TestAllocateFromManyThreads(Allocator* allocator) {
+    pthread_t threads[THREAD_TEST_NUM_THREADS];
+    ThreadTestArgs args[THREAD_TEST_NUM_THREADS];
+    ThreadTestData* objects[THREAD_TEST_NUM_THREADS][THREAD_TEST_NUM_OBJECTS];
+
+    for (int i = 0; i < THREAD_TEST_NUM_THREADS; i++) {
+        args[i] = (ThreadTestArgs){ .allocator = allocator, .threadIndex = i, .objects = objects[i] };
+        pthread_create(&threads[i], NULL, &AllocateObjectsThread, &args[i]);
+    }
+    for (int i = 0; i < THREAD_TEST_NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    AllocatorStats stats = AllocatorGetStats(allocator);
+    size_t expectedAllocs = THREAD_TEST_NUM_THREADS * THREAD_TEST_NUM_OBJECTS;
+    Assertf(stats.numAllocs == expectedAllocs, "Expected %ld allocations, but received %ld", expectedAllocs, stats.numAllocs);
+}
+
+/*
+ * Objects are allocated by this thread and freed by another. The frees
+ * are queued up for this thread and recycled by its next allocations.
+ */
+static void TestFreeFromAnotherThread(Allocator* allocator) {
+    ThreadTestData* objects[THREAD_TEST_NUM_OBJECTS];
+    for (int i = 0; i < THREAD_TEST_NUM_OBJECTS; i++) {
+        objects[i] = AllocatorAlloc(sizeof(ThreadTestData), allocator);
+    }
+
+    pthread_t thread;
+    ThreadTestArgs args = { .allocator = allocator, .objects = objects };
+    pthread_create(&thread, NULL, &FreeObjectsThread, &args);
+    pthread_join(thread, NULL);
+
+    AllocatorStats before = AllocatorGetStats(allocator);
+    for (int i = 0; i < THREAD_TEST_NUM_OBJECTS; i++) {
+        AllocatorAlloc(sizeof(ThreadTestData), allocator);
+    }
+    AllocatorStats after = AllocatorGetStats(allocator);
+
+    Assertf(after.numFrees == THREAD_TEST_NUM_OBJECTS, "Expected %d recycled objects, but received %ld",
+            THREAD_TEST_NUM_OBJECTS, after.numFrees);
+    Assertf(before.numPages == after.numPages,
+            "Expected recycled objects to be re-used, but the pages grew from %ld to %ld",
+            before.numPages, after.numPages);
+}
+
+typedef struct {
+    Allocator* allocator;
+    char* input;
+    VmResult result;
+} PipelineTestArgs;
+
+static void* RunPipelineThread(void* arg) {
+    PipelineTestArgs* args = arg;
+
+    InitTokenizer(args->input);
+    TokenDa tokens = DA_MAKE_DEFAULT(Token);
+    Token token = {0};
+    do {
+        token = ConsumeToken();
+        DA_APPEND(&tokens, token);
+    } while (token.type != TOKEN_EOF && token.type != TOKEN_ERROR);
+
+    ParseResult parseResult = ParseTokens(tokens, args->allocator);
+    Assert(parseResult.type == RESULT_SUCCESS, "Failed to parse");
+
+    ByteCodeResult byteCodeResult = GenerateByteCode(parseResult.as.success.ast, args->allocator);
+    Assert(byteCodeResult.type == RESULT_SUCCESS, "Failed to generate bytecode");
+
+    ByteCodeGenerateSuccess byteCode = byteCodeResult.as.success;
+    args->result = ExecuteByteCode(byteCode.byteCode, byteCode.constants, args->allocator);
+    DA_FREE(&tokens);
+    return NULL;
+}
+
+static void TestRunPipelineFromManyThreads(Allocator* allocator) {
+    pthread_t threads[THREAD_TEST_NUM_THREADS];
+    PipelineTestArgs args[THREAD_TEST_NUM_THREADS];
+
+    for (int i = 0; i < THREAD_TEST_NUM_THREADS; i++) {
+        args[i] = (PipelineTestArgs){
+            .allocator = allocator,
+            .input = i % 2 == 0 ? "(* (+ 1 2) 3)" : "'(1 2)",
+        };
+        pthread_create(&threads[i], NULL, &RunPipelineThread, &args[i]);
+    }
+    for (int i = 0; i < THREAD_TEST_NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+
+        VmResult result = args[i].result;
+        Assertf(result.type == RESULT_SUCCESS && result.as.success.values.count == 1,
+                "Expected thread %d to succeed with one value", i);
+        Value value = result.as.success.values.items[0];
+        if (i % 2 == 0) {
+            Assertf(GetValueType(value) == VALUE_I32 && ValueAsI32(value) == 9, "Expected thread %d to compute 9", i);
+        } else {
+            Assertf(GetValueType(value) == VALUE_OBJECT && ValueAsObject(value)->type == OBJECT_CONS,
+                    "Expected thread %d to build a list", i);
+        }
+    }
+}
+
+static void RunTestCase(ThreadSafeTestCase testCase) {
+    printf("%s\n", testCase.desc);
+    Allocator* allocator = CreateThreadSafeAllocator(&CreateTestArena, NULL);
+    testCase.testFn(allocator);
+    AllocatorFree(allocator);
+}
+
+void ThreadSafeAllocatorTests() {
+    PRINT_TEST_TITLE();
+
+    RunTestCase((ThreadSafeTestCase) {
+        .desc = "Allocate and free in a single thread",
+        .testFn = &TestAllocateAndFreeSingleThread,
+    });
+    RunTestCase((ThreadSafeTestCase) {
+        .desc = "Explicit alignment",
+        .testFn = &TestAllocateAligned,
+    });
+    RunTestCase((ThreadSafeTestCase) {
+        .desc = "Allocate from many threads",
+        .testFn = &TestAllocateFromManyThreads,
+    });
+    RunTestCase((ThreadSafeTestCase) {
+        .desc = "Free from another thread",
+        .testFn = &TestFreeFromAnotherThread,
+    });
+    RunTestCase((ThreadSafeTestCase) {
+        .desc = "Parse, generate and execute from many threads",
+        .testFn = &TestRunPipelineFromManyThreads,
+    });
+}
@@ -131,6 +131,72 @@ void TokenizerTests() {
         .numExpected = 9,
     });
 
+    RunTestCase((TokenizerTestCase){
+        .desc = "Concatenate strings",
+        .input = "(concat \"a\" \"b\")",
+        .expected = (TokenType[]){
+            TOKEN_PAREN_START, TOKEN_CONCAT, TOKEN_STRING, TOKEN_STRING, TOKEN_PAREN_END
+        },
+        .numExpected = 5,
+    });
+
+    RunTestCase((TokenizerTestCase){
+        .desc = "Map and set keywords",
+        .input = "hashmap hashset assoc dissoc get contains conj hashmaps getter",
+        .expected = (TokenType[]){
+            TOKEN_HASHMAP, TOKEN_HASHSET, TOKEN_ASSOC, TOKEN_DISSOC, TOKEN_GET, TOKEN_CONTAINS, TOKEN_CONJ,
+            TOKEN_SYMBOL, TOKEN_SYMBOL
+        },
+        .numExpected = 9,
+    });
+
+    RunTestCase((TokenizerTestCase){
+        .desc = "Hash table keywords",
+        .input = "hashtable put remove count print",
+        .expected = (TokenType[]){
+            TOKEN_HASHTABLE, TOKEN_PUT, TOKEN_REMOVE, TOKEN_COUNT, TOKEN_PRINT
+        },
+        .numExpected = 5,
+    });
+
+    RunTestCase((TokenizerTestCase){
+        .desc = "Vector literal and keywords",
+        .input = "[1 [nth push slice vec tolist]]",
+        .expected = (TokenType[]){
+            TOKEN_BRACKET_START, TOKEN_NUMBER,
+            TOKEN_BRACKET_START, TOKEN_NTH, TOKEN_PUSH, TOKEN_SLICE, TOKEN_VEC, TOKEN_TOLIST, TOKEN_BRACKET_END,
+            TOKEN_BRACKET_END
+        },
+        .numExpected = 10,
+    });
+
+    RunTestCase((TokenizerTestCase){
+        .desc = "F64 array keywords",
+        .input = "f64array sum min max dot fun",
+        .expected = (TokenType[]){
+            TOKEN_F64ARRAY, TOKEN_SUM, TOKEN_MIN, TOKEN_MAX, TOKEN_DOT, TOKEN_FUN
+        },
+        .numExpected = 6,
+    });
+
+    RunTestCase((TokenizerTestCase){
+        .desc = "String keywords",
+        .input = "length find split join occurrences compare",
+        .expected = (TokenType[]){
+            TOKEN_LENGTH, TOKEN_FIND, TOKEN_SPLIT, TOKEN_JOIN, TOKEN_OCCURRENCES, TOKEN_COMPARE
+        },
+        .numExpected = 6,
+    });
+
+    RunTestCase((TokenizerTestCase){
+        .desc = "Lazy sequence keywords",
+        .input = "range iterate lines take map filter reduce",
+        .expected = (TokenType[]){
+            TOKEN_RANGE, TOKEN_ITERATE, TOKEN_LINES, TOKEN_TAKE, TOKEN_MAP, TOKEN_FILTER, TOKEN_REDUCE
+        },
+        .numExpected = 7,
+    });
+
     RunTestCase((TokenizerTestCase){
         .desc = "Function declaration",
         .input = "(defun (1) (2))",
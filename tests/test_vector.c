@@ -0,0 +1,91 @@
+#include "tests.h"
+#include "memory.h"
+#include "vector.h"
+
+typedef void (*VectorTestCaseFunc)(Allocator* allocator);
+
+typedef struct {
+    char* desc;
+    VectorTestCaseFunc testFn;
+} VectorTestCase;
+
+#define VECTOR_TEST_PAGE_SIZE 4096
+#define VECTOR_TEST_NUM_ITEMS 1000
+
+static void AssertItems(Object* vector, int32_t first, size_t count) {
+    Assertf(vector->as.vector.count == count, "Expected %ld items, but received %d", count, vector->as.vector.count);
+    for (size_t i = 0; i < count; i++) {
+        Value item = vector->as.vector.items[i];
+        Assertf(GetValueType(item) == VALUE_I32 && ValueAsI32(item) == first + (int32_t)i, "Unexpected item at %ld", i);
+    }
+}
+
+static void TestPush(Allocator* allocator) {
+    Object* vector = CreateVectorObject(NULL, 0, allocator);
+    for (int i = 0; i < VECTOR_TEST_NUM_ITEMS; i++) {
+        VectorPush(vector, MAKE_VALUE_I32(i), allocator);
+    }
+    AssertItems(vector, 0, VECTOR_TEST_NUM_ITEMS);
+    Assertf(vector->as.vector.capacity < 2 * VECTOR_TEST_NUM_ITEMS, "Unexpected capacity %d", vector->as.vector.capacity);
+}
+
+static void TestSlice(Allocator* allocator) {
+    Value items[] = { MAKE_VALUE_I32(0), MAKE_VALUE_I32(1), MAKE_VALUE_I32(2), MAKE_VALUE_I32(3) };
+    Object* vector = CreateVectorObject(items, 4, allocator);
+
+    Object* slice = CreateVectorSlice(vector, 1, 3, allocator);
+    AssertItems(slice, 1, 2);
+    AssertItems(CreateVectorSlice(vector, 2, 2, allocator), 0, 0);
+
+    // a slice is a copy
+    VectorPush(slice, MAKE_VALUE_I32(3), allocator);
+    AssertItems(slice, 1, 3);
+    AssertItems(vector, 0, 4);
+}
+
+static void TestLists(Allocator* allocator) {
+    Value items[] = { MAKE_VALUE_I32(0), MAKE_VALUE_I32(1), MAKE_VALUE_I32(2) };
+    Value list = MAKE_VALUE_OBJECT(CreateListObject(items, 3, MAKE_VALUE_NIL(), allocator));
+
+    Object* vector = CreateVectorFromList(list, allocator);
+    AssertItems(vector, 0, 3);
+
+    Value copy = VectorToList(vector, allocator);
+    Assertf(GetListLength(copy) == 3, "Expected 3 items, but received %ld", GetListLength(copy));
+    for (int i = 0; i < 3; i++) {
+        Assert(ValuesIdentical(ConsHead(ValueAsObject(copy)), items[i]), "Unexpected list item");
+        copy = ConsTail(ValueAsObject(copy));
+    }
+    Assert(GetValueType(copy) == VALUE_NIL, "Expected a proper list");
+
+    Object* empty = CreateVectorFromList(MAKE_VALUE_NIL(), allocator);
+    AssertItems(empty, 0, 0);
+    Assert(GetValueType(VectorToList(empty, allocator)) == VALUE_NIL, "Expected an empty vector to be nil");
+}
+
+static void RunTestCase(VectorTestCase testCase) {
+    printf("%s\n", testCase.desc);
+
+    Allocator* allocator = CreateBumpAllocator(VECTOR_TEST_PAGE_SIZE, 1);
+    testCase.testFn(allocator);
+    AllocatorFree(allocator);
+}
+
+void VectorTests() {
+    PRINT_TEST_TITLE();
+
+    RunTestCase((VectorTestCase) {
+        .desc = "Push",
+        .testFn = TestPush,
+    });
+
+    RunTestCase((VectorTestCase) {
+        .desc = "Slice",
+        .testFn = TestSlice,
+    });
+
+    RunTestCase((VectorTestCase) {
+        .desc = "To and from lists",
+        .testFn = TestLists,
+    });
+}
@@ -0,0 +1,219 @@
+#include "tests.h"
+#include "memory.h"
+
+typedef void (*VirtualArenaTestCaseFunc)();
+
+typedef struct {
+    char* desc;
+    VirtualArenaTestCaseFunc testFn;
+    size_t reserveBytes;
+    size_t commitBytes;
+    VirtualArenaFlags flags;
+} VirtualArenaTestCase;
+
+#define VIRTUAL_ARENA_TEST_KB 1024
+#define VIRTUAL_ARENA_TEST_MB (1024 * 1024)
+
+static void TestAllocateTwoBytesSequentially(Allocator* allocator) {
+    char* b1 = AllocatorAlloc(1, allocator);
+    *b1 = 'a';
+    char* b2 = AllocatorAlloc(1, allocator);
+    *b2 = 'b';
+
+    size_t diff = (b2 - b1) * sizeof(char);
+    Assertf(diff == sizeof(char), "Expected bytes to be sequential, but the diff was %ld bytes.", diff);
+    Assert(*b1 == 'a', "Expected initial data to not be modified after second allocation.");
+}
+
+static void TestCommitOnDemand(Allocator* allocator) {
+    // commit size 4 KB, allocate 1 MB in small pieces
+    char* first = AllocatorAlloc(100, allocator);
+    char* previous = first;
+    for (int i = 1; i < VIRTUAL_ARENA_TEST_MB / 100; i++) {
+        char* current = AllocatorAlloc(100, allocator);
+        Assertf(current == previous + 100, "Expected allocation %d to be contiguous with the previous one", i);
+        current[0] = 'a';
+        current[99] = 'b';
+        previous = current;
+    }
+}
+
+static void TestAllocateLargeObject(Allocator* allocator) {
+    // commit size 4 KB
+    char* large = AllocatorAlloc(VIRTUAL_ARENA_TEST_MB, allocator);
+    large[0] = 'a';
+    large[VIRTUAL_ARENA_TEST_MB - 1] = 'b';
+
+    char* next = AllocatorAlloc(1, allocator);
+    Assert(next == large + VIRTUAL_ARENA_TEST_MB, "Expected allocation after large object to be contiguous");
+}
+
+static void TestShouldNotExceedReservedRange(Allocator* allocator) {
+    // reserved 1 MB
+    SetAssertEnabledFromTest(false);
+    void* result = AllocatorAlloc(2 * VIRTUAL_ARENA_TEST_MB, allocator);
+    SetAssertEnabledFromTest(true);
+    Assert(result == NULL, "Cannot allocate more than the reserved range.");
+}
+
+static void TestFreedObjectIsReused(Allocator* allocator) {
+    double* d1 = AllocatorAlloc(sizeof(double), allocator);
+    AllocatorFreeObject(d1, sizeof(double), allocator);
+    double* d2 = AllocatorAlloc(sizeof(double), allocator);
+
+    Assert(d1 == d2, "Expected freed object address to be re-used");
+}
+
+static void TestResetAndReuse(Allocator* allocator) {
+    char* b1 = AllocatorAlloc(1, allocator);
+    char* b2 = AllocatorAlloc(1, allocator);
+
+    AllocatorReset(allocator);
+
+    char* b3 = AllocatorAlloc(1, allocator);
+    char* b4 = AllocatorAlloc(1, allocator);
+
+    Assert(b1 == b3, "Expected first byte address to be re-used");
+    Assert(b2 == b4, "Expected second byte address to be re-used");
+}
+
+static void TestReleaseMark(Allocator* allocator) {
+    char* b1 = AllocatorAlloc(1, allocator);
+    *b1 = 'a';
+
+    ArenaMark mark = AllocatorMark(allocator);
+    char* b2 = AllocatorAlloc(1, allocator);
+    AllocatorAlloc(VIRTUAL_ARENA_TEST_KB * 100, allocator);
+    AllocatorRelease(mark, allocator);
+
+    char* b3 = AllocatorAlloc(1, allocator);
+    Assert(b2 == b3, "Expected the memory after the mark to be re-used");
+    Assert(*b1 == 'a', "Expected the data before the mark to not be modified");
+}
+
+static void TestResetDecommitsTail(Allocator* allocator) {
+    // commit size 4 KB, decommit on reset
+    char* large = AllocatorAlloc(VIRTUAL_ARENA_TEST_MB, allocator);
+    large[VIRTUAL_ARENA_TEST_MB - 1] = 'a';
+
+    AllocatorReset(allocator);
+
+    char* again = AllocatorAlloc(VIRTUAL_ARENA_TEST_MB, allocator);
+    Assert(again == large, "Expected reset memory to be re-used");
+    // decommitted anonymous memory comes back zeroed
+    Assert(again[VIRTUAL_ARENA_TEST_MB - 1] == 0, "Expected decommitted memory to be zeroed");
+}
+
+static void TestStatsCommittedMemory(Allocator* allocator) {
+    // commit size 4 KB, decommit on reset
+    AllocatorAlloc(10 * VIRTUAL_ARENA_TEST_KB, allocator);
+
+    AllocatorStats stats = AllocatorGetStats(allocator);
+    Assertf(stats.bytesReserved == 12 * VIRTUAL_ARENA_TEST_KB, "Expected 12 KB to be committed, but received %ld", stats.bytesReserved);
+    Assertf(stats.numPages == 3, "Expected 3 commit steps, but received %ld", stats.numPages);
+
+    AllocatorReset(allocator);
+
+    stats = AllocatorGetStats(allocator);
+    Assertf(stats.bytesReserved == 4 * VIRTUAL_ARENA_TEST_KB, "Expected 4 KB to be committed, but received %ld", stats.bytesReserved);
+    Assertf(stats.highWaterMark == 12 * VIRTUAL_ARENA_TEST_KB, "Expected 12 KB high-water mark, but received %ld", stats.highWaterMark);
+}
+
+static void TestHugePages(Allocator* allocator) {
+    char* first = AllocatorAlloc(1, allocator);
+    Assert(((size_t)first % (2 * VIRTUAL_ARENA_TEST_MB)) == 0, "Expected arena to be aligned to the huge page size");
+
+    char* large = AllocatorAlloc(3 * VIRTUAL_ARENA_TEST_MB, allocator);
+    large[3 * VIRTUAL_ARENA_TEST_MB - 1] = 'a';
+}
+
+static void TestAllocateAligned(Allocator* allocator) {
+    char* b = AllocatorAlloc(1, allocator);
+    *b = 'a';
+    double* d = AllocatorAlloc(sizeof(double), allocator);
+    double* d64 = AllocatorAllocAligned(sizeof(double) * 8, 64, allocator);
+
+    Assertf((size_t)d % sizeof(double) == 0, "Expected double to be aligned, but the address was %ld.", (size_t)d);
+    Assertf((size_t)d64 % 64 == 0, "Expected 64 byte alignment, but the address was %ld.", (size_t)d64);
+}
+
+static void RunTestCase(VirtualArenaTestCase testCase) {
+    printf("%s\n", testCase.desc);
+    Allocator* allocator = CreateVirtualArenaAllocator(testCase.reserveBytes, testCase.commitBytes, testCase.flags);
+    testCase.testFn(allocator);
+    AllocatorFree(allocator);
+}
+
+void VirtualArenaAllocatorTests() {
+    PRINT_TEST_TITLE();
+
+    RunTestCase((VirtualArenaTestCase) {
+        .desc = "Two bytes sequentially",
+        .testFn = &TestAllocateTwoBytesSequentially,
+        .reserveBytes = VIRTUAL_ARENA_TEST_MB,
+        .commitBytes = 4 * VIRTUAL_ARENA_TEST_KB,
+    });
+    RunTestCase((VirtualArenaTestCase) {
+        .desc = "Commit memory on demand",
+        .testFn = &TestCommitOnDemand,
+        .reserveBytes = 2 * VIRTUAL_ARENA_TEST_MB,
+        .commitBytes = 4 * VIRTUAL_ARENA_TEST_KB,
+    });
+    RunTestCase((VirtualArenaTestCase) {
+        .desc = "Large object spanning several commits",
+        .testFn = &TestAllocateLargeObject,
+        .reserveBytes = 2 * VIRTUAL_ARENA_TEST_MB,
+        .commitBytes = 4 * VIRTUAL_ARENA_TEST_KB,
+    });
+    RunTestCase((VirtualArenaTestCase) {
+        .desc = "Fail to allocate more than the reserved range",
+        .testFn = &TestShouldNotExceedReservedRange,
+        .reserveBytes = VIRTUAL_ARENA_TEST_MB,
+        .commitBytes = 4 * VIRTUAL_ARENA_TEST_KB,
+    });
+    RunTestCase((VirtualArenaTestCase) {
+        .desc = "Re-use freed object",
+        .testFn = &TestFreedObjectIsReused,
+        .reserveBytes = VIRTUAL_ARENA_TEST_MB,
+        .commitBytes = 4 * VIRTUAL_ARENA_TEST_KB,
+    });
+    RunTestCase((VirtualArenaTestCase) {
+        .desc = "Re-use reset memory",
+        .testFn = &TestResetAndReuse,
+        .reserveBytes = VIRTUAL_ARENA_TEST_MB,
+        .commitBytes = 4 * VIRTUAL_ARENA_TEST_KB,
+    });
+    RunTestCase((VirtualArenaTestCase) {
+        .desc = "Decommit tail on reset",
+        .testFn = &TestResetDecommitsTail,
+        .reserveBytes = 2 * VIRTUAL_ARENA_TEST_MB,
+        .commitBytes = 4 * VIRTUAL_ARENA_TEST_KB,
+        .flags = VIRTUAL_ARENA_DECOMMIT_ON_RESET,
+    });
+    RunTestCase((VirtualArenaTestCase) {
+        .desc = "Release mark",
+        .testFn = &TestReleaseMark,
+        .reserveBytes = VIRTUAL_ARENA_TEST_MB,
+        .commitBytes = 4 * VIRTUAL_ARENA_TEST_KB,
+    });
+    RunTestCase((VirtualArenaTestCase) {
+        .desc = "Stats - committed memory",
+        .testFn = &TestStatsCommittedMemory,
+        .reserveBytes = VIRTUAL_ARENA_TEST_MB,
+        .commitBytes = 4 * VIRTUAL_ARENA_TEST_KB,
+        .flags = VIRTUAL_ARENA_DECOMMIT_ON_RESET,
+    });
+    RunTestCase((VirtualArenaTestCase) {
+        .desc = "Huge pages",
+        .testFn = &TestHugePages,
+        .reserveBytes = 4 * VIRTUAL_ARENA_TEST_MB,
+        .commitBytes = 2 * VIRTUAL_ARENA_TEST_MB,
+        .flags = VIRTUAL_ARENA_HUGE_PAGES,
+    });
+    RunTestCase((VirtualArenaTestCase) {
+        .desc = "Aligned allocations",
+        .testFn = &TestAllocateAligned,
+        .reserveBytes = VIRTUAL_ARENA_TEST_MB,
+        .commitBytes = 4 * VIRTUAL_ARENA_TEST_KB,
+    });
+}
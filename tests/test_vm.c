@@ -4,6 +4,8 @@
 #include "parser.h"
 #include "bytecode.h"
 #include "vm.h"
+#include "vector.h"
+#include "f64array.h"
 
 typedef struct {
     char* input;
@@ -16,6 +18,24 @@ typedef struct {
 
 static bool ValueEquals(Value first, Value second);
 
+// Compares the characters without flattening, since ropes may be compared to flat strings.
+static bool StringObjectEquals(Object* first, Object* second) {
+    size_t length = first->as.string.length;
+    if (length != second->as.string.length) {
+        return false;
+    }
+
+    char* chars1 = malloc(length);
+    char* chars2 = malloc(length);
+    CopyStringChars(first, chars1);
+    CopyStringChars(second, chars2);
+    bool result = memcmp(chars1, chars2, length) == 0;
+    free(chars1);
+    free(chars2);
+
+    return result;
+}
+
 static bool ObjectEquals(Object* first, Object* second) {
     if (first == second) {
         return true;
@@ -27,12 +47,33 @@ static bool ObjectEquals(Object* first, Object* second) {
 
     bool result = false;
     switch(first->type) {
+        case OBJECT_STRING:
+            result = StringObjectEquals(first, second);
+            break;
+        case OBJECT_SYMBOL:
+            // symbols are interned, so equal symbols are the same object
+            result = false;
+            break;
         case OBJECT_CONS: {
-            bool headEquals = ValueEquals(first->as.cons.head, second->as.cons.head);
-            bool tailEquals = ValueEquals(first->as.cons.tail, second->as.cons.tail);
+            bool headEquals = ValueEquals(ConsHead(first), ConsHead(second));
+            bool tailEquals = ValueEquals(ConsTail(first), ConsTail(second));
             result = headEquals && tailEquals;
             break;
         }
+        case OBJECT_VECTOR: {
+            result = first->as.vector.count == second->as.vector.count;
+            for (uint32_t i = 0; result && i < first->as.vector.count; i++) {
+                result = ValueEquals(first->as.vector.items[i], second->as.vector.items[i]);
+            }
+            break;
+        }
+        case OBJECT_F64_ARRAY: {
+            result = first->as.f64Array.count == second->as.f64Array.count;
+            for (uint32_t i = 0; result && i < first->as.f64Array.count; i++) {
+                result = first->as.f64Array.items[i] == second->as.f64Array.items[i];
+            }
+            break;
+        }
         default:
             AssertFail("Not implemented. Sorry.");
             break;
@@ -42,26 +83,29 @@ static bool ObjectEquals(Object* first, Object* second) {
 }
 
 static bool ValueEquals(Value first, Value second) {
-    if (first.type != second.type) {
+    if (GetValueType(first) != GetValueType(second)) {
         return false;
     }
 
     bool result = false;
-    switch (first.type) {
+    switch (GetValueType(first)) {
         case VALUE_NIL:
             result = true;
             break;
         case VALUE_F64:
-            result = first.as.f64 == second.as.f64;
+            result = ValueAsF64(first) == ValueAsF64(second);
+            break;
+        case VALUE_I32:
+            result = ValueAsI32(first) == ValueAsI32(second);
             break;
         case VALUE_BOOL:
-            result = first.as.boolValue == second.as.boolValue;
+            result = ValueAsBool(first) == ValueAsBool(second);
             break;
         case VALUE_OBJECT:
-            result = ObjectEquals(first.as.object, second.as.object);
+            result = ObjectEquals(ValueAsObject(first), ValueAsObject(second));
             break;
         case VALUE_OPERATOR:
-            result = first.as.operator == second.as.operator;
+            result = ValueAsOperator(first) == ValueAsOperator(second);
             break;
         default:
             break;
@@ -127,15 +171,20 @@ static void RunTestCase(VmTestCase testCase) {
 
     Assert(token.type != TOKEN_ERROR, "Failed to tokenize");
 
+    Allocator* compileAllocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
     Allocator* allocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
-    ParseResult parseResult = ParseTokens(tokens, allocator);
+    ParseResult parseResult = ParseTokens(tokens, compileAllocator);
 
     Assert(parseResult.type == RESULT_SUCCESS, "Failed to parse");
 
     ByteCodeResult byteCodeResult = GenerateByteCode(parseResult.as.success.ast, allocator);
     Assert(byteCodeResult.type == RESULT_SUCCESS, "Failed to generate bytecode");
 
-    VmResult result = ExecuteByteCode(byteCodeResult.as.success.byteCode, allocator);
+    // the program must not depend on the AST
+    AllocatorFree(compileAllocator);
+
+    ByteCodeGenerateSuccess byteCode = byteCodeResult.as.success;
+    VmResult result = ExecuteByteCode(byteCode.byteCode, byteCode.constants, allocator);
     if (!VmResultEquals(testCase.expected, result)) {
         PRINT_TEST_FAILURE();
         printf("Expected:\n");
@@ -150,6 +199,267 @@ static void RunTestCase(VmTestCase testCase) {
     DA_FREE(&tokens);
 }
 
+#define VM_TEST_NUM_RUNS 10
+
+static void TestRepeatedRunsReuseMemory() {
+    printf("Repeated runs reuse memory\n");
+
+    InitTokenizer("'(1 a \"b\" 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20)");
+    TokenDa tokens = DA_MAKE_CAPACITY(Token, VM_TEST_TOKEN_MAX);
+    Token token = {0};
+    do {
+        token = ConsumeToken();
+        DA_APPEND(&tokens, token);
+    } while (token.type != TOKEN_EOF && token.type != TOKEN_ERROR);
+
+    Allocator* compileAllocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
+    // the constants outlive the runs, so they can not be on the heap that is reset
+    Allocator* constantAllocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
+    Allocator* allocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
+    AllocatorSetRetention(4 * VM_TEST_PAGE_SIZE, allocator);
+
+    ParseResult parseResult = ParseTokens(tokens, compileAllocator);
+    Assert(parseResult.type == RESULT_SUCCESS, "Failed to parse");
+    ByteCodeResult byteCodeResult = GenerateByteCode(parseResult.as.success.ast, constantAllocator);
+    Assert(byteCodeResult.type == RESULT_SUCCESS, "Failed to generate bytecode");
+    ByteCodeGenerateSuccess byteCode = byteCodeResult.as.success;
+
+    // warm up
+    VmResult first = ExecuteByteCode(byteCode.byteCode, byteCode.constants, allocator);
+    Assert(first.type == RESULT_SUCCESS, "Failed to execute");
+    AllocatorStats warm = AllocatorGetStats(allocator);
+
+    // the list is a single block that does not fit in a page
+    Assert(warm.highWaterMark > VM_TEST_PAGE_SIZE, "Expected the program to need more than one page of memory");
+
+    for (int i = 0; i < VM_TEST_NUM_RUNS; i++) {
+        AllocatorReset(allocator);
+        AllocatorStats stats = AllocatorGetStats(allocator);
+        Assertf(stats.numPages == warm.numPages, "Expected the reset to keep %ld pages, but there are %ld",
+                warm.numPages, stats.numPages);
+
+        VmResult result = ExecuteByteCode(byteCode.byteCode, byteCode.constants, allocator);
+        Assert(result.type == RESULT_SUCCESS, "Failed to execute");
+        Assert(result.as.success.values.items == first.as.success.values.items,
+               "Expected the value stack to be re-used");
+
+        stats = AllocatorGetStats(allocator);
+        Assertf(stats.numPages == warm.numPages && stats.highWaterMark == warm.highWaterMark,
+                "Expected the warm pages to be re-used, but there are %ld pages instead of %ld",
+                stats.numPages, warm.numPages);
+    }
+
+    DA_FREE(&byteCode.byteCode);
+    DA_FREE(&byteCode.constants);
+    AllocatorFree(compileAllocator);
+    AllocatorFree(constantAllocator);
+    AllocatorFree(allocator);
+    DA_FREE(&tokens);
+}
+
+#define VM_TEST_NUM_PIECES 10000
+#define VM_TEST_PIECE "0123456789abcdefg"
+
+static void TestStringBuildingFlattensOnce() {
+    printf("String building flattens once\n");
+
+    Allocator* allocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
+    String piece = MakeString(VM_TEST_PIECE);
+
+    Object* str = CreateStringObject((String) { .start = "", .length = 0 }, allocator);
+    for (int i = 0; i < VM_TEST_NUM_PIECES; i++) {
+        str = CreateConcatObject(str, CreateStringObject(piece, allocator), allocator);
+    }
+    Assert(str->as.string.kind == STRING_ROPE, "Expected a rope");
+
+    size_t bytesBefore = AllocatorGetStats(allocator).bytesRequested;
+    String chars = GetStringChars(str, allocator);
+    size_t flattenBytes = AllocatorGetStats(allocator).bytesRequested - bytesBefore;
+
+    Assertf(chars.length == piece.length * VM_TEST_NUM_PIECES, "Unexpected length %ld", chars.length);
+    Assertf(flattenBytes == chars.length, "Expected one allocation of the string length, but %ld bytes were requested", flattenBytes);
+    for (int i = 0; i < VM_TEST_NUM_PIECES; i++) {
+        String current = { .start = chars.start + i * piece.length, .length = piece.length };
+        Assertf(StringEquals(current, piece), "Unexpected characters in piece %d", i);
+    }
+
+    String again = GetStringChars(str, allocator);
+    Assert(again.start == chars.start && str->as.string.kind == STRING_HEAP, "Expected the rope to be flattened in place");
+
+    AllocatorFree(allocator);
+}
+
+#define VM_TEST_LINE "a line that is long enough to be on the heap"
+#define VM_TEST_FEW_LINES 10
+#define VM_TEST_MANY_LINES 20000
+
+// Sums the line lengths of a file with the given number of lines, and returns the stats of the runtime heap.
+static AllocatorStats RunLineSum(int numLines) {
+    char path[] = "/tmp/parens_vm_lines_XXXXXX";
+    int fd = mkstemp(path);
+    Assert(fd >= 0, "Failed to create a temporary file");
+    FILE* file = fdopen(fd, "w");
+    for (int i = 0; i < numLines; i++) {
+        fprintf(file, "%s\n", VM_TEST_LINE);
+    }
+    fclose(file);
+
+    char input[128];
+    snprintf(input, sizeof(input), "(reduce + 0 (map length (lines \"%s\")))", path);
+    InitTokenizer(input);
+    TokenDa tokens = DA_MAKE_CAPACITY(Token, VM_TEST_TOKEN_MAX);
+    Token token = {0};
+    do {
+        token = ConsumeToken();
+        DA_APPEND(&tokens, token);
+    } while (token.type != TOKEN_EOF && token.type != TOKEN_ERROR);
+
+    Allocator* compileAllocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
+    Allocator* allocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
+    ParseResult parseResult = ParseTokens(tokens, compileAllocator);
+    Assert(parseResult.type == RESULT_SUCCESS, "Failed to parse");
+    ByteCodeResult byteCodeResult = GenerateByteCode(parseResult.as.success.ast, allocator);
+    Assert(byteCodeResult.type == RESULT_SUCCESS, "Failed to generate bytecode");
+    ByteCodeGenerateSuccess byteCode = byteCodeResult.as.success;
+
+    VmResult result = ExecuteByteCode(byteCode.byteCode, byteCode.constants, allocator);
+    Assert(result.type == RESULT_SUCCESS, "Failed to execute");
+    int32_t sum = ValueAsI32(result.as.success.values.items[0]);
+    Assertf(sum == numLines * (int32_t)strlen(VM_TEST_LINE), "Unexpected sum of line lengths %d", sum);
+    AllocatorStats stats = AllocatorGetStats(allocator);
+
+    remove(path);
+    DA_FREE(&byteCode.byteCode);
+    DA_FREE(&byteCode.constants);
+    AllocatorFree(compileAllocator);
+    AllocatorFree(allocator);
+    DA_FREE(&tokens);
+    return stats;
+}
+
+static void TestLazyLinesRunInConstantMemory() {
+    printf("Lazy lines run in constant memory\n");
+
+    AllocatorStats few = RunLineSum(VM_TEST_FEW_LINES);
+    AllocatorStats many = RunLineSum(VM_TEST_MANY_LINES);
+
+    // the file is far larger than the heap, which would hold every line if they were kept
+    Assertf(many.highWaterMark == few.highWaterMark && many.numPages == few.numPages,
+            "Expected the heap to stay at %ld bytes, but it grew to %ld bytes",
+            few.highWaterMark, many.highWaterMark);
+    Assertf(many.bytesInUse == few.bytesInUse, "Expected %ld bytes in use, but there are %ld",
+            few.bytesInUse, many.bytesInUse);
+}
+
+static ByteCodeGenerateSuccess GenerateHashConsed(char* input, Allocator* compileAllocator, Allocator* constantAllocator) {
+    InitTokenizer(input);
+    TokenDa tokens = DA_MAKE_CAPACITY(Token, VM_TEST_TOKEN_MAX);
+    Token token = {0};
+    do {
+        token = ConsumeToken();
+        DA_APPEND(&tokens, token);
+    } while (token.type != TOKEN_EOF && token.type != TOKEN_ERROR);
+
+    ParseResult parseResult = ParseTokens(tokens, compileAllocator);
+    Assert(parseResult.type == RESULT_SUCCESS, "Failed to parse");
+
+    SetHashConsing(true);
+    ByteCodeResult byteCodeResult = GenerateByteCode(parseResult.as.success.ast, constantAllocator);
+    SetHashConsing(false);
+    Assert(byteCodeResult.type == RESULT_SUCCESS, "Failed to generate bytecode");
+
+    DA_FREE(&tokens);
+    return byteCodeResult.as.success;
+}
+
+static void TestHashConsedQuotedData() {
+    printf("Hash-consed quoted data\n");
+
+    Allocator* compileAllocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
+    Allocator* constantAllocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
+    Allocator* allocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
+
+    // the arguments are emitted last to first, and the call is never run
+    ByteCodeGenerateSuccess byteCode = GenerateHashConsed(
+            "(1 '(\"abc\" 1 2) '(1 2) '(\"abc\" 1 2) \"abc\")", compileAllocator, constantAllocator);
+    Assertf(byteCode.constants.count == 4, "Expected 4 constants, but received %ld", byteCode.constants.count);
+    Object* str = ValueAsObject(byteCode.constants.items[0]);
+    Object* list = ValueAsObject(byteCode.constants.items[1]);
+    Object* suffix = ValueAsObject(byteCode.constants.items[2]);
+    Assert(list == ValueAsObject(byteCode.constants.items[3]), "Expected identical lists to be the same object");
+    Assert(ValuesIdentical(ConsHead(list), MAKE_VALUE_OBJECT(str)), "Expected identical strings to be the same object");
+    Assert(ValueAsObject(ConsTail(list)) == suffix, "Expected the list to share its suffix");
+    DA_FREE(&byteCode.byteCode);
+    DA_FREE(&byteCode.constants);
+
+    // the list is not rebuilt when the program runs
+    byteCode = GenerateHashConsed("'(1 2 3)", compileAllocator, constantAllocator);
+    size_t numAllocsBefore = AllocatorGetStats(allocator).numAllocs;
+    VmResult result = ExecuteByteCode(byteCode.byteCode, byteCode.constants, allocator);
+    Assert(result.type == RESULT_SUCCESS, "Failed to execute");
+    Assert(AllocatorGetStats(allocator).numAllocs == numAllocsBefore, "Expected no allocations on the runtime heap");
+    Assert(ValuesIdentical(result.as.success.values.items[0], byteCode.constants.items[0]),
+           "Expected the canonical list as the result");
+    Assertf(GetListLength(result.as.success.values.items[0]) == 3, "Expected 3 elements, but received %ld",
+            GetListLength(result.as.success.values.items[0]));
+
+    DA_FREE(&byteCode.byteCode);
+    DA_FREE(&byteCode.constants);
+    AllocatorFree(compileAllocator);
+    AllocatorFree(constantAllocator);
+    AllocatorFree(allocator);
+}
+
+static void TestListIsSingleBlock() {
+    printf("List is stored as a single block\n");
+
+    InitTokenizer("'(1 2 3 4 5)");
+    TokenDa tokens = DA_MAKE_CAPACITY(Token, VM_TEST_TOKEN_MAX);
+    Token token = {0};
+    do {
+        token = ConsumeToken();
+        DA_APPEND(&tokens, token);
+    } while (token.type != TOKEN_EOF && token.type != TOKEN_ERROR);
+
+    Allocator* compileAllocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
+    Allocator* allocator = CreateBumpAllocator(VM_TEST_PAGE_SIZE, 1);
+
+    ParseResult parseResult = ParseTokens(tokens, compileAllocator);
+    Assert(parseResult.type == RESULT_SUCCESS, "Failed to parse");
+    ByteCodeResult byteCodeResult = GenerateByteCode(parseResult.as.success.ast, allocator);
+    Assert(byteCodeResult.type == RESULT_SUCCESS, "Failed to generate bytecode");
+    ByteCodeGenerateSuccess byteCode = byteCodeResult.as.success;
+
+    size_t numAllocsBefore = AllocatorGetStats(allocator).numAllocs;
+    VmResult result = ExecuteByteCode(byteCode.byteCode, byteCode.constants, allocator);
+    Assert(result.type == RESULT_SUCCESS, "Failed to execute");
+    Assert(AllocatorGetStats(allocator).numAllocs == numAllocsBefore + 1, "Expected one allocation for the list");
+
+    Value list = result.as.success.values.items[0];
+    Assertf(GetListLength(list) == 5, "Expected 5 elements, but received %ld", GetListLength(list));
+
+    Object* cell = ValueAsObject(list);
+    for (int i = 1; i <= 5; i++) {
+        Assertf(ValueAsI32(ConsHead(cell)) == i, "Expected element %d", i);
+        // cells in a block can not be freed one by one
+        Assertf(cell->refCount > 0, "Expected cell %d to be pinned", i);
+        Value tail = ConsTail(cell);
+        if (i < 5) {
+            Assert(ValueAsObject(tail) == (Object*)((char*)cell + CONS_COMPACT_SIZE),
+                   "Expected the next cell right after the current one");
+            cell = ValueAsObject(tail);
+        } else {
+            Assert(GetValueType(tail) == VALUE_NIL, "Expected the list to end with nil");
+        }
+    }
+
+    DA_FREE(&byteCode.byteCode);
+    DA_FREE(&byteCode.constants);
+    AllocatorFree(compileAllocator);
+    AllocatorFree(allocator);
+    DA_FREE(&tokens);
+}
+
 static VmResult MakeSuccess(Value* values, size_t count) {
     ValueDa valueDa = (ValueDa) {
         .count = count,
@@ -165,12 +475,22 @@ static VmResult MakeSuccess(Value* values, size_t count) {
     return result;
 }
 
+static Value MakeF64Array(double* items, size_t count, Allocator* allocator) {
+    Object* array = CreateF64ArrayObject(count, allocator);
+    memcpy(array->as.f64Array.items, items, count * sizeof(double));
+    return MAKE_VALUE_OBJECT(array);
+}
+
 static Value* MakeValuePtr(Value val, ValueDa* values) {
     DA_APPEND(values, val);
     return &values->items[values->count - 1];
 }
 
 #define CONS(h, t) MAKE_VALUE_OBJECT(CreateConsCellObject(h, t, inputAllocator))
+#define SYMBOL(cs) MAKE_VALUE_OBJECT(InternSymbol(MakeString(cs)))
+#define STRING(cs) MAKE_VALUE_OBJECT(CreateStringObject(MakeString(cs), inputAllocator))
+#define VECTOR(count, ...) MAKE_VALUE_OBJECT(CreateVectorObject((Value[]) { __VA_ARGS__ }, count, inputAllocator))
+#define F64_ARRAY(count, ...) MakeF64Array((double[]) { __VA_ARGS__ }, count, inputAllocator)
 
 void VmTests() {
     PRINT_TEST_TITLE();
@@ -187,13 +507,37 @@ void VmTests() {
    RunTestCase((VmTestCase) {
        .desc = "Only number",
        .input = "1",
-       .expected = MakeSuccess((Value[]) { MAKE_VALUE_F64(1) }, 1),
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(1) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Only decimal number",
+       .input = "1.5",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_F64(1.5) }, 1),
    });
 
    RunTestCase((VmTestCase) {
        .desc = "Simple add",
        .input = "(+ 1 2)",
-       .expected = MakeSuccess((Value[]) { MAKE_VALUE_F64(3) }, 1),
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(3) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Mixed integer and decimal add",
+       .input = "(+ 1 0.5)",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_F64(1.5) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Integer overflow promotes to decimal",
+       .input = "(* 100000 100000)",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_F64(1e10) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Integer subtract",
+       .input = "(- 3 4)",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(-1) }, 1),
    });
 
    RunTestCase((VmTestCase) {
@@ -207,15 +551,344 @@ void VmTests() {
        .input = "'(1 2)",
        .expected = MakeSuccess((Value[]) {
                CONS(
-                    MAKE_VALUE_F64(1),
+                    MAKE_VALUE_I32(1),
+                    CONS(
+                         MAKE_VALUE_I32(2),
+                         MAKE_VALUE_NIL()
+                    )
+               )
+           }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Dotted list",
+       .input = "'(1 . (2 . 3))",
+       .expected = MakeSuccess((Value[]) {
+               CONS(
+                    MAKE_VALUE_I32(1),
+                    CONS(
+                         MAKE_VALUE_I32(2),
+                         MAKE_VALUE_I32(3)
+                    )
+               )
+           }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Quoted symbol",
+       .input = "'abc",
+       .expected = MakeSuccess((Value[]) { SYMBOL("abc") }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "List with constants",
+       .input = "'(a \"b\")",
+       .expected = MakeSuccess((Value[]) {
+               CONS(
+                    SYMBOL("a"),
                     CONS(
-                         MAKE_VALUE_F64(2),
+                         STRING("b"),
                          MAKE_VALUE_NIL()
                     )
                )
            }, 1),
    });
 
+   RunTestCase((VmTestCase) {
+       .desc = "Concatenate short strings",
+       .input = "(concat \"ab\" \"cd\")",
+       .expected = MakeSuccess((Value[]) { STRING("abcd") }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Concatenate long strings",
+       .input = "(concat (concat \"a string that is \" \"too long to be small, \") \"so it is a rope\")",
+       .expected = MakeSuccess((Value[]) { STRING("a string that is too long to be small, so it is a rope") }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Concatenate non-string",
+       .input = "(concat \"a\" 1)",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Map lookup",
+       .input = "(get (hashmap '(1 \"one\" 2 \"two\")) 2)",
+       .expected = MakeSuccess((Value[]) { STRING("two") }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Map lookup of missing key",
+       .input = "(get (dissoc (assoc (hashmap ()) 1 2) 1) 1)",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_NIL() }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Strings are keys by value",
+       .input = "(get (assoc (hashmap ()) (concat \"a\" \"b\") 1) \"ab\")",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(1) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Set membership",
+       .input = "(contains (conj (hashset '(a b)) 'c) 'b)",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_BOOL(true) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Hash table lookup",
+       .input = "(get (put (put (hashtable) \"a\" 1) 'b 2) \"a\")",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(1) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Hash table count",
+       .input = "(count (put (put (put (hashtable) 1 1) 2 2) 1 3))",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(2) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Hash table remove",
+       .input = "(remove (put (hashtable) 1 1) 1)",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_BOOL(true) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Hash table with list key",
+       .input = "(put (hashtable) '(1) 1)",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Vector literal",
+       .input = "[1 (+ 1 1) \"three\"]",
+       .expected = MakeSuccess((Value[]) { VECTOR(3, MAKE_VALUE_I32(1), MAKE_VALUE_I32(2), STRING("three")) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Quoted vector literal",
+       .input = "'[a (1 2)]",
+       .expected = MakeSuccess((Value[]) {
+               VECTOR(2, SYMBOL("a"), CONS(MAKE_VALUE_I32(1), CONS(MAKE_VALUE_I32(2), MAKE_VALUE_NIL())))
+           }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Vector index",
+       .input = "(nth [10 20 30] 2)",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(30) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Vector index out of bounds",
+       .input = "(nth [10 20 30] 3)",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Vector push and count",
+       .input = "(count (push (push (push (push (push [] 1) 2) 3) 4) 5))",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(5) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Vector slice",
+       .input = "(slice [1 2 3 4] 1 3)",
+       .expected = MakeSuccess((Value[]) { VECTOR(2, MAKE_VALUE_I32(2), MAKE_VALUE_I32(3)) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Vector to and from list",
+       .input = "(tolist (vec '(1 2)))",
+       .expected = MakeSuccess((Value[]) {
+               CONS(MAKE_VALUE_I32(1), CONS(MAKE_VALUE_I32(2), MAKE_VALUE_NIL()))
+           }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "F64 array from vector",
+       .input = "(f64array [1 2.5 3])",
+       .expected = MakeSuccess((Value[]) { F64_ARRAY(3, 1, 2.5, 3) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "F64 array from list of non-numbers",
+       .input = "(f64array '(1 a))",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "F64 array arithmetic",
+       .input = "(- (* (f64array '(1 2 3)) (f64array [4 5 6])) 1)",
+       .expected = MakeSuccess((Value[]) { F64_ARRAY(3, 3, 9, 17) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "F64 array scalar as first operand",
+       .input = "(/ 6 (f64array '(1 2 3)))",
+       .expected = MakeSuccess((Value[]) { F64_ARRAY(3, 6, 3, 2) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "F64 array length mismatch",
+       .input = "(+ (f64array '(1 2)) (f64array '(1 2 3)))",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "F64 array sum",
+       .input = "(sum (* (f64array '(1 2 3)) 2))",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_F64(12) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "F64 array min and max",
+       .input = "(- (max (f64array [3 0.5 2])) (min (f64array [3 0.5 2])))",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_F64(2.5) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "F64 array dot product",
+       .input = "(dot (f64array [1 2]) (f64array [3 4]))",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_F64(11) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "F64 array min of empty array",
+       .input = "(min (f64array []))",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "F64 array index and count",
+       .input = "(+ (nth (f64array [1 2 3]) 1) (count (f64array [1 2 3])))",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_F64(5) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "String length",
+       .input = "(length (concat \"a string that is long \" \"enough to be a rope\"))",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(41) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Find substring",
+       .input = "(find \"the quick brown fox jumps over the lazy dog\" \"lazy\")",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(35) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Find missing substring",
+       .input = "(find \"the quick brown fox\" \"dog\")",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_NIL() }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Count occurrences",
+       .input = "(occurrences \"banana\" \"a\")",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(3) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Split string",
+       .input = "(split \"a, b, c\" \", \")",
+       .expected = MakeSuccess((Value[]) { VECTOR(3, STRING("a"), STRING("b"), STRING("c")) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Split with empty delimiter",
+       .input = "(split \"abc\" \"\")",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Join strings",
+       .input = "(join \"-\" (split \"a b c\" \" \"))",
+       .expected = MakeSuccess((Value[]) { STRING("a-b-c") }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Join list of strings",
+       .input = "(join \"\" '(\"x\" \"y\"))",
+       .expected = MakeSuccess((Value[]) { STRING("xy") }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Join non-strings",
+       .input = "(join \", \" [1 2])",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Compare strings",
+       .input = "(compare \"apple\" \"banana\")",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(-1) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Reduce a range",
+       .input = "(reduce + 0 (range 0 10))",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(45) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Take from an infinite sequence",
+       .input = "(tolist (take 4 (iterate (hashmap '(1 2 2 3 3 1)) 1)))",
+       .expected = MakeSuccess((Value[]) { CONS(MAKE_VALUE_I32(1), CONS(MAKE_VALUE_I32(2), CONS(MAKE_VALUE_I32(3), CONS(MAKE_VALUE_I32(1), MAKE_VALUE_NIL())))) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Filter by a set",
+       .input = "(vec (filter (hashset '(2 4 12)) (range 0 10)))",
+       .expected = MakeSuccess((Value[]) { VECTOR(2, MAKE_VALUE_I32(2), MAKE_VALUE_I32(4)) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Map a builtin over a vector",
+       .input = "(reduce + 0 (map length (split \"one two three\" \" \")))",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_I32(11) }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Empty sequence as a list",
+       .input = "(tolist (take 0 (range 0 10)))",
+       .expected = MakeSuccess((Value[]) { MAKE_VALUE_NIL() }, 1),
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Map with wrong arity",
+       .input = "(tolist (map + (range 0 3)))",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Error in a mapped function",
+       .input = "(reduce + 0 (map length (range 0 3)))",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Lines of a missing file",
+       .input = "(tolist (lines \"/nonexistent/parens\"))",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   RunTestCase((VmTestCase) {
+       .desc = "Map from odd list",
+       .input = "(hashmap '(1 2 3))",
+       .expected = { .type = RESULT_ERROR },
+   });
+
+   TestStringBuildingFlattensOnce();
+   TestLazyLinesRunInConstantMemory();
+   TestListIsSingleBlock();
+   TestHashConsedQuotedData();
+   TestRepeatedRunsReuseMemory();
 }
 
 #undef CONS
+#undef SYMBOL
+#undef STRING
+#undef VECTOR
+#undef F64_ARRAY
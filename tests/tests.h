@@ -7,6 +7,15 @@
 
 void DynamicArrayTests();
 void BumpAllocatorTests();
+void SlabAllocatorTests();
+void VirtualArenaAllocatorTests();
+void ThreadSafeAllocatorTests();
+void HamtTests();
+void HashTableTests();
+void VectorTests();
+void F64ArrayTests();
+void StringOpsTests();
+void LazySeqTests();
 void TokenizerTests();
 void ParserTests();
 void BytecodeGeneratorTests();